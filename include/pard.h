@@ -24,6 +24,29 @@ typedef enum {
     PARD_PHASE_CLEANUP = -1      /* 清理 */
 } pard_phase_t;
 
+/* 重排序方法（对应Pardiso的iparm[1]） */
+typedef enum {
+    PARD_ORDERING_AMD = 0,       /* 近似最小度（默认） */
+    PARD_ORDERING_NATURAL = 1,   /* 自然顺序，不重排 */
+    PARD_ORDERING_ND = 2,        /* 多层嵌套剖分 */
+    PARD_ORDERING_RCM = 3,       /* 逆Cuthill-McKee */
+    PARD_ORDERING_USER = 4,      /* 用户给定置换 */
+    PARD_ORDERING_AUTO = 5       /* 按符号填充估计自动选择（分解运算量最小者） */
+} pard_ordering_t;
+
+/* 消元树的模式 */
+typedef enum {
+    PARD_ETREE_SYMMETRIC = 0,    /* A+A^T 的消元树 */
+    PARD_ETREE_ATA = 1           /* A^T*A 的消元树（列消元树） */
+} pard_etree_mode_t;
+
+/* 迭代精化方法（pardiso_refine） */
+typedef enum {
+    PARD_REFINE_RICHARDSON = 0,  /* 经典残差修正（默认） */
+    PARD_REFINE_FGMRES = 1,      /* 以分解因子为预条件子的柔性GMRES */
+    PARD_REFINE_PCG = 2          /* 预条件共轭梯度（仅对称正定，其他类型改用FGMRES） */
+} pard_refinement_t;
+
 /* CSR矩阵结构 */
 typedef struct {
     int n;              /* 矩阵维度 */
@@ -33,25 +56,84 @@ typedef struct {
     double *values;     /* 数值数组，长度为nnz */
     int is_symmetric;   /* 是否为对称矩阵 */
     int is_upper;       /* 如果对称，是否只存储上三角 */
+    void *mapping;      /* 非NULL时三个数组指向二进制文件的映射区（零拷贝读入），释放时解除映射 */
+    size_t mapping_size;
 } pard_csr_matrix_t;
 
-/* 分解因子结构 */
+/* 二进制CSR文件的读入方式，可按位组合 */
+typedef enum {
+    PARD_BIN_COPY = 0,    /* 读入到新分配的数组 */
+    PARD_BIN_MMAP = 1,    /* 映射文件，CSR数组直接指向映射区，不复制 */
+    PARD_BIN_VERIFY = 2   /* 文件带校验和时校验数据区 */
+} pard_bin_mode_t;
+
+/* 外存因子的临时文件与后台读写线程（src/core/out_of_core.c） */
+typedef struct pard_ooc pard_ooc_t;
+
+/* 超节点因子面板：多波前分解中一个波前消去后的稠密块，行列号为重排后矩阵的编号 */
+typedef struct {
+    int m;              /* 面板行数 */
+    int k;              /* 主元数 */
+    int parent;         /* 超节点消元树中的父面板，根为-1 */
+    int *rows;          /* 行索引，前k个为主元行 */
+    int *cols;          /* 列索引，前k个为主元列（LU；对称情形为NULL，与rows相同） */
+    double *L;          /* m×k 列主序：Cholesky为含对角的L，LU/LDL^T为单位L（对角不使用） */
+    double *U;          /* k×m 列主序，LU的U11与U12（对称情形为NULL） */
+    float *Lf;          /* 混合精度模式下单精度保存的L、U（此时L、U为NULL） */
+    float *Uf;
+    int *piv;           /* LDL^T的主元类型，1或2 */
+    double *d;          /* LDL^T的D：d[t]为对角元，d[k+t] = D(t+1,t)（仅2x2块的第一列非零） */
+} pard_panel_t;
+
+/* 分解因子结构
+ * 符号分解生成L、U的CSR结构；数值分解的结果保存在超节点面板中，求解只使用面板。
+ * 调用pardiso_set_csr_factors后数值分解另把面板导出为CSR因子（P*A*Q = L*U，LDL^T为P*A*P^T = L*D*L^T，
+ * 行列按主元顺序编号），取代符号分解的结构数组；否则l_values、u_values与D的数组为NULL */
 typedef struct {
     int n;              /* 矩阵维度 */
     int nnz;            /* 非零元素个数 */
     int *row_ptr;       /* L的行指针 */
     int *col_idx;       /* L的列索引 */
-    double *l_values;   /* L的数值 */
+    double *l_values;   /* L的数值（单位下三角，含对角元1；未导出时为NULL） */
     
     /* 对于LU分解 */
     int *u_row_ptr;     /* U的行指针 */
     int *u_col_idx;     /* U的列索引 */
-    double *u_values;   /* U的数值 */
-    int *perm;          /* 行置换数组 */
+    double *u_values;   /* U的数值（Cholesky为D*L^T，D = diag(L)；未导出时为NULL） */
+    int *perm;          /* 主元顺序：第t个主元为重排后矩阵的第perm[t]行（数值分解后） */
+    int *col_perm;      /* 第t个主元列（LU分解，NULL表示与perm相同） */
     
-    /* 对于LDL^T分解 */
+    /* 对于LDL^T分解（CSR导出时生成，此时U的数组为NULL） */
     double *d_values;   /* D的对角元素 */
-    int *pivot_type;    /* 主元类型：1表示1x1，2表示2x2 */
+    double *d_offdiag;  /* 2x2块的非对角元素：d_offdiag[i] = D(i+1,i)（i为块的第一行，否则为0） */
+    int *pivot_type;    /* 主元类型：1表示1x1，2表示2x2（块的两行都为2） */
+    
+    /* 超节点结构（符号分解生成，基于置换后矩阵的 A+A^T） */
+    int nsuper;         /* 超节点个数 */
+    int *super_ptr;     /* 第s个超节点包含列[super_ptr[s], super_ptr[s+1])，长度nsuper+1 */
+    int *super_parent;  /* 超节点消元树，根为-1 */
+    int *super_row_ptr; /* 超节点自身列以下的行结构，长度nsuper+1 */
+    int *super_row_idx; /* 行号递增 */
+    
+    /* 超节点面板（数值分解生成，按超节点顺序，供分块求解使用） */
+    int npanels;
+    pard_panel_t *panels;
+    int *row_panel;     /* 行号 -> 以该行为主元行的面板 */
+    int *col_panel;     /* 列号 -> 以该列为主元列的面板（LU；对称情形为NULL，与row_panel相同） */
+    
+    /* 并行求解调度（pard_solve_schedule生成，panel_owner为NULL时顺序求解） */
+    int sched_nthreads; /* 生成调度时的线程数 */
+    int *panel_owner;   /* 面板所属线程，-1为顶层面板（顺序处理） */
+    int ntop_rows;      /* 顶层面板的主元行数 */
+    int *top_row_index; /* 行号 -> 顶层面板主元行的编号，其余为-1 */
+    int *top_col_index; /* 列号 -> 顶层面板主元列的编号（LU；对称情形为NULL） */
+    
+    int single_precision; /* 面板以单精度保存（混合精度模式） */
+    pard_ooc_t *ooc;      /* 非NULL时面板的L、U在外存临时文件中（面板上为NULL） */
+    
+    /* 非NULL时因子数组指向pardiso_load映射的状态文件，重新分解前转为自有内存 */
+    void *mapping;
+    size_t mapping_size;
     
     pard_matrix_type_t matrix_type;
 } pard_factors_t;
@@ -59,11 +141,55 @@ typedef struct {
 /* 求解器句柄 */
 typedef struct {
     pard_csr_matrix_t *matrix;      /* 原始矩阵（已重排序） */
+    int owns_matrix;                 /* matrix由pardiso_load创建，随求解器释放 */
     int *perm;                       /* 行置换数组 */
     int *inv_perm;                   /* 逆置换数组 */
     pard_factors_t *factors;         /* 分解因子 */
     pard_matrix_type_t matrix_type;  /* 矩阵类型 */
     
+    /* 重排序选项 */
+    pard_ordering_t ordering;        /* 请求的重排序方法 */
+    pard_ordering_t ordering_used;   /* 实际采用的方法（AUTO时为选中者） */
+    int *user_perm;                  /* 用户置换（PARD_ORDERING_USER，user_perm[new] = old） */
+    int user_perm_n;                 /* user_perm的长度 */
+    
+    /* 数值重分解：原始排列中第p个元素在重排后矩阵中的位置 */
+    int *value_map;
+    int value_map_nnz;               /* value_map的长度（原始矩阵的非零元数） */
+    
+    /* 超节点松弛合并参数 */
+    int relax_max_cols;              /* 合并后超节点的最大列数（<= 1 只用基本超节点） */
+    double relax_max_zeros;          /* 允许的显式零元比例 */
+    
+    /* 共享内存并行 */
+    int num_threads;                 /* 数值分解的线程数（<= 0 为自动） */
+    
+    /* 混合精度：单精度保存因子，双精度迭代精化（精化停滞时自动改回双精度）。
+     * 波前仍以双精度计算，完成后才舍入，只减少因子内存与求解的访存量，不减少分解运算时间 */
+    int mixed_precision;
+    
+    /* 数值分解后把面板另外导出为CSR因子（factors->l_values等） */
+    int csr_factors;
+    
+    /* 外存因子：面板写入临时文件，求解时按遍历顺序预取（ooc_dir为NULL时关闭） */
+    char *ooc_dir;                   /* 临时文件所在目录 */
+    size_t ooc_memory_limit;         /* 常驻面板数值的字节数上限 */
+    
+    /* 迭代精化 */
+    pard_refinement_t refine_method; /* 精化方法 */
+    int refine_restart;              /* FGMRES的重启长度（<= 0 为默认值） */
+    int refine_iterations;           /* 上次精化各右端项预条件求解次数的最大值 */
+    double refine_berr;              /* 上次精化后各右端项范数后向误差的最大值 */
+    
+    /* 求解工作区：数值分解后按work_max_nrhs一次分配，求解与迭代精化复用，不再逐次分配 */
+    int work_max_nrhs;               /* 工作区容纳的最大右端项数（<= 0 为1） */
+    double *solve_work;              /* 三角求解的临时向量 */
+    size_t solve_work_size;          /* solve_work的长度（double个数） */
+    double *refine_work;             /* 迭代精化的临时向量 */
+    size_t refine_work_size;         /* refine_work的长度（double个数） */
+    int *solve_iwork;                /* 稀疏右端项求解的面板标记与栈（标记在两次求解之间保持为0） */
+    size_t solve_iwork_size;         /* solve_iwork的长度（int个数） */
+    
     /* MPI相关 */
     MPI_Comm comm;                   /* MPI通信器 */
     int mpi_rank;                    /* MPI进程号 */
@@ -71,11 +197,16 @@ typedef struct {
     int is_parallel;                 /* 是否使用MPI并行 */
     
     /* 统计信息 */
-    double analysis_time;            /* 符号分析时间 */
+    double analysis_time;            /* 符号分析时间（墙钟时间，秒，下同） */
     double factorization_time;       /* 数值分解时间 */
     double solve_time;                /* 求解时间 */
-    size_t peak_memory;              /* 峰值内存使用 */
-    int fill_in_nnz;                 /* Fill-in后的非零元素数 */
+    
+    /* 符号分析给出的预测（pard_symbolic_estimate，按pardiso_symbolic时的设置，不考虑主元推迟） */
+    size_t peak_memory;              /* 数值分解的峰值工作内存（字节）：因子、波前与贡献块栈 */
+    int fill_in_nnz;                 /* Fill-in后的非零元素数（同factor_nnz，超出int时为INT_MAX） */
+    long long factor_nnz;            /* 因子的精确非零元数：L（含对角），LU另加U */
+    double factor_flops;             /* 数值分解的浮点运算数 */
+    double solve_flops;              /* 每个右端项的求解（前代与回代）浮点运算数 */
 } pard_solver_t;
 
 /* 错误代码 */
@@ -89,11 +220,28 @@ typedef enum {
 
 /* 主API函数 */
 int pardiso_init(pard_solver_t **solver, pard_matrix_type_t mtype, MPI_Comm comm);
+int pardiso_set_ordering(pard_solver_t *solver, pard_ordering_t ordering,
+                         int n, const int *user_perm);
+int pardiso_set_supernode_relaxation(pard_solver_t *solver, int max_cols, double max_zeros);
+int pardiso_set_num_threads(pard_solver_t *solver, int num_threads);
+int pardiso_set_mixed_precision(pard_solver_t *solver, int enable);
+int pardiso_set_csr_factors(pard_solver_t *solver, int enable);
+int pardiso_set_out_of_core(pard_solver_t *solver, const char *scratch_dir, size_t memory_limit);
+int pardiso_set_refinement(pard_solver_t *solver, pard_refinement_t method, int restart);
+int pardiso_set_max_nrhs(pard_solver_t *solver, int max_nrhs);
+int pardiso_get_workspace_size(const pard_solver_t *solver, int nrhs, size_t *bytes);
 int pardiso_symbolic(pard_solver_t *solver, pard_csr_matrix_t *matrix);
 int pardiso_factor(pard_solver_t *solver);
+int pardiso_refactor(pard_solver_t *solver, const double *values);
 int pardiso_solve(pard_solver_t *solver, int nrhs, double *rhs, double *sol);
+int pardiso_solve_transpose(pard_solver_t *solver, int nrhs, double *rhs, double *sol);
+int pardiso_solve_sparse(pard_solver_t *solver, int rhs_nnz, const int *rhs_idx,
+                         const double *rhs_val, int nout, const int *out_idx,
+                         double *out_val);
 int pardiso_refine(pard_solver_t *solver, int nrhs, double *rhs, double *sol, 
                    int max_iter, double tol);
+int pardiso_save(const pard_solver_t *solver, const char *filename);
+int pardiso_load(pard_solver_t **solver, const char *filename, MPI_Comm comm, int mode);
 int pardiso_cleanup(pard_solver_t **solver);
 
 /* CSR矩阵操作 */
@@ -103,24 +251,37 @@ int pard_csr_copy(pard_csr_matrix_t *dst, const pard_csr_matrix_t *src);
 int pard_csr_transpose(pard_csr_matrix_t *dst, const pard_csr_matrix_t *src);
 int pard_csr_multiply(pard_csr_matrix_t *C, const pard_csr_matrix_t *A, 
                       const pard_csr_matrix_t *B);
+int pard_csr_spmm(const pard_csr_matrix_t *A, int nrhs, double alpha, const double *X,
+                  double beta, double *Y, double *work, int nthreads);
 
 /* 矩阵工具函数 */
 int pard_matrix_read_mtx(pard_csr_matrix_t **matrix, const char *filename);
 int pard_matrix_write_mtx(const pard_csr_matrix_t *matrix, const char *filename);
+int pard_matrix_read_bin(pard_csr_matrix_t **matrix, const char *filename, int mode);
+int pard_matrix_write_bin(const pard_csr_matrix_t *matrix, const char *filename, int checksum);
 int pard_matrix_print_info(const pard_csr_matrix_t *matrix);
 int pard_matrix_verify_symmetric(const pard_csr_matrix_t *matrix, double tol);
 
 /* 重排序函数 */
 int pard_minimum_degree(const pard_csr_matrix_t *matrix, int **perm, int **inv_perm);
 int pard_nested_dissection(const pard_csr_matrix_t *matrix, int **perm, int **inv_perm);
+int pard_rcm(const pard_csr_matrix_t *matrix, int **perm, int **inv_perm);
+int pard_compute_ordering(const pard_csr_matrix_t *matrix, pard_ordering_t method,
+                          const int *user_perm, int **perm, int **inv_perm,
+                          pard_ordering_t *used);
 int apply_permutation(pard_csr_matrix_t *matrix, const int *perm, const int *inv_perm);
 
 /* 消元树和符号分解 */
+int pard_elimination_tree(const pard_csr_matrix_t *matrix, pard_etree_mode_t mode,
+                          int **parent);
+int pard_etree_postorder(int n, const int *parent, int **post);
 int pard_build_elimination_tree(const pard_csr_matrix_t *matrix,
                                  int **parent, int **first_child, int **next_sibling);
 int pard_symbolic_factorization(const pard_csr_matrix_t *matrix,
                                  const int *parent, const int *first_child,
                                  const int *next_sibling, pard_factors_t **factors);
+int pard_supernode_partition(pard_factors_t *factors, const int *parent,
+                             int relax_max_cols, double relax_max_zeros);
 
 /* 数值分解 */
 int pard_lu_factorization(pard_solver_t *solver);
@@ -2,6 +2,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+/* SpMM每次处理的右端项列数：一行的非零元对这些列一起累加 */
+#define PARD_SPMM_BLOCK 8
+/* 多线程SpMM的最小运算量（nnz*nrhs） */
+#define PARD_SPMM_MT_MIN_WORK 2.0e5
+/* SpMM的最大线程数 */
+#define PARD_SPMM_MAX_THREADS 64
+
+/* SpMM的一个线程任务：行区间[i0, i1) */
+typedef struct {
+    const pard_csr_matrix_t *A;
+    int nrhs;
+    double alpha;
+    const double *Xr;   /* 按行存放的X：Xr[j*nrhs + c] */
+    double beta;
+    double *Y;
+    int i0;
+    int i1;
+} csr_spmm_task_t;
 
 /**
  * 创建CSR矩阵
@@ -41,6 +62,24 @@ int pard_csr_create(pard_csr_matrix_t **matrix, int n, int nnz) {
     return PARD_SUCCESS;
 }
 
+/**
+ * 释放CSR矩阵的三个数组：映射读入的矩阵解除映射，否则逐个free
+ */
+void pard_csr_release_storage(pard_csr_matrix_t *m) {
+    if (m->mapping != NULL) {
+        munmap(m->mapping, m->mapping_size);
+        m->mapping = NULL;
+        m->mapping_size = 0;
+    } else {
+        free(m->row_ptr);
+        free(m->col_idx);
+        free(m->values);
+    }
+    m->row_ptr = NULL;
+    m->col_idx = NULL;
+    m->values = NULL;
+}
+
 /**
  * 释放CSR矩阵
  */
@@ -50,20 +89,7 @@ int pard_csr_free(pard_csr_matrix_t **matrix) {
     }
     
     pard_csr_matrix_t *m = *matrix;
-    
-    /* 安全释放各个字段，避免重复释放 */
-    if (m->row_ptr != NULL) {
-        free(m->row_ptr);
-        m->row_ptr = NULL;
-    }
-    if (m->col_idx != NULL) {
-        free(m->col_idx);
-        m->col_idx = NULL;
-    }
-    if (m->values != NULL) {
-        free(m->values);
-        m->values = NULL;
-    }
+    pard_csr_release_storage(m);
     
     /* 释放矩阵结构体本身 */
     free(m);
@@ -239,3 +265,150 @@ int pard_csr_multiply(pard_csr_matrix_t *C, const pard_csr_matrix_t *A,
     free(temp);
     return PARD_SUCCESS;
 }
+
+/**
+ * Y[i0:i1, :] = beta*Y + alpha*A*X，X按行存放。每行的非零元对PARD_SPMM_BLOCK列一起累加，
+ * 块宽为编译期常量，累加器留在寄存器中，最内层循环访问连续的X行片段，便于向量化；
+ * 不足一个列块的剩余列逐列累加
+ */
+static void csr_spmm_rows(const csr_spmm_task_t *t) {
+    const int *row_ptr = t->A->row_ptr;
+    const int *col_idx = t->A->col_idx;
+    const double *values = t->A->values;
+    const double *Xr = t->Xr;
+    double *Y = t->Y;
+    double alpha = t->alpha;
+    double beta = t->beta;
+    int n = t->A->n;
+    int nrhs = t->nrhs;
+    int nfull = nrhs - nrhs % PARD_SPMM_BLOCK;
+    for (int i = t->i0; i < t->i1; i++) {
+        int p0 = row_ptr[i], p1 = row_ptr[i + 1];
+        for (int c0 = 0; c0 < nfull; c0 += PARD_SPMM_BLOCK) {
+            double acc[PARD_SPMM_BLOCK] = {0.0};
+            for (int p = p0; p < p1; p++) {
+                double a = values[p];
+                const double *x = Xr + (size_t)col_idx[p] * nrhs + c0;
+                for (int c = 0; c < PARD_SPMM_BLOCK; c++) {
+                    acc[c] += a * x[c];
+                }
+            }
+            double *y = Y + (size_t)c0 * n + i;
+            if (beta == 0.0) {
+                for (int c = 0; c < PARD_SPMM_BLOCK; c++) {
+                    y[(size_t)c * n] = alpha * acc[c];
+                }
+            } else {
+                for (int c = 0; c < PARD_SPMM_BLOCK; c++) {
+                    y[(size_t)c * n] = beta * y[(size_t)c * n] + alpha * acc[c];
+                }
+            }
+        }
+        for (int c = nfull; c < nrhs; c++) {
+            double sum = 0.0;
+            for (int p = p0; p < p1; p++) {
+                sum += values[p] * Xr[(size_t)col_idx[p] * nrhs + c];
+            }
+            double *y = Y + (size_t)c * n + i;
+            *y = (beta == 0.0) ? alpha * sum : beta * *y + alpha * sum;
+        }
+    }
+}
+
+static void *csr_spmm_worker(void *arg) {
+    csr_spmm_rows((const csr_spmm_task_t *)arg);
+    return NULL;
+}
+
+/**
+ * 稀疏矩阵乘多个向量（SpMM）：Y = beta*Y + alpha*A*X
+ * X、Y为n×nrhs列主序。多个右端项一趟扫描A，访存量约为逐列SpMV的1/nrhs。
+ * nrhs > 1时X先转为按行存放，work为其缓冲区（n*nrhs个double），为NULL时临时分配。
+ * 按非零元个数把行均分给nthreads个线程（运算量小时串行）；beta为0时不读取Y
+ */
+int pard_csr_spmm(const pard_csr_matrix_t *A, int nrhs, double alpha, const double *X,
+                  double beta, double *Y, double *work, int nthreads) {
+    if (A == NULL || X == NULL || Y == NULL || nrhs <= 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    
+    int n = A->n;
+    const double *Xr = X;
+    double *packed = NULL;
+    if (nrhs > 1) {
+        packed = (work != NULL) ? work : (double *)malloc((size_t)n * nrhs * sizeof(double));
+        if (packed == NULL) {
+            return PARD_ERROR_MEMORY;
+        }
+        /* 按行写入：写是连续的，读是nrhs路步长为n的流 */
+        for (int j = 0; j < n; j++) {
+            double *xr = packed + (size_t)j * nrhs;
+            for (int c = 0; c < nrhs; c++) {
+                xr[c] = X[(size_t)c * n + j];
+            }
+        }
+        Xr = packed;
+    }
+    
+    int nnz = A->row_ptr[n];
+    if ((double)nnz * nrhs < PARD_SPMM_MT_MIN_WORK || n < 2) {
+        nthreads = 1;
+    }
+    if (nthreads > PARD_SPMM_MAX_THREADS) {
+        nthreads = PARD_SPMM_MAX_THREADS;
+    }
+    if (nthreads > n) {
+        nthreads = n;
+    }
+    if (nthreads < 1) {
+        nthreads = 1;
+    }
+    
+    csr_spmm_task_t tasks[PARD_SPMM_MAX_THREADS];
+    pthread_t tids[PARD_SPMM_MAX_THREADS];
+    int started[PARD_SPMM_MAX_THREADS];
+    int i = 0;
+    for (int t = 0; t < nthreads; t++) {
+        tasks[t].A = A;
+        tasks[t].nrhs = nrhs;
+        tasks[t].alpha = alpha;
+        tasks[t].Xr = Xr;
+        tasks[t].beta = beta;
+        tasks[t].Y = Y;
+        tasks[t].i0 = i;
+        if (t == nthreads - 1) {
+            i = n;
+        } else {
+            /* 第一个行指针不小于目标非零元数的行 */
+            long target = (long)nnz * (t + 1) / nthreads;
+            int lo = i, hi = n;
+            while (lo < hi) {
+                int mid = lo + (hi - lo) / 2;
+                if (A->row_ptr[mid] < target) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            i = lo;
+        }
+        tasks[t].i1 = i;
+    }
+    
+    for (int t = 1; t < nthreads; t++) {
+        started[t] = (pthread_create(&tids[t], NULL, csr_spmm_worker, &tasks[t]) == 0);
+    }
+    csr_spmm_rows(&tasks[0]);
+    for (int t = 1; t < nthreads; t++) {
+        if (started[t]) {
+            pthread_join(tids[t], NULL);
+        } else {
+            csr_spmm_rows(&tasks[t]);
+        }
+    }
+    
+    if (packed != work) {
+        free(packed);
+    }
+    return PARD_SUCCESS;
+}
@@ -2,148 +2,548 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <math.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdint.h>
+
+/* 每个解析线程至少处理的字节数 */
+#define PARD_MTX_MIN_CHUNK (1 << 20)
+/* 解析线程的最大数目 */
+#define PARD_MTX_MAX_THREADS 64
+
+/* 二进制CSR格式 */
+#define PARD_BIN_MAGIC "PARDCSR"
+#define PARD_BIN_VERSION 1u
+#define PARD_BIN_ENDIAN 0x01020304u
+#define PARD_BIN_ALIGN 64
+#define PARD_BIN_FLAG_SYMMETRIC 0x1u
+#define PARD_BIN_FLAG_UPPER 0x2u
+#define PARD_BIN_FLAG_CHECKSUM 0x4u
+#define PARD_BIN_FNV_OFFSET 0xcbf29ce484222325ULL
+#define PARD_BIN_FNV_PRIME 0x100000001b3ULL
+
+/* 前向声明 */
+extern int pard_get_num_threads(const pard_solver_t *solver);
+
+/* Matrix Market的数值类型与对称性 */
+typedef enum {
+    MTX_FIELD_REAL = 0,
+    MTX_FIELD_INTEGER = 1,
+    MTX_FIELD_PATTERN = 2
+} mtx_field_t;
+
+typedef enum {
+    MTX_GENERAL = 0,
+    MTX_SYMMETRIC = 1,
+    MTX_SKEW_SYMMETRIC = 2
+} mtx_symmetry_t;
+
+/* 一个解析线程的任务：文本区间[begin, end)，结果写入坐标数组的[offset, offset+count) */
+typedef struct {
+    const char *begin;
+    const char *end;
+    mtx_field_t field;
+    int n;
+    int offset;
+    int count;          /* 区间内的数据行数（第一遍统计） */
+    int *rows;
+    int *cols;
+    double *vals;
+    int err;
+} mtx_chunk_t;
+
+static const char *mtx_skip_blank(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+static const char *mtx_next_line(const char *p, const char *end) {
+    const char *nl = (const char *)memchr(p, '\n', end - p);
+    return (nl != NULL) ? nl + 1 : end;
+}
 
 /**
- * 读取Matrix Market格式文件
+ * 解析非负整数，成功时返回数字之后的位置，失败返回NULL
  */
-int pard_matrix_read_mtx(pard_csr_matrix_t **matrix, const char *filename) {
-    if (matrix == NULL || filename == NULL) {
-        return PARD_ERROR_INVALID_INPUT;
+static const char *mtx_parse_int(const char *p, const char *end, long *value) {
+    p = mtx_skip_blank(p, end);
+    if (p == end || *p < '0' || *p > '9') {
+        return NULL;
     }
-    
-    FILE *fp = fopen(filename, "r");
-    if (fp == NULL) {
-        return PARD_ERROR_INVALID_INPUT;
+    long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        if (v > 2147483647L) {
+            return NULL;
+        }
+        p++;
     }
-    
-    char line[1024];
-    int nrows = 0, ncols = 0, nnz = 0;
-    int symmetric = 0;
-    int header_found = 0;
-    
-    /* 读取头部 */
-    while (fgets(line, sizeof(line), fp)) {
-        if (line[0] == '%') {
-            if (strstr(line, "symmetric") != NULL || strstr(line, "Hermitian") != NULL) {
-                symmetric = 1;
+    *value = v;
+    return p;
+}
+
+/**
+ * 解析浮点数。有效数字不超过2^53且十进制指数在±22以内时（Clinger快速路径）
+ * 一次舍入即得正确结果；其余情形（长尾数、inf/nan等）复制到缓冲区交给strtod
+ */
+static const char *mtx_parse_double(const char *p, const char *end, double *value) {
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    p = mtx_skip_blank(p, end);
+    const char *start = p;
+    int neg = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+        neg = (*p == '-');
+        p++;
+    }
+    unsigned long long mant = 0;
+    int digits = 0, exp10 = 0, any = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (digits < 19) {
+            mant = mant * 10 + (unsigned)(*p - '0');
+            if (mant != 0) {
+                digits++;
+            }
+        } else {
+            exp10++;
+        }
+        any = 1;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (digits < 19) {
+                mant = mant * 10 + (unsigned)(*p - '0');
+                if (mant != 0) {
+                    digits++;
+                }
+                exp10--;
+            }
+            any = 1;
+            p++;
+        }
+    }
+    if (any && p < end && (*p == 'e' || *p == 'E' || *p == 'd' || *p == 'D')) {
+        const char *q = p + 1;
+        int eneg = 0;
+        if (q < end && (*q == '+' || *q == '-')) {
+            eneg = (*q == '-');
+            q++;
+        }
+        if (q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            while (q < end && *q >= '0' && *q <= '9') {
+                if (e < 100000) {
+                    e = e * 10 + (*q - '0');
+                }
+                q++;
             }
+            exp10 += eneg ? -e : e;
+            p = q;
+        }
+    }
+    if (any && mant <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+        double v = (double)mant;
+        v = (exp10 < 0) ? v / pow10[-exp10] : v * pow10[exp10];
+        *value = neg ? -v : v;
+        return p;
+    }
+    
+    char buf[128];
+    size_t len = 0;
+    for (const char *q = start; q < end && len + 1 < sizeof(buf) && !isspace((unsigned char)*q); q++) {
+        buf[len++] = *q;
+    }
+    buf[len] = '\0';
+    char *stop = NULL;
+    *value = strtod(buf, &stop);
+    if (stop == buf) {
+        return NULL;
+    }
+    return start + (stop - buf);
+}
+
+/**
+ * 数据行：跳过空白行和注释行
+ */
+static int mtx_is_data_line(const char *p, const char *end) {
+    p = mtx_skip_blank(p, end);
+    return p < end && *p != '\n' && *p != '%';
+}
+
+/**
+ * 第一遍：统计区间内的数据行数
+ */
+static void *mtx_count_worker(void *arg) {
+    mtx_chunk_t *c = (mtx_chunk_t *)arg;
+    int count = 0;
+    for (const char *p = c->begin; p < c->end; p = mtx_next_line(p, c->end)) {
+        if (mtx_is_data_line(p, c->end)) {
+            count++;
+        }
+    }
+    c->count = count;
+    return NULL;
+}
+
+/**
+ * 第二遍：解析区间内的数据行，行列号转为从0开始
+ */
+static void *mtx_parse_worker(void *arg) {
+    mtx_chunk_t *c = (mtx_chunk_t *)arg;
+    int k = c->offset;
+    for (const char *p = c->begin; p < c->end && c->err == PARD_SUCCESS;
+         p = mtx_next_line(p, c->end)) {
+        if (!mtx_is_data_line(p, c->end)) {
             continue;
         }
-        
-        if (sscanf(line, "%d %d %d", &nrows, &ncols, &nnz) == 3) {
-            header_found = 1;
+        long row, col;
+        double val = 1.0;
+        const char *q = mtx_parse_int(p, c->end, &row);
+        if (q != NULL) {
+            q = mtx_parse_int(q, c->end, &col);
+        }
+        if (q != NULL && c->field != MTX_FIELD_PATTERN) {
+            q = mtx_parse_double(q, c->end, &val);
+        }
+        if (q == NULL || row < 1 || row > c->n || col < 1 || col > c->n) {
+            c->err = PARD_ERROR_INVALID_INPUT;
             break;
         }
+        c->rows[k] = (int)row - 1;
+        c->cols[k] = (int)col - 1;
+        c->vals[k] = val;
+        k++;
+    }
+    return NULL;
+}
+
+/**
+ * 在nthreads个线程上执行fn（线程创建失败时由调用线程补做）
+ */
+static void mtx_run(mtx_chunk_t *chunks, int nthreads, void *(*fn)(void *)) {
+    pthread_t tids[PARD_MTX_MAX_THREADS];
+    int started[PARD_MTX_MAX_THREADS];
+    for (int t = 1; t < nthreads; t++) {
+        started[t] = (pthread_create(&tids[t], NULL, fn, &chunks[t]) == 0);
+    }
+    fn(&chunks[0]);
+    for (int t = 1; t < nthreads; t++) {
+        if (started[t]) {
+            pthread_join(tids[t], NULL);
+        } else {
+            fn(&chunks[t]);
+        }
+    }
+}
+
+/**
+ * 解析头部：%%MatrixMarket横幅（只支持coordinate格式，real/double/integer/pattern数值，
+ * general/symmetric/skew-symmetric/hermitian对称性；缺少横幅时按real general处理），
+ * 然后跳过注释行读取尺寸行。返回数据区的起点，失败返回NULL
+ */
+static const char *mtx_parse_header(const char *p, const char *end, mtx_field_t *field,
+                                    mtx_symmetry_t *symmetry, long *nrows, long *ncols,
+                                    long *nnz) {
+    *field = MTX_FIELD_REAL;
+    *symmetry = MTX_GENERAL;
+    
+    const char *q = p;
+    while (q < end && *q == '%') {
+        q++;
+    }
+    if (q > p && end - q >= 12 && strncasecmp(q, "MatrixMarket", 12) == 0) {
+        const char *eol = mtx_next_line(p, end);
+        char banner[256];
+        size_t len = 0;
+        for (const char *r = q; r < eol && len + 1 < sizeof(banner); r++) {
+            banner[len++] = (char)tolower((unsigned char)*r);
+        }
+        banner[len] = '\0';
+        
+        char *tok[5] = {NULL};
+        int ntok = 0;
+        for (char *t = strtok(banner, " \t\r\n"); t != NULL && ntok < 5;
+             t = strtok(NULL, " \t\r\n")) {
+            tok[ntok++] = t;
+        }
+        if (ntok < 5 || strcmp(tok[1], "matrix") != 0 || strcmp(tok[2], "coordinate") != 0) {
+            return NULL;
+        }
+        if (strcmp(tok[3], "integer") == 0) {
+            *field = MTX_FIELD_INTEGER;
+        } else if (strcmp(tok[3], "pattern") == 0) {
+            *field = MTX_FIELD_PATTERN;
+        } else if (strcmp(tok[3], "real") != 0 && strcmp(tok[3], "double") != 0) {
+            return NULL;  /* 不支持复数 */
+        }
+        if (strcmp(tok[4], "symmetric") == 0 || strcmp(tok[4], "hermitian") == 0) {
+            *symmetry = MTX_SYMMETRIC;
+        } else if (strcmp(tok[4], "skew-symmetric") == 0) {
+            *symmetry = MTX_SKEW_SYMMETRIC;
+        } else if (strcmp(tok[4], "general") != 0) {
+            return NULL;
+        }
+        p = eol;
     }
     
-    /* 如果没有找到头部，或者不是方阵，返回错误 */
-    if (!header_found || nrows <= 0 || ncols <= 0 || nnz < 0) {
-        fclose(fp);
+    while (p < end && !mtx_is_data_line(p, end)) {
+        p = mtx_next_line(p, end);
+    }
+    const char *r = mtx_parse_int(p, end, nrows);
+    if (r != NULL) {
+        r = mtx_parse_int(r, end, ncols);
+    }
+    if (r != NULL) {
+        r = mtx_parse_int(r, end, nnz);
+    }
+    if (r == NULL) {
+        return NULL;
+    }
+    return mtx_next_line(r, end);
+}
+
+/**
+ * 由坐标数组构建CSR（对称、反对称存储补全另一半三角）。
+ * 两趟计数排序：先按列号分桶，再稳定地按行号分桶，每行的列号自然递增
+ */
+static int mtx_build_csr(pard_csr_matrix_t **matrix, int n, int count, const int *rows,
+                         const int *cols, const double *vals, mtx_symmetry_t symmetry) {
+    int mirrored = 0;
+    if (symmetry != MTX_GENERAL) {
+        for (int k = 0; k < count; k++) {
+            if (rows[k] != cols[k]) {
+                mirrored++;
+            }
+        }
+    }
+    if ((long)count + mirrored > 2147483647L) {
         return PARD_ERROR_INVALID_INPUT;
     }
+    int total = count + mirrored;
     
-    if (nrows != ncols) {
-        fclose(fp);
-        return PARD_ERROR_INVALID_INPUT;  /* 只支持方阵 */
+    int *cptr = (int *)calloc(n + 1, sizeof(int));
+    int *crow = (int *)malloc((total > 0 ? total : 1) * sizeof(int));
+    double *cval = (double *)malloc((total > 0 ? total : 1) * sizeof(double));
+    if (cptr == NULL || crow == NULL || cval == NULL) {
+        free(cptr);
+        free(crow);
+        free(cval);
+        return PARD_ERROR_MEMORY;
     }
     
-    int n = nrows;
-    int actual_nnz = symmetric ? (nnz * 2 - n) : nnz;  /* 对称矩阵需要存储对角和上三角 */
+    /* 按列分桶（CSC） */
+    double sign = (symmetry == MTX_SKEW_SYMMETRIC) ? -1.0 : 1.0;
+    for (int k = 0; k < count; k++) {
+        cptr[cols[k] + 1]++;
+        if (symmetry != MTX_GENERAL && rows[k] != cols[k]) {
+            cptr[rows[k] + 1]++;
+        }
+    }
+    for (int j = 0; j < n; j++) {
+        cptr[j + 1] += cptr[j];
+    }
+    for (int k = 0; k < count; k++) {
+        int p = cptr[cols[k]]++;
+        crow[p] = rows[k];
+        cval[p] = vals[k];
+        if (symmetry != MTX_GENERAL && rows[k] != cols[k]) {
+            p = cptr[rows[k]]++;
+            crow[p] = cols[k];
+            cval[p] = sign * vals[k];
+        }
+    }
+    for (int j = n; j > 0; j--) {
+        cptr[j] = cptr[j - 1];
+    }
+    cptr[0] = 0;
     
-    /* 创建矩阵 */
-    int err = pard_csr_create(matrix, n, actual_nnz);
+    int err = pard_csr_create(matrix, n, total);
     if (err != PARD_SUCCESS) {
-        fclose(fp);
+        free(cptr);
+        free(crow);
+        free(cval);
         return err;
     }
     
-    (*matrix)->is_symmetric = symmetric;
-    
-    /* 临时存储所有非零元素 */
-    typedef struct {
-        int row, col;
-        double val;
-    } coo_entry_t;
-    
-    coo_entry_t *entries = (coo_entry_t *)malloc(nnz * sizeof(coo_entry_t));
-    if (entries == NULL) {
-        pard_csr_free(matrix);
-        fclose(fp);
-        return PARD_ERROR_MEMORY;
+    /* 按行分桶：按列顺序遍历，每行内的列号递增 */
+    int *row_ptr = (*matrix)->row_ptr;
+    memset(row_ptr, 0, (n + 1) * sizeof(int));
+    for (int p = 0; p < total; p++) {
+        row_ptr[crow[p] + 1]++;
     }
-    
-    int count = 0;
-    while (fgets(line, sizeof(line), fp) && count < nnz) {
-        int row, col;
-        double val;
-        if (sscanf(line, "%d %d %lf", &row, &col, &val) == 3) {
-            entries[count].row = row - 1;  /* Matrix Market是1-based */
-            entries[count].col = col - 1;
-            entries[count].val = val;
-            count++;
-            
-            /* 如果是对称矩阵且不在对角线上，添加对称元素 */
-            if (symmetric && row != col && count < nnz) {
-                entries[count].row = col - 1;
-                entries[count].col = row - 1;
-                entries[count].val = val;
-                count++;
-            }
+    for (int i = 0; i < n; i++) {
+        row_ptr[i + 1] += row_ptr[i];
+    }
+    for (int j = 0; j < n; j++) {
+        for (int p = cptr[j]; p < cptr[j + 1]; p++) {
+            int q = row_ptr[crow[p]]++;
+            (*matrix)->col_idx[q] = j;
+            (*matrix)->values[q] = cval[p];
         }
     }
+    for (int i = n; i > 0; i--) {
+        row_ptr[i] = row_ptr[i - 1];
+    }
+    row_ptr[0] = 0;
+    (*matrix)->is_symmetric = (symmetry == MTX_SYMMETRIC);
     
-    fclose(fp);
+    free(cptr);
+    free(crow);
+    free(cval);
+    return PARD_SUCCESS;
+}
+
+/**
+ * 读取Matrix Market格式文件（coordinate格式的方阵）
+ * 文件通过mmap映射（映射失败时整体读入内存），数据区按换行符切分给多个线程：
+ * 第一遍统计各段的数据行数并求前缀和，第二遍各线程用手写的整数/浮点解析器把坐标写入各自的位置，
+ * 最后用计数排序直接生成CSR。对称（及Hermitian）与反对称文件只存一半三角，读入时补全
+ * 另一半（反对称取相反数）；pattern文件的数值取1。
+ * 数据行少于头部声明的个数时按实际读到的构建，多出的数据行忽略
+ */
+int pard_matrix_read_mtx(pard_csr_matrix_t **matrix, const char *filename) {
+    if (matrix == NULL || filename == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
     
-    /* 按行排序 */
-    for (int i = 0; i < count - 1; i++) {
-        for (int j = i + 1; j < count; j++) {
-            if (entries[i].row > entries[j].row || 
-                (entries[i].row == entries[j].row && entries[i].col > entries[j].col)) {
-                coo_entry_t tmp = entries[i];
-                entries[i] = entries[j];
-                entries[j] = tmp;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    size_t size = (size_t)st.st_size;
+    char *data = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int mapped = (data != MAP_FAILED);
+    if (!mapped) {
+        data = (char *)malloc(size);
+        size_t got = 0;
+        while (data != NULL && got < size) {
+            ssize_t r = read(fd, data + got, size - got);
+            if (r <= 0) {
+                break;
             }
+            got += (size_t)r;
+        }
+        if (data == NULL || got < size) {
+            free(data);
+            close(fd);
+            return (data == NULL) ? PARD_ERROR_MEMORY : PARD_ERROR_INVALID_INPUT;
         }
     }
+    close(fd);
+    const char *end = data + size;
     
-    /* 转换为CSR格式 */
-    int *row_counts = (int *)calloc(n, sizeof(int));
-    if (row_counts == NULL) {
-        free(entries);
-        pard_csr_free(matrix);
-        return PARD_ERROR_MEMORY;
+    mtx_field_t field;
+    mtx_symmetry_t symmetry;
+    long nrows = 0, ncols = 0, nnz = 0;
+    const char *body = mtx_parse_header(data, end, &field, &symmetry, &nrows, &ncols, &nnz);
+    if (body == NULL || nrows <= 0 || nrows != ncols) {
+        if (mapped) {
+            munmap(data, size);
+        } else {
+            free(data);
+        }
+        return PARD_ERROR_INVALID_INPUT;  /* 只支持方阵 */
     }
+    int n = (int)nrows;
     
-    for (int i = 0; i < count; i++) {
-        row_counts[entries[i].row]++;
+    /* 按换行符切分数据区 */
+    int nthreads = pard_get_num_threads(NULL);
+    long max_chunks = (long)((end - body) / PARD_MTX_MIN_CHUNK) + 1;
+    if (nthreads > max_chunks) {
+        nthreads = (int)max_chunks;
     }
-    
-    (*matrix)->row_ptr[0] = 0;
-    for (int i = 0; i < n; i++) {
-        (*matrix)->row_ptr[i + 1] = (*matrix)->row_ptr[i] + row_counts[i];
+    if (nthreads > PARD_MTX_MAX_THREADS) {
+        nthreads = PARD_MTX_MAX_THREADS;
+    }
+    if (nthreads < 1) {
+        nthreads = 1;
+    }
+    mtx_chunk_t chunks[PARD_MTX_MAX_THREADS];
+    const char *p = body;
+    for (int t = 0; t < nthreads; t++) {
+        const char *q = (t == nthreads - 1) ? end : body + (end - body) * (t + 1) / nthreads;
+        if (q < p) {
+            q = p;
+        }
+        if (q < end && q > body && q[-1] != '\n') {
+            q = mtx_next_line(q, end);
+        }
+        chunks[t].begin = p;
+        chunks[t].end = q;
+        chunks[t].field = field;
+        chunks[t].n = n;
+        chunks[t].count = 0;
+        chunks[t].err = PARD_SUCCESS;
+        p = q;
     }
     
-    memset(row_counts, 0, n * sizeof(int));
+    mtx_run(chunks, nthreads, mtx_count_worker);
+    long count = 0;
+    for (int t = 0; t < nthreads; t++) {
+        chunks[t].offset = (int)count;
+        count += chunks[t].count;
+    }
+    if (count > 2147483647L) {
+        if (mapped) {
+            munmap(data, size);
+        } else {
+            free(data);
+        }
+        return PARD_ERROR_INVALID_INPUT;
+    }
     
-    for (int i = 0; i < count; i++) {
-        int row = entries[i].row;
-        /* 确保row在有效范围内 */
-        if (row >= 0 && row < n) {
-            int pos = (*matrix)->row_ptr[row] + row_counts[row];
-            /* 确保pos在有效范围内 */
-            if (pos >= 0 && pos < (*matrix)->nnz) {
-                (*matrix)->col_idx[pos] = entries[i].col;
-                (*matrix)->values[pos] = entries[i].val;
-                row_counts[row]++;
+    int *rows = (int *)malloc((count > 0 ? count : 1) * sizeof(int));
+    int *cols = (int *)malloc((count > 0 ? count : 1) * sizeof(int));
+    double *vals = (double *)malloc((count > 0 ? count : 1) * sizeof(double));
+    int err = PARD_SUCCESS;
+    if (rows == NULL || cols == NULL || vals == NULL) {
+        err = PARD_ERROR_MEMORY;
+    }
+    if (err == PARD_SUCCESS) {
+        for (int t = 0; t < nthreads; t++) {
+            chunks[t].rows = rows;
+            chunks[t].cols = cols;
+            chunks[t].vals = vals;
+        }
+        mtx_run(chunks, nthreads, mtx_parse_worker);
+        for (int t = 0; t < nthreads; t++) {
+            if (chunks[t].err != PARD_SUCCESS) {
+                err = chunks[t].err;
             }
         }
     }
+    if (mapped) {
+        munmap(data, size);
+    } else {
+        free(data);
+    }
     
-    free(entries);
-    free(row_counts);
+    if (err == PARD_SUCCESS) {
+        int used = (count < nnz) ? (int)count : (int)nnz;
+        err = mtx_build_csr(matrix, n, used, rows, cols, vals, symmetry);
+    }
     
-    return PARD_SUCCESS;
+    free(rows);
+    free(cols);
+    free(vals);
+    return err;
 }
 
 /**
@@ -173,6 +573,291 @@ int pard_matrix_write_mtx(const pard_csr_matrix_t *matrix, const char *filename)
     return PARD_SUCCESS;
 }
 
+/**
+ * 二进制CSR文件头（小端机器上按原样写出，读入时用endian字段检查字节序）
+ * 文件布局：文件头，随后row_ptr、col_idx、values三段，每段起点按PARD_BIN_ALIGN对齐，
+ * 段间以零填充，使映射后的数组满足SIMD加载的对齐要求
+ */
+typedef struct {
+    char magic[8];              /* PARD_BIN_MAGIC */
+    uint32_t version;           /* PARD_BIN_VERSION */
+    uint32_t endian;            /* PARD_BIN_ENDIAN，按写入端的字节序存放 */
+    uint32_t flags;             /* PARD_BIN_FLAG_* */
+    uint32_t index_size;        /* 索引类型的字节数，sizeof(int) */
+    int64_t n;
+    int64_t nnz;
+    uint64_t row_ptr_offset;
+    uint64_t col_idx_offset;
+    uint64_t values_offset;
+    uint64_t file_size;
+    uint64_t checksum;          /* 三个数据段的FNV-1a校验和，无PARD_BIN_FLAG_CHECKSUM时为0 */
+    uint64_t reserved;
+} pard_bin_header_t;
+
+/**
+ * 对一段数据累加FNV-1a校验和：按8字节字处理，末尾不足8字节的部分逐字节处理。
+ * 也用于求解器状态文件（solver_io.c）
+ */
+uint64_t pard_bin_checksum(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    size_t nw = len / 8;
+    for (size_t k = 0; k < nw; k++) {
+        uint64_t w;
+        memcpy(&w, p + 8 * k, 8);
+        h ^= w;
+        h *= PARD_BIN_FNV_PRIME;
+    }
+    for (size_t k = 8 * nw; k < len; k++) {
+        h ^= p[k];
+        h *= PARD_BIN_FNV_PRIME;
+    }
+    return h;
+}
+
+/**
+ * 三个数据段的校验和
+ */
+static uint64_t bin_matrix_checksum(const int *row_ptr, const int *col_idx,
+                                    const double *values, int n, int nnz) {
+    uint64_t h = PARD_BIN_FNV_OFFSET;
+    h = pard_bin_checksum(h, row_ptr, (size_t)(n + 1) * sizeof(int));
+    h = pard_bin_checksum(h, col_idx, (size_t)nnz * sizeof(int));
+    h = pard_bin_checksum(h, values, (size_t)nnz * sizeof(double));
+    return h;
+}
+
+static uint64_t bin_align(uint64_t offset) {
+    return (offset + PARD_BIN_ALIGN - 1) / PARD_BIN_ALIGN * PARD_BIN_ALIGN;
+}
+
+/**
+ * 写出一段数据，并以零填充到下一段的起点
+ */
+static int bin_write_section(FILE *fp, const void *data, size_t len, uint64_t *pos,
+                             uint64_t next) {
+    static const char zeros[PARD_BIN_ALIGN] = {0};
+    if (len > 0 && fwrite(data, 1, len, fp) != len) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    *pos += len;
+    while (*pos < next) {
+        size_t pad = (size_t)(next - *pos);
+        if (pad > sizeof(zeros)) {
+            pad = sizeof(zeros);
+        }
+        if (fwrite(zeros, 1, pad, fp) != pad) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+        *pos += pad;
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 写入二进制CSR文件
+ * checksum非0时计算三个数据段的校验和写入文件头，读入时可用PARD_BIN_VERIFY校验
+ */
+int pard_matrix_write_bin(const pard_csr_matrix_t *matrix, const char *filename, int checksum) {
+    if (matrix == NULL || filename == NULL || matrix->n <= 0 || matrix->row_ptr == NULL ||
+        matrix->row_ptr[matrix->n] != matrix->nnz ||
+        (matrix->nnz > 0 && (matrix->col_idx == NULL || matrix->values == NULL))) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    
+    int n = matrix->n;
+    int nnz = matrix->nnz;
+    pard_bin_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, PARD_BIN_MAGIC, sizeof(hdr.magic));
+    hdr.version = PARD_BIN_VERSION;
+    hdr.endian = PARD_BIN_ENDIAN;
+    hdr.flags = (matrix->is_symmetric ? PARD_BIN_FLAG_SYMMETRIC : 0) |
+                (matrix->is_upper ? PARD_BIN_FLAG_UPPER : 0) |
+                (checksum ? PARD_BIN_FLAG_CHECKSUM : 0);
+    hdr.index_size = (uint32_t)sizeof(int);
+    hdr.n = n;
+    hdr.nnz = nnz;
+    hdr.row_ptr_offset = bin_align(sizeof(hdr));
+    hdr.col_idx_offset = bin_align(hdr.row_ptr_offset + (uint64_t)(n + 1) * sizeof(int));
+    hdr.values_offset = bin_align(hdr.col_idx_offset + (uint64_t)nnz * sizeof(int));
+    hdr.file_size = hdr.values_offset + (uint64_t)nnz * sizeof(double);
+    if (checksum) {
+        hdr.checksum = bin_matrix_checksum(matrix->row_ptr, matrix->col_idx,
+                                           matrix->values, n, nnz);
+    }
+    
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    uint64_t pos = 0;
+    int err = bin_write_section(fp, &hdr, sizeof(hdr), &pos, hdr.row_ptr_offset);
+    if (err == PARD_SUCCESS) {
+        err = bin_write_section(fp, matrix->row_ptr, (size_t)(n + 1) * sizeof(int), &pos,
+                                hdr.col_idx_offset);
+    }
+    if (err == PARD_SUCCESS) {
+        err = bin_write_section(fp, matrix->col_idx, (size_t)nnz * sizeof(int), &pos,
+                                hdr.values_offset);
+    }
+    if (err == PARD_SUCCESS) {
+        err = bin_write_section(fp, matrix->values, (size_t)nnz * sizeof(double), &pos,
+                                hdr.file_size);
+    }
+    if (fclose(fp) != 0 && err == PARD_SUCCESS) {
+        err = PARD_ERROR_INVALID_INPUT;
+    }
+    return err;
+}
+
+/**
+ * 检查文件头：版本、字节序、索引宽度、维数范围以及各段都在文件之内且对齐
+ */
+static int bin_check_header(const pard_bin_header_t *hdr, uint64_t size) {
+    if (memcmp(hdr->magic, PARD_BIN_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version == 0 || hdr->version > PARD_BIN_VERSION ||
+        hdr->endian != PARD_BIN_ENDIAN || hdr->index_size != sizeof(int) ||
+        hdr->n <= 0 || hdr->n >= 2147483647LL || hdr->nnz < 0 || hdr->nnz > 2147483647LL ||
+        hdr->file_size != size) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    uint64_t rp_end = hdr->row_ptr_offset + (uint64_t)(hdr->n + 1) * sizeof(int);
+    uint64_t ci_end = hdr->col_idx_offset + (uint64_t)hdr->nnz * sizeof(int);
+    uint64_t va_end = hdr->values_offset + (uint64_t)hdr->nnz * sizeof(double);
+    if (hdr->row_ptr_offset % PARD_BIN_ALIGN != 0 || hdr->col_idx_offset % PARD_BIN_ALIGN != 0 ||
+        hdr->values_offset % PARD_BIN_ALIGN != 0 || hdr->row_ptr_offset < sizeof(*hdr) ||
+        rp_end > hdr->col_idx_offset || ci_end > hdr->values_offset || va_end > size) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 从文件的offset处读入len字节
+ */
+static int bin_read_at(int fd, void *buf, size_t len, uint64_t offset) {
+    if (lseek(fd, (off_t)offset, SEEK_SET) == (off_t)-1) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    size_t got = 0;
+    while (got < len) {
+        ssize_t r = read(fd, (char *)buf + got, len - got);
+        if (r <= 0) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+        got += (size_t)r;
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 检查CSR结构：row_ptr从0开始单调不减且止于nnz，列索引都在[0, n)内。
+ * 只需一遍O(n+nnz)的扫描，后续的符号分析直接按这些索引访问数组
+ */
+static int bin_check_structure(const pard_csr_matrix_t *m) {
+    if (m->row_ptr[0] != 0 || m->row_ptr[m->n] != m->nnz) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    for (int i = 0; i < m->n; i++) {
+        if (m->row_ptr[i + 1] < m->row_ptr[i]) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    for (int p = 0; p < m->nnz; p++) {
+        if (m->col_idx[p] < 0 || m->col_idx[p] >= m->n) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 读取二进制CSR文件（pard_matrix_write_bin写出的格式）
+ * mode为pard_bin_mode_t的组合：
+ *   PARD_BIN_MMAP：以MAP_PRIVATE映射整个文件，三个数组直接指向映射区，按需从页缓存换入；
+ *     写入（如符号分析中的原地置换、重新分解前改写数值）只产生进程私有的副本，不影响文件。
+ *     映射由pard_csr_free解除
+ *   PARD_BIN_VERIFY：文件带校验和时校验全部数据段（需要读遍整个文件），不符时返回错误
+ * 两种方式都检查CSR结构（row_ptr单调、首尾与nnz一致，列索引在范围内），不合法时返回错误；
+ * 映射模式下这一遍扫描会换入索引数组，数值段仍按需换入
+ */
+int pard_matrix_read_bin(pard_csr_matrix_t **matrix, const char *filename, int mode) {
+    if (matrix == NULL || filename == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    struct stat st;
+    pard_bin_header_t hdr;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(hdr) ||
+        bin_read_at(fd, &hdr, sizeof(hdr), 0) != PARD_SUCCESS ||
+        bin_check_header(&hdr, (uint64_t)st.st_size) != PARD_SUCCESS) {
+        close(fd);
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    int n = (int)hdr.n;
+    int nnz = (int)hdr.nnz;
+    
+    pard_csr_matrix_t *m = NULL;
+    int err;
+    if (mode & PARD_BIN_MMAP) {
+        size_t size = (size_t)st.st_size;
+        char *data = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return PARD_ERROR_MEMORY;
+        }
+        m = (pard_csr_matrix_t *)calloc(1, sizeof(pard_csr_matrix_t));
+        if (m == NULL) {
+            munmap(data, size);
+            return PARD_ERROR_MEMORY;
+        }
+        m->n = n;
+        m->nnz = nnz;
+        m->row_ptr = (int *)(data + hdr.row_ptr_offset);
+        m->col_idx = (int *)(data + hdr.col_idx_offset);
+        m->values = (double *)(data + hdr.values_offset);
+        m->mapping = data;
+        m->mapping_size = size;
+        err = PARD_SUCCESS;
+    } else {
+        err = pard_csr_create(&m, n, nnz);
+        if (err == PARD_SUCCESS) {
+            err = bin_read_at(fd, m->row_ptr, (size_t)(n + 1) * sizeof(int), hdr.row_ptr_offset);
+        }
+        if (err == PARD_SUCCESS && nnz > 0) {
+            err = bin_read_at(fd, m->col_idx, (size_t)nnz * sizeof(int), hdr.col_idx_offset);
+        }
+        if (err == PARD_SUCCESS && nnz > 0) {
+            err = bin_read_at(fd, m->values, (size_t)nnz * sizeof(double), hdr.values_offset);
+        }
+        close(fd);
+        if (err != PARD_SUCCESS) {
+            if (m != NULL) {
+                pard_csr_free(&m);
+            }
+            return err;
+        }
+    }
+    m->is_symmetric = (hdr.flags & PARD_BIN_FLAG_SYMMETRIC) ? 1 : 0;
+    m->is_upper = (hdr.flags & PARD_BIN_FLAG_UPPER) ? 1 : 0;
+    
+    err = bin_check_structure(m);
+    if (err == PARD_SUCCESS && (mode & PARD_BIN_VERIFY) && (hdr.flags & PARD_BIN_FLAG_CHECKSUM) &&
+        bin_matrix_checksum(m->row_ptr, m->col_idx, m->values, n, nnz) != hdr.checksum) {
+        err = PARD_ERROR_INVALID_INPUT;
+    }
+    if (err != PARD_SUCCESS) {
+        pard_csr_free(&m);
+        return err;
+    }
+    *matrix = m;
+    return PARD_SUCCESS;
+}
+
 /**
  * 打印矩阵信息
  */
@@ -0,0 +1,433 @@
+#define _XOPEN_SOURCE 700
+#include "pard.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* 临时文件名模板（位于用户给出的目录下） */
+#define PARD_OOC_TEMPLATE "pard_ooc_XXXXXX"
+
+/**
+ * 外存因子：面板的L、U数值保存在临时文件中，内存中只保留索引、主元类型与D。
+ * 数值分解时完成的面板交给后台写回线程，写出后立即释放；
+ * 求解时由预取线程按遍历顺序把面板读回，常驻的面板数值不超过limit字节
+ * （单个面板超过limit时一次只保留这一个）。临时文件创建后即删除，随文件描述符关闭而消失
+ */
+struct pard_ooc {
+    int fd;
+    int npanels;
+    int is_lu;
+    size_t limit;
+    size_t *count;           /* 每个面板L的元素数m*k（LU的U相同） */
+    long long *offset;       /* 面板数值在文件中的偏移，-1表示没有数值 */
+    long long file_end;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    size_t resident;         /* 当前常驻的面板数值字节数 */
+    int err;
+
+    /* 写回队列：数值分解期间使用 */
+    pthread_t writer;
+    int writer_started;
+    int stop;
+    int *queue;
+    double **qL;
+    double **qU;
+    int qhead;
+    int qtail;
+
+    /* 预取序列：求解期间使用 */
+    pthread_t reader;
+    int reader_started;
+    int *order;
+    double **buf;
+    int count_total;
+    int loaded;
+    int consumed;
+    int released;
+};
+
+/* 面板数值的字节数 */
+static size_t ooc_bytes(const pard_ooc_t *ooc, int s) {
+    return ooc->count[s] * sizeof(double) * (ooc->is_lu ? 2 : 1);
+}
+
+static int ooc_pwrite(int fd, const void *data, size_t len, long long offset) {
+    const char *p = (const char *)data;
+    while (len > 0) {
+        ssize_t w = pwrite(fd, p, len, (off_t)offset);
+        if (w <= 0) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+        p += w;
+        len -= (size_t)w;
+        offset += w;
+    }
+    return PARD_SUCCESS;
+}
+
+static int ooc_pread(int fd, void *data, size_t len, long long offset) {
+    char *p = (char *)data;
+    while (len > 0) {
+        ssize_t r = pread(fd, p, len, (off_t)offset);
+        if (r <= 0) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+        p += r;
+        len -= (size_t)r;
+        offset += r;
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 把面板s的L、U写到预先分配的偏移处，然后释放
+ */
+static int ooc_write_panel(pard_ooc_t *ooc, int s, double *L, double *U) {
+    size_t len = ooc->count[s] * sizeof(double);
+    int err = ooc_pwrite(ooc->fd, L, len, ooc->offset[s]);
+    if (err == PARD_SUCCESS && ooc->is_lu) {
+        err = ooc_pwrite(ooc->fd, U, len, ooc->offset[s] + (long long)len);
+    }
+    free(L);
+    free(U);
+    return err;
+}
+
+/* 写回线程：依次写出队列中的面板，写完的面板不再计入常驻字节数 */
+static void *ooc_writer_main(void *arg) {
+    pard_ooc_t *ooc = (pard_ooc_t *)arg;
+    pthread_mutex_lock(&ooc->lock);
+    for (;;) {
+        while (ooc->qhead == ooc->qtail && !ooc->stop) {
+            pthread_cond_wait(&ooc->cond, &ooc->lock);
+        }
+        if (ooc->qhead == ooc->qtail) {
+            break;
+        }
+        int a = ooc->qhead++;
+        int s = ooc->queue[a];
+        pthread_mutex_unlock(&ooc->lock);
+
+        int err = ooc_write_panel(ooc, s, ooc->qL[a], ooc->qU[a]);
+
+        pthread_mutex_lock(&ooc->lock);
+        if (err != PARD_SUCCESS && ooc->err == PARD_SUCCESS) {
+            ooc->err = err;
+        }
+        ooc->resident -= ooc_bytes(ooc, s);
+        pthread_cond_broadcast(&ooc->cond);
+    }
+    pthread_mutex_unlock(&ooc->lock);
+    return NULL;
+}
+
+/**
+ * 在目录dir下创建临时文件，为npanels个面板准备写回。is_lu非零时每个面板另有U。
+ * 写回线程创建失败时改为在调用线程中同步写出
+ */
+int pard_ooc_open(pard_ooc_t **ooc_out, const char *dir, size_t limit, int npanels, int is_lu) {
+    if (ooc_out == NULL || dir == NULL || npanels < 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    *ooc_out = NULL;
+
+    size_t dlen = strlen(dir);
+    char *path = (char *)malloc(dlen + sizeof(PARD_OOC_TEMPLATE) + 1);
+    pard_ooc_t *ooc = (pard_ooc_t *)calloc(1, sizeof(pard_ooc_t));
+    int np1 = npanels > 0 ? npanels : 1;
+    if (ooc != NULL) {
+        ooc->count = (size_t *)calloc(np1, sizeof(size_t));
+        ooc->offset = (long long *)malloc(np1 * sizeof(long long));
+        ooc->queue = (int *)malloc(np1 * sizeof(int));
+        ooc->qL = (double **)malloc(np1 * sizeof(double *));
+        ooc->qU = (double **)malloc(np1 * sizeof(double *));
+    }
+    if (path == NULL || ooc == NULL || ooc->count == NULL || ooc->offset == NULL ||
+        ooc->queue == NULL || ooc->qL == NULL || ooc->qU == NULL) {
+        free(path);
+        if (ooc != NULL) {
+            free(ooc->count);
+            free(ooc->offset);
+            free(ooc->queue);
+            free(ooc->qL);
+            free(ooc->qU);
+            free(ooc);
+        }
+        return PARD_ERROR_MEMORY;
+    }
+
+    memcpy(path, dir, dlen);
+    path[dlen] = '/';
+    memcpy(path + dlen + 1, PARD_OOC_TEMPLATE, sizeof(PARD_OOC_TEMPLATE));
+    ooc->fd = mkstemp(path);
+    if (ooc->fd >= 0) {
+        unlink(path);
+    }
+    free(path);
+    if (ooc->fd < 0) {
+        free(ooc->count);
+        free(ooc->offset);
+        free(ooc->queue);
+        free(ooc->qL);
+        free(ooc->qU);
+        free(ooc);
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    ooc->npanels = npanels;
+    ooc->is_lu = is_lu;
+    ooc->limit = limit;
+    for (int s = 0; s < npanels; s++) {
+        ooc->offset[s] = -1;
+    }
+    pthread_mutex_init(&ooc->lock, NULL);
+    pthread_cond_init(&ooc->cond, NULL);
+    ooc->writer_started = (pthread_create(&ooc->writer, NULL, ooc_writer_main, ooc) == 0);
+    *ooc_out = ooc;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 提交面板s（m×k的L，LU另有k×m的U）写回，L、U的所有权移交给ooc。
+ * 常驻字节数超过上限时先等待写回线程腾出空间
+ */
+int pard_ooc_write(pard_ooc_t *ooc, int s, int m, int k, double *L, double *U) {
+    if (ooc == NULL || s < 0 || s >= ooc->npanels) {
+        free(L);
+        free(U);
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    if ((size_t)m * k == 0) {
+        free(L);
+        free(U);
+        return PARD_SUCCESS;
+    }
+
+    pthread_mutex_lock(&ooc->lock);
+    ooc->count[s] = (size_t)m * k;
+    size_t bytes = ooc_bytes(ooc, s);
+    ooc->offset[s] = ooc->file_end;
+    ooc->file_end += (long long)bytes;
+    if (!ooc->writer_started) {
+        pthread_mutex_unlock(&ooc->lock);
+        int err = ooc_write_panel(ooc, s, L, U);
+        pthread_mutex_lock(&ooc->lock);
+        if (err != PARD_SUCCESS && ooc->err == PARD_SUCCESS) {
+            ooc->err = err;
+        }
+    } else {
+        while (ooc->resident > 0 && ooc->resident + bytes > ooc->limit) {
+            pthread_cond_wait(&ooc->cond, &ooc->lock);
+        }
+        ooc->resident += bytes;
+        ooc->queue[ooc->qtail] = s;
+        ooc->qL[ooc->qtail] = L;
+        ooc->qU[ooc->qtail] = U;
+        ooc->qtail++;
+        pthread_cond_broadcast(&ooc->cond);
+    }
+    int err = ooc->err;
+    pthread_mutex_unlock(&ooc->lock);
+    return err;
+}
+
+/**
+ * 等待所有面板写出并结束写回线程，返回写回过程中的错误
+ */
+int pard_ooc_flush(pard_ooc_t *ooc) {
+    if (ooc == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    if (ooc->writer_started) {
+        pthread_mutex_lock(&ooc->lock);
+        ooc->stop = 1;
+        pthread_cond_broadcast(&ooc->cond);
+        pthread_mutex_unlock(&ooc->lock);
+        pthread_join(ooc->writer, NULL);
+        ooc->writer_started = 0;
+    }
+    free(ooc->queue);
+    free(ooc->qL);
+    free(ooc->qU);
+    ooc->queue = NULL;
+    ooc->qL = NULL;
+    ooc->qU = NULL;
+    return ooc->err;
+}
+
+/* 读入预取序列的第i个面板（没有数值时为NULL） */
+static int ooc_load(pard_ooc_t *ooc, int i, double **out) {
+    int s = ooc->order[i];
+    *out = NULL;
+    if (ooc->offset[s] < 0) {
+        return PARD_SUCCESS;
+    }
+    size_t bytes = ooc_bytes(ooc, s);
+    double *p = (double *)malloc(bytes);
+    if (p == NULL) {
+        return PARD_ERROR_MEMORY;
+    }
+    int err = ooc_pread(ooc->fd, p, bytes, ooc->offset[s]);
+    if (err != PARD_SUCCESS) {
+        free(p);
+        return err;
+    }
+    *out = p;
+    return PARD_SUCCESS;
+}
+
+/* 预取线程：按序列顺序读入面板，常驻字节数超过上限时等待求解释放 */
+static void *ooc_reader_main(void *arg) {
+    pard_ooc_t *ooc = (pard_ooc_t *)arg;
+    pthread_mutex_lock(&ooc->lock);
+    while (ooc->loaded < ooc->count_total && !ooc->stop && ooc->err == PARD_SUCCESS) {
+        int i = ooc->loaded;
+        size_t bytes = ooc_bytes(ooc, ooc->order[i]);
+        while (ooc->resident > 0 && ooc->resident + bytes > ooc->limit && !ooc->stop) {
+            pthread_cond_wait(&ooc->cond, &ooc->lock);
+        }
+        if (ooc->stop) {
+            break;
+        }
+        ooc->resident += bytes;
+        pthread_mutex_unlock(&ooc->lock);
+
+        double *p;
+        int err = ooc_load(ooc, i, &p);
+
+        pthread_mutex_lock(&ooc->lock);
+        ooc->buf[i] = p;
+        if (err != PARD_SUCCESS) {
+            ooc->err = err;
+        }
+        ooc->loaded = i + 1;
+        pthread_cond_broadcast(&ooc->cond);
+    }
+    pthread_mutex_unlock(&ooc->lock);
+    return NULL;
+}
+
+/**
+ * 开始按order[0..count)的顺序流式读回面板（同一面板可出现多次），
+ * 预取线程在后台提前读入，求解依次以pard_ooc_stream_next取用、pard_ooc_stream_release归还。
+ * 预取线程创建失败时由pard_ooc_stream_next同步读入
+ */
+int pard_ooc_stream_begin(pard_ooc_t *ooc, const int *order, int count) {
+    if (ooc == NULL || order == NULL || count < 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    ooc->order = (int *)malloc((count > 0 ? count : 1) * sizeof(int));
+    ooc->buf = (double **)calloc(count > 0 ? count : 1, sizeof(double *));
+    if (ooc->order == NULL || ooc->buf == NULL) {
+        free(ooc->order);
+        free(ooc->buf);
+        ooc->order = NULL;
+        ooc->buf = NULL;
+        return PARD_ERROR_MEMORY;
+    }
+    memcpy(ooc->order, order, count * sizeof(int));
+    ooc->count_total = count;
+    ooc->loaded = 0;
+    ooc->consumed = 0;
+    ooc->released = 0;
+    ooc->resident = 0;
+    ooc->stop = 0;
+    ooc->err = PARD_SUCCESS;
+    ooc->reader_started = (pthread_create(&ooc->reader, NULL, ooc_reader_main, ooc) == 0);
+    return PARD_SUCCESS;
+}
+
+/**
+ * 取出序列中的下一个面板：L为m×k，U（LU）紧随其后；面板没有数值时为NULL。
+ * 每次取用后须先pard_ooc_stream_release再取下一个
+ */
+int pard_ooc_stream_next(pard_ooc_t *ooc, double **L, double **U) {
+    int i = ooc->consumed;
+    if (i >= ooc->count_total) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    int err;
+    if (ooc->reader_started) {
+        pthread_mutex_lock(&ooc->lock);
+        while (ooc->loaded <= i && ooc->err == PARD_SUCCESS) {
+            pthread_cond_wait(&ooc->cond, &ooc->lock);
+        }
+        err = ooc->err;
+        pthread_mutex_unlock(&ooc->lock);
+    } else {
+        err = ooc_load(ooc, i, &ooc->buf[i]);
+    }
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+    ooc->consumed = i + 1;
+    *L = ooc->buf[i];
+    *U = (ooc->is_lu && ooc->buf[i] != NULL) ? ooc->buf[i] + ooc->count[ooc->order[i]] : NULL;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 归还最近取出的面板，释放其内存并唤醒预取线程
+ */
+void pard_ooc_stream_release(pard_ooc_t *ooc) {
+    pthread_mutex_lock(&ooc->lock);
+    while (ooc->released < ooc->consumed) {
+        int i = ooc->released++;
+        free(ooc->buf[i]);
+        ooc->buf[i] = NULL;
+        if (ooc->reader_started) {
+            ooc->resident -= ooc_bytes(ooc, ooc->order[i]);
+        }
+    }
+    pthread_cond_broadcast(&ooc->cond);
+    pthread_mutex_unlock(&ooc->lock);
+}
+
+/**
+ * 结束流式读回：停止预取线程并释放尚未取用的面板
+ */
+void pard_ooc_stream_end(pard_ooc_t *ooc) {
+    if (ooc == NULL || ooc->buf == NULL) {
+        return;
+    }
+    if (ooc->reader_started) {
+        pthread_mutex_lock(&ooc->lock);
+        ooc->stop = 1;
+        pthread_cond_broadcast(&ooc->cond);
+        pthread_mutex_unlock(&ooc->lock);
+        pthread_join(ooc->reader, NULL);
+        ooc->reader_started = 0;
+    }
+    for (int i = 0; i < ooc->count_total; i++) {
+        free(ooc->buf[i]);
+    }
+    free(ooc->buf);
+    free(ooc->order);
+    ooc->buf = NULL;
+    ooc->order = NULL;
+    ooc->count_total = 0;
+    ooc->resident = 0;
+    ooc->stop = 0;
+    ooc->err = PARD_SUCCESS;
+}
+
+/**
+ * 关闭临时文件并释放ooc（写回未结束时先等待写回完成）
+ */
+void pard_ooc_close(pard_ooc_t *ooc) {
+    if (ooc == NULL) {
+        return;
+    }
+    pard_ooc_flush(ooc);
+    pard_ooc_stream_end(ooc);
+    pthread_mutex_destroy(&ooc->lock);
+    pthread_cond_destroy(&ooc->cond);
+    close(ooc->fd);
+    free(ooc->count);
+    free(ooc->offset);
+    free(ooc);
+}
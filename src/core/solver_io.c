@@ -0,0 +1,923 @@
+#include "pard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* 求解器状态文件格式 */
+#define PARD_STATE_MAGIC "PARDSLV"
+#define PARD_STATE_VERSION 1u
+#define PARD_STATE_ENDIAN 0x01020304u
+#define PARD_STATE_ALIGN 64
+#define PARD_STATE_CHECKSUM_SEED 0xcbf29ce484222325ULL
+/* 固定段的个数，其后每个面板8段 */
+#define PARD_STATE_FIXED_SECTIONS 25
+#define PARD_STATE_PANEL_SECTIONS 8
+/* 段长由数据决定（读入时先不检查，数组读入后再核对） */
+#define PARD_STATE_ANY ((size_t)-1)
+
+/* 前向声明 */
+extern uint64_t pard_bin_checksum(uint64_t h, const void *data, size_t len);
+extern void pard_free_factors(pard_factors_t *factors);
+
+/**
+ * 状态文件头。文件布局：文件头、段表（每段的偏移与字节数，偏移为0表示数组不存在），
+ * 随后各段依次存放，起点按PARD_STATE_ALIGN对齐。段的顺序固定：
+ * 求解器的置换与数值映射、重排后的矩阵、CSR因子、超节点结构、面板索引与面板描述，
+ * 最后是每个面板的rows/cols/L/U/Lf/Uf/piv/d。校验和覆盖段表和全部段
+ */
+typedef struct {
+    char magic[8];              /* PARD_STATE_MAGIC */
+    uint32_t version;
+    uint32_t endian;            /* PARD_STATE_ENDIAN，按写入端的字节序存放 */
+    uint32_t index_size;        /* sizeof(int) */
+    uint32_t has_numeric;       /* 保存时已完成数值分解（有面板） */
+    int32_t n;
+    int32_t matrix_type;
+    int32_t ordering;
+    int32_t ordering_used;
+    int32_t relax_max_cols;
+    int32_t mixed_precision;
+    int32_t refine_method;
+    int32_t refine_restart;
+    int32_t work_max_nrhs;
+    int32_t user_perm_n;
+    int32_t value_map_nnz;
+    int32_t a_nnz;
+    int32_t a_is_symmetric;
+    int32_t a_is_upper;
+    int32_t f_nnz;
+    int32_t nsuper;
+    int32_t npanels;
+    int32_t single_precision;
+    int32_t fill_in_nnz;
+    int32_t csr_factors;
+    double relax_max_zeros;
+    double analysis_time;
+    double factorization_time;
+    uint64_t nsections;
+    uint64_t table_offset;
+    uint64_t file_size;
+    uint64_t checksum;
+} pard_state_header_t;
+
+/* 段表项 */
+typedef struct {
+    uint64_t offset;
+    uint64_t bytes;
+} pard_state_entry_t;
+
+/* 一个段对应的数组字段 */
+typedef struct {
+    void **ptr;         /* 数组字段的地址 */
+    size_t bytes;       /* 期望的字节数，PARD_STATE_ANY表示由数据决定 */
+    int required;       /* 读入时必须存在 */
+    int mappable;       /* 映射读入时直接指向映射区（因子数组），否则复制 */
+} state_section_t;
+
+static uint64_t state_align(uint64_t offset) {
+    return (offset + PARD_STATE_ALIGN - 1) / PARD_STATE_ALIGN * PARD_STATE_ALIGN;
+}
+
+static void state_set(state_section_t *sec, void *ptr, size_t bytes, int required,
+                      int mappable) {
+    sec->ptr = (void **)ptr;
+    sec->bytes = bytes;
+    sec->required = required;
+    sec->mappable = mappable;
+}
+
+/**
+ * 固定段。known非0时由已有数组算出全部段长（保存，或读入后核对），
+ * 否则依赖数组内容的段长为PARD_STATE_ANY
+ */
+static void state_fixed_sections(pard_solver_t *s, int **panel_info, int known,
+                                 state_section_t *sec) {
+    const pard_csr_matrix_t *A = s->matrix;
+    pard_factors_t *f = s->factors;
+    size_t n = (size_t)A->n;
+    size_t ns = (size_t)f->nsuper;
+    size_t isz = sizeof(int), dsz = sizeof(double);
+    int numeric = (f->npanels > 0);
+    size_t l_nnz = (f->row_ptr != NULL) ? (size_t)f->row_ptr[n] : 0;
+    size_t u_nnz = (f->u_row_ptr != NULL) ? (size_t)f->u_row_ptr[n] : 0;
+    size_t s_nnz = (f->super_row_ptr != NULL) ? (size_t)f->super_row_ptr[ns] : 0;
+
+    state_set(&sec[0], &s->perm, n * isz, 1, 0);
+    state_set(&sec[1], &s->inv_perm, n * isz, 1, 0);
+    state_set(&sec[2], &s->user_perm, (size_t)s->user_perm_n * isz, 0, 0);
+    state_set(&sec[3], &s->value_map, (size_t)s->value_map_nnz * isz, 0, 0);
+    state_set(&sec[4], &s->matrix->row_ptr, (n + 1) * isz, 1, 0);
+    state_set(&sec[5], &s->matrix->col_idx, (size_t)A->nnz * isz, A->nnz > 0, 0);
+    state_set(&sec[6], &s->matrix->values, (size_t)A->nnz * dsz, A->nnz > 0, 0);
+    state_set(&sec[7], &f->row_ptr, (n + 1) * isz, 0, 1);
+    state_set(&sec[8], &f->col_idx, known ? l_nnz * isz : PARD_STATE_ANY, 0, 1);
+    state_set(&sec[9], &f->l_values, known ? l_nnz * dsz : PARD_STATE_ANY, 0, 1);
+    state_set(&sec[10], &f->u_row_ptr, (n + 1) * isz, 0, 1);
+    state_set(&sec[11], &f->u_col_idx, known ? u_nnz * isz : PARD_STATE_ANY, 0, 1);
+    state_set(&sec[12], &f->u_values, known ? u_nnz * dsz : PARD_STATE_ANY, 0, 1);
+    state_set(&sec[13], &f->perm, n * isz, 0, 1);
+    state_set(&sec[14], &f->col_perm, n * isz, 0, 1);
+    state_set(&sec[15], &f->d_values, n * dsz, 0, 1);
+    state_set(&sec[16], &f->d_offdiag, n * dsz, 0, 1);
+    state_set(&sec[17], &f->pivot_type, n * isz, 0, 1);
+    state_set(&sec[18], &f->super_ptr, (ns + 1) * isz, 1, 1);
+    state_set(&sec[19], &f->super_parent, ns * isz, 1, 1);
+    state_set(&sec[20], &f->super_row_ptr, (ns + 1) * isz, 1, 1);
+    state_set(&sec[21], &f->super_row_idx, known ? s_nnz * isz : PARD_STATE_ANY, 1, 1);
+    state_set(&sec[22], &f->row_panel, n * isz, numeric, 1);
+    state_set(&sec[23], &f->col_panel, n * isz, 0, 1);
+    state_set(&sec[24], panel_info, 3 * (size_t)f->npanels * isz, numeric, 0);
+}
+
+/**
+ * 一个面板的8个段：rows、cols（LU）为m个索引，L、U为m×k双精度块，
+ * Lf、Uf为单精度块（混合精度），piv为k个主元类型，d为2k+1个D的元素（LDL^T）
+ */
+static void state_panel_sections(pard_panel_t *P, state_section_t *sec) {
+    size_t m = (size_t)P->m, k = (size_t)P->k;
+    state_set(&sec[0], &P->rows, m * sizeof(int), 1, 1);
+    state_set(&sec[1], &P->cols, m * sizeof(int), 0, 1);
+    state_set(&sec[2], &P->L, m * k * sizeof(double), 0, 1);
+    state_set(&sec[3], &P->U, m * k * sizeof(double), 0, 1);
+    state_set(&sec[4], &P->Lf, m * k * sizeof(float), 0, 1);
+    state_set(&sec[5], &P->Uf, m * k * sizeof(float), 0, 1);
+    state_set(&sec[6], &P->piv, k * sizeof(int), 0, 1);
+    state_set(&sec[7], &P->d, (2 * k + 1) * sizeof(double), 0, 1);
+}
+
+/**
+ * 写出一段数据，累加校验和，并以零填充到next
+ */
+static int state_write_bytes(FILE *fp, const void *data, size_t len, uint64_t *pos,
+                             uint64_t next, uint64_t *checksum) {
+    static const char zeros[PARD_STATE_ALIGN] = {0};
+    if (len > 0 && fwrite(data, 1, len, fp) != len) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    if (checksum != NULL) {
+        *checksum = pard_bin_checksum(*checksum, data, len);
+    }
+    *pos += len;
+    while (*pos < next) {
+        size_t pad = (size_t)(next - *pos);
+        if (pad > sizeof(zeros)) {
+            pad = sizeof(zeros);
+        }
+        if (fwrite(zeros, 1, pad, fp) != pad) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+        *pos += pad;
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 从第i段起第一个存在的段，没有时返回nsec
+ */
+static size_t state_next_section(const pard_state_entry_t *table, size_t nsec, size_t i) {
+    while (i < nsec && table[i].offset == 0) {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * 保存求解器状态（pardiso_save的实现）：需要已完成符号分析，数值分解可有可无
+ */
+int pard_state_write(const pard_solver_t *solver, const char *filename) {
+    if (solver == NULL || filename == NULL || solver->matrix == NULL ||
+        solver->factors == NULL || solver->perm == NULL || solver->inv_perm == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    /* 段描述需要字段地址，但只读取 */
+    pard_solver_t *s = (pard_solver_t *)solver;
+    const pard_factors_t *f = s->factors;
+    int np = (f->panels != NULL) ? f->npanels : 0;
+    size_t nsec = PARD_STATE_FIXED_SECTIONS + (size_t)PARD_STATE_PANEL_SECTIONS * np;
+
+    state_section_t *sec = (state_section_t *)malloc(nsec * sizeof(state_section_t));
+    pard_state_entry_t *table = (pard_state_entry_t *)calloc(nsec, sizeof(pard_state_entry_t));
+    int *panel_info = (int *)malloc((3 * (size_t)np + 1) * sizeof(int));
+    if (sec == NULL || table == NULL || panel_info == NULL) {
+        free(sec);
+        free(table);
+        free(panel_info);
+        return PARD_ERROR_MEMORY;
+    }
+    for (int p = 0; p < np; p++) {
+        panel_info[3 * p] = f->panels[p].m;
+        panel_info[3 * p + 1] = f->panels[p].k;
+        panel_info[3 * p + 2] = f->panels[p].parent;
+    }
+    int *info_ptr = (np > 0) ? panel_info : NULL;
+    state_fixed_sections(s, &info_ptr, 1, sec);
+    for (int p = 0; p < np; p++) {
+        state_panel_sections(&f->panels[p], sec + PARD_STATE_FIXED_SECTIONS +
+                                            (size_t)PARD_STATE_PANEL_SECTIONS * p);
+    }
+
+    pard_state_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, PARD_STATE_MAGIC, sizeof(hdr.magic));
+    hdr.version = PARD_STATE_VERSION;
+    hdr.endian = PARD_STATE_ENDIAN;
+    hdr.index_size = (uint32_t)sizeof(int);
+    hdr.has_numeric = (np > 0);
+    hdr.n = s->matrix->n;
+    hdr.matrix_type = s->matrix_type;
+    hdr.ordering = s->ordering;
+    hdr.ordering_used = s->ordering_used;
+    hdr.relax_max_cols = s->relax_max_cols;
+    hdr.mixed_precision = s->mixed_precision;
+    hdr.csr_factors = s->csr_factors;
+    hdr.refine_method = s->refine_method;
+    hdr.refine_restart = s->refine_restart;
+    hdr.work_max_nrhs = s->work_max_nrhs;
+    hdr.user_perm_n = (s->user_perm != NULL) ? s->user_perm_n : 0;
+    hdr.value_map_nnz = (s->value_map != NULL) ? s->value_map_nnz : 0;
+    hdr.a_nnz = s->matrix->nnz;
+    hdr.a_is_symmetric = s->matrix->is_symmetric;
+    hdr.a_is_upper = s->matrix->is_upper;
+    hdr.f_nnz = f->nnz;
+    hdr.nsuper = f->nsuper;
+    hdr.npanels = np;
+    hdr.single_precision = f->single_precision;
+    hdr.fill_in_nnz = s->fill_in_nnz;
+    hdr.relax_max_zeros = s->relax_max_zeros;
+    hdr.analysis_time = s->analysis_time;
+    hdr.factorization_time = s->factorization_time;
+    hdr.nsections = nsec;
+    hdr.table_offset = state_align(sizeof(hdr));
+
+    /* 布局：不存在的数组偏移为0 */
+    uint64_t pos = state_align(hdr.table_offset + nsec * sizeof(pard_state_entry_t));
+    for (size_t i = 0; i < nsec; i++) {
+        if (*sec[i].ptr != NULL) {
+            table[i].offset = pos;
+            table[i].bytes = sec[i].bytes;
+            pos = state_align(pos + sec[i].bytes);
+        }
+    }
+    hdr.file_size = pos;
+    /* 最后一段之后不填充 */
+    for (size_t i = nsec; i > 0; i--) {
+        if (table[i - 1].offset != 0) {
+            hdr.file_size = table[i - 1].offset + table[i - 1].bytes;
+            break;
+        }
+    }
+
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        free(sec);
+        free(table);
+        free(panel_info);
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    /* 文件头不计入校验和；段表与各段之后填充到下一个存在的段 */
+    uint64_t checksum = PARD_STATE_CHECKSUM_SEED;
+    pos = 0;
+    int err = state_write_bytes(fp, &hdr, sizeof(hdr), &pos, hdr.table_offset, NULL);
+    size_t next = state_next_section(table, nsec, 0);
+    if (err == PARD_SUCCESS) {
+        err = state_write_bytes(fp, table, nsec * sizeof(pard_state_entry_t), &pos,
+                                (next < nsec) ? table[next].offset : hdr.file_size, &checksum);
+    }
+    while (next < nsec && err == PARD_SUCCESS) {
+        size_t i = next;
+        next = state_next_section(table, nsec, i + 1);
+        err = state_write_bytes(fp, *sec[i].ptr, sec[i].bytes, &pos,
+                                (next < nsec) ? table[next].offset : hdr.file_size, &checksum);
+    }
+    if (err == PARD_SUCCESS) {
+        hdr.checksum = checksum;
+        if (fseek(fp, 0, SEEK_SET) != 0 || fwrite(&hdr, sizeof(hdr), 1, fp) != 1) {
+            err = PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    if (fclose(fp) != 0 && err == PARD_SUCCESS) {
+        err = PARD_ERROR_INVALID_INPUT;
+    }
+
+    free(sec);
+    free(table);
+    free(panel_info);
+    return err;
+}
+
+/**
+ * 检查文件头与段表：各段在文件之内、对齐且位于段表之后
+ */
+static int state_check_layout(const pard_state_header_t *hdr, const pard_state_entry_t *table,
+                              uint64_t size) {
+    if (memcmp(hdr->magic, PARD_STATE_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version == 0 || hdr->version > PARD_STATE_VERSION ||
+        hdr->endian != PARD_STATE_ENDIAN || hdr->index_size != sizeof(int) ||
+        hdr->file_size != size || hdr->n <= 0 || hdr->n == 2147483647 ||
+        hdr->nsuper < 0 || hdr->nsuper > hdr->n || hdr->npanels < 0 ||
+        hdr->a_nnz < 0 || hdr->user_perm_n < 0 || hdr->value_map_nnz < 0 ||
+        hdr->nsections != PARD_STATE_FIXED_SECTIONS +
+                          (uint64_t)PARD_STATE_PANEL_SECTIONS * hdr->npanels ||
+        hdr->table_offset < sizeof(*hdr) || hdr->table_offset % PARD_STATE_ALIGN != 0 ||
+        hdr->table_offset + hdr->nsections * sizeof(pard_state_entry_t) > size) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    if (table == NULL) {
+        return PARD_SUCCESS;
+    }
+    uint64_t table_end = hdr->table_offset + hdr->nsections * sizeof(pard_state_entry_t);
+    for (uint64_t i = 0; i < hdr->nsections; i++) {
+        uint64_t off = table[i].offset, bytes = table[i].bytes;
+        if (off == 0) {
+            if (bytes != 0) {
+                return PARD_ERROR_INVALID_INPUT;
+            }
+        } else if (off % PARD_STATE_ALIGN != 0 || off < table_end || bytes > size ||
+                   off > size - bytes) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 按段描述读入一组段：映射模式下可映射的段直接指向data，其余复制到新分配的数组
+ */
+static int state_load_sections(const state_section_t *sec, const pard_state_entry_t *table,
+                               size_t count, char *data, int map) {
+    for (size_t i = 0; i < count; i++) {
+        if (table[i].offset == 0) {
+            if (sec[i].required) {
+                return PARD_ERROR_INVALID_INPUT;
+            }
+            continue;
+        }
+        size_t bytes = (size_t)table[i].bytes;
+        if (sec[i].bytes != PARD_STATE_ANY && bytes != sec[i].bytes) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+        if (map && sec[i].mappable) {
+            *sec[i].ptr = data + table[i].offset;
+        } else {
+            void *buf = malloc(bytes > 0 ? bytes : 1);
+            if (buf == NULL) {
+                return PARD_ERROR_MEMORY;
+            }
+            memcpy(buf, data + table[i].offset, bytes);
+            *sec[i].ptr = buf;
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 因子的CSR结构（符号分解的结构或导出的因子）：行指针从0开始且不减，列号在[0, n)内，
+ * 有数值时必须有结构。数组长度已由段长核对
+ */
+static int state_check_csr(const int *row_ptr, const int *col_idx, const double *values,
+                           int n) {
+    if (values != NULL && (row_ptr == NULL || col_idx == NULL)) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    if (row_ptr == NULL) {
+        return PARD_SUCCESS;
+    }
+    if (row_ptr[0] != 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    for (int i = 0; i < n; i++) {
+        if (row_ptr[i + 1] < row_ptr[i]) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    for (int p = 0; col_idx != NULL && p < row_ptr[n]; p++) {
+        if (col_idx[p] < 0 || col_idx[p] >= n) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 导出的LDL^T主元类型：1或2，2x2块的两行都为2且成对出现，有主元类型时必须有D与L
+ */
+static int state_check_pivots(const pard_factors_t *f, int n) {
+    if (f->pivot_type == NULL) {
+        return PARD_SUCCESS;
+    }
+    if (f->d_values == NULL || f->d_offdiag == NULL || f->l_values == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    for (int i = 0; i < n; i++) {
+        if (f->pivot_type[i] == 2) {
+            if (i + 1 >= n || f->pivot_type[i + 1] != 2) {
+                return PARD_ERROR_INVALID_INPUT;
+            }
+            i++;
+        } else if (f->pivot_type[i] != 1) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 检查读入的数组之间的一致性：矩阵的CSR结构、置换互逆、数值映射指向矩阵之内，
+ * 超节点划分严格递增、行指针不减、父超节点为-1或编号更大的超节点，
+ * 因子的CSR结构与LDL^T主元类型合法，超节点行索引与主元顺序在[0, n)内，没有数值分解（has_numeric为0）时不应带有面板索引段
+ */
+static int state_check_arrays(const pard_solver_t *s, const pard_state_header_t *hdr) {
+    const pard_csr_matrix_t *A = s->matrix;
+    const pard_factors_t *f = s->factors;
+    int n = A->n;
+    if (A->row_ptr[0] != 0 || A->row_ptr[n] != A->nnz ||
+        f->super_ptr[0] != 0 || f->super_ptr[f->nsuper] != f->n ||
+        (s->user_perm != NULL) != (hdr->user_perm_n > 0) ||
+        (s->value_map != NULL) != (hdr->value_map_nnz > 0) ||
+        (!hdr->has_numeric && (f->row_panel != NULL || f->col_panel != NULL))) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    for (int i = 0; i < n; i++) {
+        if (A->row_ptr[i + 1] < A->row_ptr[i] || s->perm[i] < 0 || s->perm[i] >= n ||
+            s->inv_perm[s->perm[i]] != i) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    for (int p = 0; p < A->nnz; p++) {
+        if (A->col_idx[p] < 0 || A->col_idx[p] >= n) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    if (f->super_row_ptr[0] != 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    for (int t = 0; t < f->nsuper; t++) {
+        int parent = f->super_parent[t];
+        if (f->super_ptr[t + 1] <= f->super_ptr[t] ||
+            f->super_row_ptr[t + 1] < f->super_row_ptr[t] ||
+            (parent != -1 && (parent <= t || parent >= f->nsuper))) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    for (int q = 0; s->value_map != NULL && q < s->value_map_nnz; q++) {
+        if (s->value_map[q] < 0 || s->value_map[q] >= A->nnz) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    for (int q = 0; q < f->super_row_ptr[f->nsuper]; q++) {
+        if (f->super_row_idx[q] < 0 || f->super_row_idx[q] >= n) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    if (state_check_csr(f->row_ptr, f->col_idx, f->l_values, n) != PARD_SUCCESS ||
+        state_check_csr(f->u_row_ptr, f->u_col_idx, f->u_values, n) != PARD_SUCCESS ||
+        state_check_pivots(f, n) != PARD_SUCCESS) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    for (int i = 0; i < n; i++) {
+        if ((f->perm != NULL && (f->perm[i] < 0 || f->perm[i] >= n)) ||
+            (f->col_perm != NULL && (f->col_perm[i] < 0 || f->col_perm[i] >= n)) ||
+            (f->row_panel != NULL && (f->row_panel[i] < 0 || f->row_panel[i] >= hdr->npanels)) ||
+            (f->col_panel != NULL && (f->col_panel[i] < 0 || f->col_panel[i] >= hdr->npanels))) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 检查超节点行结构能容纳分解时组装的波前：每个超节点的行索引位于自身的列之后，
+ * 且属于父超节点的列或行结构（扩展加时子节点的贡献块必须落在父波前之内）；
+ * 矩阵的每个元素(i,j)属于min(i,j)所在超节点的列或行结构。
+ * 在state_check_arrays之后调用，此时划分与行指针已知合法
+ */
+static int state_check_structure(const pard_solver_t *s) {
+    const pard_csr_matrix_t *A = s->matrix;
+    const pard_factors_t *f = s->factors;
+    int n = f->n;
+    int ns = f->nsuper;
+    const int *sp = f->super_ptr;
+    const int *rp = f->super_row_ptr;
+    const int *ri = f->super_row_idx;
+    int nrows = rp[ns];
+    int *col_to_super = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *rmark = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *row_ptr = (int *)calloc(n + 1, sizeof(int));
+    int *row_super = (int *)malloc((nrows > 0 ? nrows : 1) * sizeof(int));
+    int *smark = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    int *head = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    int *next = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    int err = PARD_SUCCESS;
+    if (col_to_super == NULL || rmark == NULL || row_ptr == NULL || row_super == NULL ||
+        smark == NULL || head == NULL || next == NULL) {
+        err = PARD_ERROR_MEMORY;
+    }
+
+    for (int t = 0; err == PARD_SUCCESS && t < ns; t++) {
+        for (int j = sp[t]; j < sp[t + 1]; j++) {
+            col_to_super[j] = t;
+        }
+        head[t] = -1;
+        smark[t] = -1;
+    }
+    for (int t = ns - 1; err == PARD_SUCCESS && t >= 0; t--) {
+        if (f->super_parent[t] != -1) {
+            next[t] = head[f->super_parent[t]];
+            head[f->super_parent[t]] = t;
+        }
+    }
+    for (int i = 0; err == PARD_SUCCESS && i < n; i++) {
+        rmark[i] = -1;
+    }
+
+    /* 子超节点的行属于父超节点的列或行结构 */
+    for (int t = 0; err == PARD_SUCCESS && t < ns; t++) {
+        for (int q = rp[t]; q < rp[t + 1]; q++) {
+            rmark[ri[q]] = t;
+        }
+        for (int c = head[t]; c != -1 && err == PARD_SUCCESS; c = next[c]) {
+            for (int q = rp[c]; q < rp[c + 1]; q++) {
+                if (ri[q] < sp[c + 1] || (col_to_super[ri[q]] != t && rmark[ri[q]] != t)) {
+                    err = PARD_ERROR_INVALID_INPUT;
+                    break;
+                }
+            }
+        }
+    }
+
+    /* 行结构按行转置：row_super列出行号出现在其行结构中的超节点 */
+    for (int q = 0; err == PARD_SUCCESS && q < nrows; q++) {
+        row_ptr[ri[q] + 1]++;
+    }
+    for (int i = 0; err == PARD_SUCCESS && i < n; i++) {
+        row_ptr[i + 1] += row_ptr[i];
+    }
+    for (int t = 0; err == PARD_SUCCESS && t < ns; t++) {
+        for (int q = rp[t]; q < rp[t + 1]; q++) {
+            row_super[row_ptr[ri[q]]++] = t;
+        }
+    }
+    for (int i = n; err == PARD_SUCCESS && i > 0; i--) {
+        row_ptr[i] = row_ptr[i - 1];
+    }
+    if (err == PARD_SUCCESS) {
+        row_ptr[0] = 0;
+    }
+
+    /* 矩阵元素：上三角(i,j>i)查i所在超节点的行结构，下三角(i,j<i)查j所在超节点是否含行i */
+    int cur = -1;
+    for (int i = 0; err == PARD_SUCCESS && i < n; i++) {
+        if (col_to_super[i] != cur) {
+            cur = col_to_super[i];
+            for (int q = rp[cur]; q < rp[cur + 1]; q++) {
+                rmark[ri[q]] = n + cur;
+            }
+        }
+        for (int q = row_ptr[i]; q < row_ptr[i + 1]; q++) {
+            smark[row_super[q]] = i;
+        }
+        for (int p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++) {
+            int j = A->col_idx[p];
+            int owner = col_to_super[j];
+            if (owner != cur && ((j > i && rmark[j] != n + cur) || (j < i && smark[owner] != i))) {
+                err = PARD_ERROR_INVALID_INPUT;
+                break;
+            }
+        }
+    }
+
+    free(col_to_super);
+    free(rmark);
+    free(row_ptr);
+    free(row_super);
+    free(smark);
+    free(head);
+    free(next);
+    return err;
+}
+
+/**
+ * 面板大小与超节点划分一致：面板与超节点一一对应且父面板相同，
+ * 面板行数为波前的全和列数（超节点的列数加子面板推迟的主元数）加超节点行结构的行数，
+ * 主元数不超过全和列数，未消去的主元推迟到父面板，根面板不能再推迟
+ */
+static int state_check_panel_sizes(const pard_factors_t *f, const int *panel_info, int np) {
+    if (np == 0) {
+        return PARD_SUCCESS;
+    }
+    if (np != f->nsuper) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    int *delayed = (int *)calloc(np, sizeof(int));
+    if (delayed == NULL) {
+        return PARD_ERROR_MEMORY;
+    }
+    int err = PARD_SUCCESS;
+    for (int t = 0; t < np; t++) {
+        int m = panel_info[3 * t];
+        int k = panel_info[3 * t + 1];
+        int parent = panel_info[3 * t + 2];
+        int ncol = f->super_ptr[t + 1] - f->super_ptr[t];
+        int nfull = m - (f->super_row_ptr[t + 1] - f->super_row_ptr[t]);
+        if (parent != f->super_parent[t] || k < 0 || nfull != ncol + delayed[t] || k > nfull ||
+            (parent == -1 && k != nfull)) {
+            err = PARD_ERROR_INVALID_INPUT;
+            break;
+        }
+        if (parent != -1) {
+            delayed[parent] += nfull - k;
+        }
+    }
+    free(delayed);
+    return err;
+}
+
+/**
+ * 面板的行（列）索引在[0, n)内，且带有求解所需的数值（k>0时）：
+ * L（单精度模式为Lf），LU另需cols与U（Uf），LDL^T另需piv与d
+ */
+static int state_check_panel(const pard_panel_t *P, const pard_factors_t *f) {
+    int is_ldlt = (f->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF);
+    int is_lu = !is_ldlt && f->matrix_type != PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF;
+    const void *L = f->single_precision ? (const void *)P->Lf : (const void *)P->L;
+    const void *U = f->single_precision ? (const void *)P->Uf : (const void *)P->U;
+    if (P->k > 0 && (L == NULL || (is_lu && (P->cols == NULL || U == NULL)) ||
+        (is_ldlt && (P->piv == NULL || P->d == NULL)))) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    for (int i = 0; i < P->m; i++) {
+        if (P->rows[i] < 0 || P->rows[i] >= f->n ||
+            (P->cols != NULL && (P->cols[i] < 0 || P->cols[i] >= f->n))) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 读入失败时释放已读入的全部数组，把solver恢复为读入前的saved
+ */
+static void state_rollback(pard_solver_t *solver, const pard_solver_t *saved) {
+    if (solver->matrix != saved->matrix) {
+        pard_csr_free(&solver->matrix);
+    }
+    if (solver->perm != saved->perm) {
+        free(solver->perm);
+    }
+    if (solver->inv_perm != saved->inv_perm) {
+        free(solver->inv_perm);
+    }
+    if (solver->user_perm != saved->user_perm) {
+        free(solver->user_perm);
+    }
+    if (solver->value_map != saved->value_map) {
+        free(solver->value_map);
+    }
+    if (solver->factors != saved->factors) {
+        pard_free_factors(solver->factors);
+    }
+    *solver = *saved;
+}
+
+/**
+ * 读入求解器状态（pardiso_load的实现），solver为pardiso_init得到的空求解器。
+ * 失败时释放已读入的全部内容（包括映射），solver保持调用前的状态
+ */
+int pard_state_read(pard_solver_t *solver, const char *filename, int mode) {
+    if (solver == NULL || filename == NULL || solver->matrix != NULL ||
+        solver->factors != NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    struct stat st;
+    pard_state_header_t hdr;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(hdr)) {
+        close(fd);
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    size_t size = (size_t)st.st_size;
+    int map = (mode & PARD_BIN_MMAP) != 0;
+    char *data = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return PARD_ERROR_MEMORY;
+    }
+    memcpy(&hdr, data, sizeof(hdr));
+    if (state_check_layout(&hdr, NULL, size) != PARD_SUCCESS ||
+        hdr.has_numeric != (uint32_t)(hdr.npanels > 0)) {
+        munmap(data, size);
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    const pard_state_entry_t *table = (const pard_state_entry_t *)(data + hdr.table_offset);
+    if (state_check_layout(&hdr, table, size) != PARD_SUCCESS) {
+        munmap(data, size);
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    if (mode & PARD_BIN_VERIFY) {
+        uint64_t h = PARD_STATE_CHECKSUM_SEED;
+        h = pard_bin_checksum(h, table, hdr.nsections * sizeof(pard_state_entry_t));
+        for (uint64_t i = 0; i < hdr.nsections; i++) {
+            if (table[i].offset != 0) {
+                h = pard_bin_checksum(h, data + table[i].offset, (size_t)table[i].bytes);
+            }
+        }
+        if (h != hdr.checksum) {
+            munmap(data, size);
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+
+    pard_csr_matrix_t *A = (pard_csr_matrix_t *)calloc(1, sizeof(pard_csr_matrix_t));
+    pard_factors_t *f = (pard_factors_t *)calloc(1, sizeof(pard_factors_t));
+    if (A == NULL || f == NULL) {
+        free(A);
+        free(f);
+        munmap(data, size);
+        return PARD_ERROR_MEMORY;
+    }
+    A->n = hdr.n;
+    A->nnz = hdr.a_nnz;
+    A->is_symmetric = hdr.a_is_symmetric;
+    A->is_upper = hdr.a_is_upper;
+    f->n = hdr.n;
+    f->nnz = hdr.f_nnz;
+    f->nsuper = hdr.nsuper;
+    f->single_precision = hdr.single_precision;
+    f->matrix_type = (pard_matrix_type_t)hdr.matrix_type;
+    if (map) {
+        f->mapping = data;
+        f->mapping_size = size;
+    }
+    pard_solver_t saved = *solver;
+    solver->matrix = A;
+    solver->owns_matrix = 1;
+    solver->factors = f;
+    solver->matrix_type = (pard_matrix_type_t)hdr.matrix_type;
+    solver->ordering = (pard_ordering_t)hdr.ordering;
+    solver->ordering_used = (pard_ordering_t)hdr.ordering_used;
+    solver->relax_max_cols = hdr.relax_max_cols;
+    solver->relax_max_zeros = hdr.relax_max_zeros;
+    solver->mixed_precision = hdr.mixed_precision;
+    solver->csr_factors = hdr.csr_factors;
+    solver->refine_method = (pard_refinement_t)hdr.refine_method;
+    solver->refine_restart = hdr.refine_restart;
+    solver->work_max_nrhs = hdr.work_max_nrhs;
+    solver->user_perm_n = hdr.user_perm_n;
+    solver->value_map_nnz = hdr.value_map_nnz;
+    solver->fill_in_nnz = hdr.fill_in_nnz;
+    solver->analysis_time = hdr.analysis_time;
+    solver->factorization_time = hdr.factorization_time;
+
+    /* 固定段：先按文件头可知的长度读入，再按读入的数组核对其余段长 */
+    state_section_t fixed[PARD_STATE_FIXED_SECTIONS];
+    state_section_t check[PARD_STATE_FIXED_SECTIONS];
+    int *panel_info = NULL;
+    int np = hdr.npanels;
+    f->npanels = np;  /* 只用于计算段长，面板建立前清零 */
+    state_fixed_sections(solver, &panel_info, 0, fixed);
+    f->npanels = 0;
+    int err = state_load_sections(fixed, table, PARD_STATE_FIXED_SECTIONS, data, map);
+    if (err == PARD_SUCCESS) {
+        f->npanels = np;
+        state_fixed_sections(solver, &panel_info, 1, check);
+        f->npanels = 0;
+        for (int i = 0; i < PARD_STATE_FIXED_SECTIONS; i++) {
+            if (table[i].offset != 0 && table[i].bytes != check[i].bytes) {
+                err = PARD_ERROR_INVALID_INPUT;
+            }
+        }
+    }
+    if (err == PARD_SUCCESS) {
+        err = state_check_arrays(solver, &hdr);
+    }
+    if (err == PARD_SUCCESS) {
+        err = state_check_structure(solver);
+    }
+    if (err == PARD_SUCCESS) {
+        err = state_check_panel_sizes(f, panel_info, np);
+    }
+
+    /* 面板 */
+    if (err == PARD_SUCCESS && np > 0) {
+        f->panels = (pard_panel_t *)calloc(np, sizeof(pard_panel_t));
+        if (f->panels == NULL) {
+            err = PARD_ERROR_MEMORY;
+        } else {
+            f->npanels = np;
+        }
+    }
+    for (int p = 0; p < np && err == PARD_SUCCESS; p++) {
+        pard_panel_t *P = &f->panels[p];
+        P->m = panel_info[3 * p];
+        P->k = panel_info[3 * p + 1];
+        P->parent = panel_info[3 * p + 2];
+        if (P->k < 0 || P->m < P->k || P->parent < -1 || P->parent >= np) {
+            err = PARD_ERROR_INVALID_INPUT;
+            break;
+        }
+        state_section_t psec[PARD_STATE_PANEL_SECTIONS];
+        state_panel_sections(P, psec);
+        err = state_load_sections(psec, table + PARD_STATE_FIXED_SECTIONS +
+                                  (size_t)PARD_STATE_PANEL_SECTIONS * p,
+                                  PARD_STATE_PANEL_SECTIONS, data, map);
+        if (err == PARD_SUCCESS) {
+            err = state_check_panel(P, f);
+        }
+    }
+
+    free(panel_info);
+    if (err != PARD_SUCCESS) {
+        /* 映射模式下映射随因子由pard_free_factors解除 */
+        state_rollback(solver, &saved);
+    }
+    if (!map) {
+        munmap(data, size);
+    }
+    return err;
+}
+
+/**
+ * 解除pardiso_load映射模式下因子对状态文件的映射：
+ * 释放读入时分配的面板描述数组与求解调度，指向映射区的数组全部置空
+ */
+void pard_factors_unmap(pard_factors_t *f) {
+    if (f == NULL || f->mapping == NULL) {
+        return;
+    }
+    free(f->panels);
+    free(f->panel_owner);
+    free(f->top_row_index);
+    free(f->top_col_index);
+    munmap(f->mapping, f->mapping_size);
+
+    f->row_ptr = NULL;
+    f->col_idx = NULL;
+    f->l_values = NULL;
+    f->u_row_ptr = NULL;
+    f->u_col_idx = NULL;
+    f->u_values = NULL;
+    f->perm = NULL;
+    f->col_perm = NULL;
+    f->d_values = NULL;
+    f->d_offdiag = NULL;
+    f->pivot_type = NULL;
+    f->super_ptr = NULL;
+    f->super_parent = NULL;
+    f->super_row_ptr = NULL;
+    f->super_row_idx = NULL;
+    f->npanels = 0;
+    f->panels = NULL;
+    f->row_panel = NULL;
+    f->col_panel = NULL;
+    f->sched_nthreads = 0;
+    f->panel_owner = NULL;
+    f->ntop_rows = 0;
+    f->top_row_index = NULL;
+    f->top_col_index = NULL;
+    f->mapping = NULL;
+    f->mapping_size = 0;
+}
+
+/**
+ * 重新数值分解前把映射读入的因子转为自有内存：
+ * 复制数值分解需要的超节点结构，其余数组（因子数值与面板）由分解重新生成
+ */
+int pard_factors_detach(pard_factors_t *f) {
+    if (f == NULL || f->mapping == NULL) {
+        return PARD_SUCCESS;
+    }
+    int ns = f->nsuper;
+    int nrows = f->super_row_ptr[ns];
+    int *super_ptr = (int *)malloc((ns + 1) * sizeof(int));
+    int *super_parent = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    int *super_row_ptr = (int *)malloc((ns + 1) * sizeof(int));
+    int *super_row_idx = (int *)malloc((nrows > 0 ? nrows : 1) * sizeof(int));
+    if (super_ptr == NULL || super_parent == NULL || super_row_ptr == NULL ||
+        super_row_idx == NULL) {
+        free(super_ptr);
+        free(super_parent);
+        free(super_row_ptr);
+        free(super_row_idx);
+        return PARD_ERROR_MEMORY;
+    }
+    memcpy(super_ptr, f->super_ptr, (ns + 1) * sizeof(int));
+    memcpy(super_parent, f->super_parent, ns * sizeof(int));
+    memcpy(super_row_ptr, f->super_row_ptr, (ns + 1) * sizeof(int));
+    memcpy(super_row_idx, f->super_row_idx, nrows * sizeof(int));
+
+    pard_factors_unmap(f);
+    f->super_ptr = super_ptr;
+    f->super_parent = super_parent;
+    f->super_row_ptr = super_row_ptr;
+    f->super_row_idx = super_row_idx;
+    return PARD_SUCCESS;
+}
@@ -2,78 +2,79 @@
 #include <stdlib.h>
 #include <math.h>
 
+/* 前向声明 */
+extern int pard_multifrontal_factorization(pard_solver_t *solver);
+extern void pard_dense_gemm_lower_mt(int m, int n, int k,
+                                     const double *A, int lda,
+                                     const double *B, int ldb,
+                                     double *C, int ldc, int nthreads);
+
+/* 完全求和列的分块宽度 */
+#define PARD_CHOL_BLOCK 64
+
 /**
- * Cholesky分解：A = L * L^T（对称正定矩阵）
+ * 波前矩阵的部分Cholesky分解
+ * F为m×m列主序矩阵（仅使用下三角），消去前k列后，
+ * 右下角(m-k)×(m-k)块被更新为传给父波前的Schur补。
+ * 块更新和Schur补由nthreads个线程按列划分并行执行
  */
-int pard_cholesky_factorization(pard_solver_t *solver) {
-    if (solver == NULL || solver->matrix == NULL || solver->factors == NULL) {
-        return PARD_ERROR_INVALID_INPUT;
-    }
-    
-    pard_csr_matrix_t *A = solver->matrix;
-    pard_factors_t *factors = solver->factors;
-    int n = A->n;
-    
-    /* 将CSR转换为临时密集存储 */
-    double **dense_A = (double **)malloc(n * sizeof(double *));
-    for (int i = 0; i < n; i++) {
-        dense_A[i] = (double *)calloc(n, sizeof(double));
-    }
-    
-    for (int i = 0; i < n; i++) {
-        for (int j = A->row_ptr[i]; j < A->row_ptr[i + 1]; j++) {
-            int col = A->col_idx[j];
-            dense_A[i][col] = A->values[j];
-            if (A->is_symmetric && col != i) {
-                dense_A[col][i] = A->values[j];
+int pard_cholesky_front(double *F, int ld, int m, int k, int nthreads) {
+    for (int j0 = 0; j0 < k; j0 += PARD_CHOL_BLOCK) {
+        int jb = (k - j0 < PARD_CHOL_BLOCK) ? (k - j0) : PARD_CHOL_BLOCK;
+
+        /* 块内左看：第j列只需要块内已分解的列更新 */
+        for (int j = j0; j < j0 + jb; j++) {
+            double *cj = F + (size_t)j * ld;
+            for (int p = j0; p < j; p++) {
+                const double *cp = F + (size_t)p * ld;
+                double ljp = cp[j];
+                for (int i = j; i < m; i++) {
+                    cj[i] -= cp[i] * ljp;
+                }
             }
-        }
-    }
-    
-    /* Cholesky分解 */
-    for (int j = 0; j < n; j++) {
-        if (dense_A[j][j] <= 0.0) {
-            /* 不是正定矩阵 */
-            for (int i = 0; i < n; i++) {
-                free(dense_A[i]);
+
+            if (!(cj[j] > 0.0)) {
+                /* 不是正定矩阵 */
+                return PARD_ERROR_NUMERICAL;
             }
-            free(dense_A);
-            return PARD_ERROR_NUMERICAL;
-        }
-        
-        dense_A[j][j] = sqrt(dense_A[j][j]);
-        
-        for (int i = j + 1; i < n; i++) {
-            dense_A[i][j] /= dense_A[j][j];
-        }
-        
-        for (int k = j + 1; k < n; k++) {
-            for (int i = k; i < n; i++) {
-                dense_A[i][k] -= dense_A[i][j] * dense_A[k][j];
+
+            double d = sqrt(cj[j]);
+            double inv_d = 1.0 / d;
+            cj[j] = d;
+            for (int i = j + 1; i < m; i++) {
+                cj[i] *= inv_d;
             }
         }
-    }
-    
-    /* 将下三角部分复制到L */
-    int pos = 0;
-    for (int i = 0; i < n; i++) {
-        factors->row_ptr[i] = pos;
-        for (int j = 0; j <= i; j++) {
-            if (fabs(dense_A[i][j]) > 1e-15 || i == j) {
-                factors->col_idx[pos] = j;
-                factors->l_values[pos] = dense_A[i][j];
-                pos++;
-            }
+
+        /* 用当前块更新其余完全求和列（所有行） */
+        int j1 = j0 + jb;
+        if (j1 < k) {
+            pard_dense_gemm_lower_mt(m - j1, k - j1, jb,
+                                     F + j1 + (size_t)j0 * ld, ld,
+                                     F + j1 + (size_t)j0 * ld, ld,
+                                     F + j1 + (size_t)j1 * ld, ld, nthreads);
         }
     }
-    factors->row_ptr[n] = pos;
-    factors->nnz = pos;
-    
-    /* 清理 */
-    for (int i = 0; i < n; i++) {
-        free(dense_A[i]);
+
+    /* Schur补：C -= L21 * L21^T */
+    if (k < m) {
+        pard_dense_gemm_lower_mt(m - k, m - k, k,
+                                 F + k, ld,
+                                 F + k, ld,
+                                 F + k + (size_t)k * ld, ld, nthreads);
     }
-    free(dense_A);
-    
+
     return PARD_SUCCESS;
 }
+
+/**
+ * Cholesky分解：A = L * L^T（对称正定矩阵）
+ * 使用超节点多波前方法，只在L的非零结构上工作
+ */
+int pard_cholesky_factorization(pard_solver_t *solver) {
+    if (solver == NULL || solver->matrix == NULL || solver->factors == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    return pard_multifrontal_factorization(solver);
+}
@@ -0,0 +1,789 @@
+#include "pard.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/*
+ * 波前/超节点面板使用的稠密核函数
+ * 所有矩阵均为列主序存储，A[i + j*lda]表示第i行第j列
+ */
+
+/* 行方向分块大小：使C的一个行块在多个秩更新之间保持在L1缓存中 */
+#define PARD_DENSE_ROW_BLOCK 256
+
+/* 多线程更新的最小运算量：低于该值时线程创建开销得不偿失 */
+#define PARD_DENSE_MT_MIN_FLOPS 4.0e6
+/* 单次稠密更新使用的最大线程数 */
+#define PARD_DENSE_MAX_THREADS 64
+
+/**
+ * C(m×n) -= A(m×k) * B(n×k)^T
+ */
+void pard_dense_gemm_nt(int m, int n, int k,
+                        const double *A, int lda,
+                        const double *B, int ldb,
+                        double *C, int ldc) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+
+    for (int i0 = 0; i0 < m; i0 += PARD_DENSE_ROW_BLOCK) {
+        int ib = (m - i0 < PARD_DENSE_ROW_BLOCK) ? (m - i0) : PARD_DENSE_ROW_BLOCK;
+        int j = 0;
+
+        /* 每次处理C的4列，A的每一列只读取一次 */
+        for (; j + 3 < n; j += 4) {
+            double *c0 = C + i0 + (size_t)j * ldc;
+            double *c1 = c0 + ldc;
+            double *c2 = c1 + ldc;
+            double *c3 = c2 + ldc;
+            for (int p = 0; p < k; p++) {
+                const double *a = A + i0 + (size_t)p * lda;
+                double b0 = B[j + (size_t)p * ldb];
+                double b1 = B[j + 1 + (size_t)p * ldb];
+                double b2 = B[j + 2 + (size_t)p * ldb];
+                double b3 = B[j + 3 + (size_t)p * ldb];
+                for (int i = 0; i < ib; i++) {
+                    double ai = a[i];
+                    c0[i] -= ai * b0;
+                    c1[i] -= ai * b1;
+                    c2[i] -= ai * b2;
+                    c3[i] -= ai * b3;
+                }
+            }
+        }
+
+        for (; j < n; j++) {
+            double *c0 = C + i0 + (size_t)j * ldc;
+            for (int p = 0; p < k; p++) {
+                const double *a = A + i0 + (size_t)p * lda;
+                double b0 = B[j + (size_t)p * ldb];
+                for (int i = 0; i < ib; i++) {
+                    c0[i] -= a[i] * b0;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * 下梯形更新：C(i,j) -= sum_p A(i,p) * B(j,p)，仅更新i >= j的部分
+ * C为m×n（m >= n），A为m×k，B为n×k
+ * 对角块逐列处理，对角块以下的矩形部分交给pard_dense_gemm_nt
+ */
+void pard_dense_gemm_lower(int m, int n, int k,
+                           const double *A, int lda,
+                           const double *B, int ldb,
+                           double *C, int ldc) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+
+    const int nb = 32;
+    for (int j0 = 0; j0 < n; j0 += nb) {
+        int jb = (n - j0 < nb) ? (n - j0) : nb;
+
+        /* 对角块（下三角） */
+        for (int j = j0; j < j0 + jb; j++) {
+            double *cj = C + (size_t)j * ldc;
+            for (int p = 0; p < k; p++) {
+                const double *a = A + (size_t)p * lda;
+                double bj = B[j + (size_t)p * ldb];
+                for (int i = j; i < j0 + jb; i++) {
+                    cj[i] -= a[i] * bj;
+                }
+            }
+        }
+
+        /* 对角块以下的矩形部分 */
+        int below = m - (j0 + jb);
+        if (below > 0) {
+            pard_dense_gemm_nt(below, jb, k,
+                               A + j0 + jb, lda,
+                               B + j0, ldb,
+                               C + j0 + jb + (size_t)j0 * ldc, ldc);
+        }
+    }
+}
+
+/**
+ * C(m×n) -= A(m×k) * B(k×n)
+ */
+void pard_dense_gemm_nn(int m, int n, int k,
+                        const double *A, int lda,
+                        const double *B, int ldb,
+                        double *C, int ldc) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+
+    for (int i0 = 0; i0 < m; i0 += PARD_DENSE_ROW_BLOCK) {
+        int ib = (m - i0 < PARD_DENSE_ROW_BLOCK) ? (m - i0) : PARD_DENSE_ROW_BLOCK;
+        int j = 0;
+
+        for (; j + 3 < n; j += 4) {
+            double *c0 = C + i0 + (size_t)j * ldc;
+            double *c1 = c0 + ldc;
+            double *c2 = c1 + ldc;
+            double *c3 = c2 + ldc;
+            const double *b = B + (size_t)j * ldb;
+            for (int p = 0; p < k; p++) {
+                const double *a = A + i0 + (size_t)p * lda;
+                double b0 = b[p];
+                double b1 = b[p + ldb];
+                double b2 = b[p + 2 * (size_t)ldb];
+                double b3 = b[p + 3 * (size_t)ldb];
+                for (int i = 0; i < ib; i++) {
+                    double ai = a[i];
+                    c0[i] -= ai * b0;
+                    c1[i] -= ai * b1;
+                    c2[i] -= ai * b2;
+                    c3[i] -= ai * b3;
+                }
+            }
+        }
+
+        for (; j < n; j++) {
+            double *c0 = C + i0 + (size_t)j * ldc;
+            const double *b = B + (size_t)j * ldb;
+            for (int p = 0; p < k; p++) {
+                const double *a = A + i0 + (size_t)p * lda;
+                double b0 = b[p];
+                for (int i = 0; i < ib; i++) {
+                    c0[i] -= a[i] * b0;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * 多线程稠密更新中一个线程负责的列区间
+ */
+typedef struct {
+    int lower;          /* 1：下梯形更新（gemm_lower），0：gemm_nn */
+    int m, n, k;
+    const double *A;
+    int lda;
+    const double *B;
+    int ldb;
+    double *C;
+    int ldc;
+    int j0, j1;         /* 负责C的列[j0, j1) */
+} dense_mt_task_t;
+
+static void dense_mt_run(const dense_mt_task_t *t) {
+    int jb = t->j1 - t->j0;
+    if (jb <= 0) {
+        return;
+    }
+    if (t->lower) {
+        pard_dense_gemm_lower(t->m - t->j0, jb, t->k,
+                              t->A + t->j0, t->lda,
+                              t->B + t->j0, t->ldb,
+                              t->C + t->j0 + (size_t)t->j0 * t->ldc, t->ldc);
+    } else {
+        pard_dense_gemm_nn(t->m, jb, t->k,
+                           t->A, t->lda,
+                           t->B + (size_t)t->j0 * t->ldb, t->ldb,
+                           t->C + (size_t)t->j0 * t->ldc, t->ldc);
+    }
+}
+
+static void *dense_mt_worker(void *arg) {
+    dense_mt_run((const dense_mt_task_t *)arg);
+    return NULL;
+}
+
+/**
+ * 按列划分C，由nthreads个线程并行执行；线程创建失败时由调用线程补做
+ * 下梯形情形第j列的工作量正比于m-j，按面积均分列区间
+ */
+static void dense_mt_dispatch(int lower, int m, int n, int k,
+                              const double *A, int lda,
+                              const double *B, int ldb,
+                              double *C, int ldc, int nthreads) {
+    dense_mt_task_t tasks[PARD_DENSE_MAX_THREADS];
+    pthread_t tids[PARD_DENSE_MAX_THREADS];
+    int started[PARD_DENSE_MAX_THREADS];
+    if (nthreads > PARD_DENSE_MAX_THREADS) {
+        nthreads = PARD_DENSE_MAX_THREADS;
+    }
+
+    double total = lower ? 0.5 * n * (2.0 * m - n + 1.0) : (double)m * n;
+    int j = 0;
+    for (int t = 0; t < nthreads; t++) {
+        tasks[t].lower = lower;
+        tasks[t].m = m;
+        tasks[t].n = n;
+        tasks[t].k = k;
+        tasks[t].A = A;
+        tasks[t].lda = lda;
+        tasks[t].B = B;
+        tasks[t].ldb = ldb;
+        tasks[t].C = C;
+        tasks[t].ldc = ldc;
+        tasks[t].j0 = j;
+        if (t == nthreads - 1) {
+            j = n;
+        } else {
+            double target = total * (t + 1) / nthreads;
+            double acc = lower ? 0.5 * j * (2.0 * m - j + 1.0) : (double)m * j;
+            while (j < n && acc < target) {
+                acc += lower ? (double)(m - j) : (double)m;
+                j++;
+            }
+        }
+        tasks[t].j1 = j;
+    }
+
+    for (int t = 1; t < nthreads; t++) {
+        started[t] = (pthread_create(&tids[t], NULL, dense_mt_worker, &tasks[t]) == 0);
+    }
+    dense_mt_run(&tasks[0]);
+    for (int t = 1; t < nthreads; t++) {
+        if (started[t]) {
+            pthread_join(tids[t], NULL);
+        } else {
+            dense_mt_run(&tasks[t]);
+        }
+    }
+}
+
+/**
+ * pard_dense_gemm_lower的多线程版本，运算量较小或nthreads <= 1时退化为串行
+ */
+void pard_dense_gemm_lower_mt(int m, int n, int k,
+                              const double *A, int lda,
+                              const double *B, int ldb,
+                              double *C, int ldc, int nthreads) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+    if (nthreads <= 1 || (double)m * n * k < PARD_DENSE_MT_MIN_FLOPS || n < 2 * nthreads) {
+        pard_dense_gemm_lower(m, n, k, A, lda, B, ldb, C, ldc);
+        return;
+    }
+    dense_mt_dispatch(1, m, n, k, A, lda, B, ldb, C, ldc, nthreads);
+}
+
+/**
+ * pard_dense_gemm_nn的多线程版本
+ */
+void pard_dense_gemm_nn_mt(int m, int n, int k,
+                           const double *A, int lda,
+                           const double *B, int ldb,
+                           double *C, int ldc, int nthreads) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+    if (nthreads <= 1 || 2.0 * m * n * k < PARD_DENSE_MT_MIN_FLOPS || n < 2 * nthreads) {
+        pard_dense_gemm_nn(m, n, k, A, lda, B, ldb, C, ldc);
+        return;
+    }
+    dense_mt_dispatch(0, m, n, k, A, lda, B, ldb, C, ldc, nthreads);
+}
+
+/**
+ * C(m×n) -= A(k×m)^T * B(k×n)
+ * 每次计算C的4行，B的每一列只读取一次
+ */
+void pard_dense_gemm_tn(int m, int n, int k,
+                        const double *A, int lda,
+                        const double *B, int ldb,
+                        double *C, int ldc) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+
+    for (int j = 0; j < n; j++) {
+        const double *b = B + (size_t)j * ldb;
+        double *c = C + (size_t)j * ldc;
+        int i = 0;
+        for (; i + 3 < m; i += 4) {
+            const double *a0 = A + (size_t)i * lda;
+            const double *a1 = a0 + lda;
+            const double *a2 = a1 + lda;
+            const double *a3 = a2 + lda;
+            double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+            for (int p = 0; p < k; p++) {
+                double bp = b[p];
+                s0 += a0[p] * bp;
+                s1 += a1[p] * bp;
+                s2 += a2[p] * bp;
+                s3 += a3[p] * bp;
+            }
+            c[i] -= s0;
+            c[i + 1] -= s1;
+            c[i + 2] -= s2;
+            c[i + 3] -= s3;
+        }
+        for (; i < m; i++) {
+            const double *a0 = A + (size_t)i * lda;
+            double s0 = 0.0;
+            for (int p = 0; p < k; p++) {
+                s0 += a0[p] * b[p];
+            }
+            c[i] -= s0;
+        }
+    }
+}
+
+/**
+ * 求解 L*X = B，L为k×k下三角（unit非零时对角元视为1），B为k×nrhs，结果覆盖B
+ * 每次处理B的4列，L的每一列只读取一次
+ */
+void pard_dense_trsm_lower(int k, int nrhs, const double *L, int ldl,
+                           double *B, int ldb, int unit) {
+    int c = 0;
+    for (; c + 3 < nrhs; c += 4) {
+        double *b0 = B + (size_t)c * ldb;
+        double *b1 = b0 + ldb;
+        double *b2 = b1 + ldb;
+        double *b3 = b2 + ldb;
+        for (int j = 0; j < k; j++) {
+            const double *lj = L + (size_t)j * ldl;
+            if (!unit) {
+                double inv = 1.0 / lj[j];
+                b0[j] *= inv;
+                b1[j] *= inv;
+                b2[j] *= inv;
+                b3[j] *= inv;
+            }
+            double x0 = b0[j], x1 = b1[j], x2 = b2[j], x3 = b3[j];
+            for (int i = j + 1; i < k; i++) {
+                double l = lj[i];
+                b0[i] -= l * x0;
+                b1[i] -= l * x1;
+                b2[i] -= l * x2;
+                b3[i] -= l * x3;
+            }
+        }
+    }
+    for (; c < nrhs; c++) {
+        double *b0 = B + (size_t)c * ldb;
+        for (int j = 0; j < k; j++) {
+            const double *lj = L + (size_t)j * ldl;
+            if (!unit) {
+                b0[j] /= lj[j];
+            }
+            double x0 = b0[j];
+            for (int i = j + 1; i < k; i++) {
+                b0[i] -= lj[i] * x0;
+            }
+        }
+    }
+}
+
+/**
+ * 求解 L^T*X = B，L为k×k下三角（unit非零时对角元视为1），B为k×nrhs，结果覆盖B
+ */
+void pard_dense_trsm_lower_trans(int k, int nrhs, const double *L, int ldl,
+                                 double *B, int ldb, int unit) {
+    int c = 0;
+    for (; c + 3 < nrhs; c += 4) {
+        double *b0 = B + (size_t)c * ldb;
+        double *b1 = b0 + ldb;
+        double *b2 = b1 + ldb;
+        double *b3 = b2 + ldb;
+        for (int j = k - 1; j >= 0; j--) {
+            const double *lj = L + (size_t)j * ldl;
+            double s0 = b0[j], s1 = b1[j], s2 = b2[j], s3 = b3[j];
+            for (int i = j + 1; i < k; i++) {
+                double l = lj[i];
+                s0 -= l * b0[i];
+                s1 -= l * b1[i];
+                s2 -= l * b2[i];
+                s3 -= l * b3[i];
+            }
+            if (!unit) {
+                double inv = 1.0 / lj[j];
+                s0 *= inv;
+                s1 *= inv;
+                s2 *= inv;
+                s3 *= inv;
+            }
+            b0[j] = s0;
+            b1[j] = s1;
+            b2[j] = s2;
+            b3[j] = s3;
+        }
+    }
+    for (; c < nrhs; c++) {
+        double *b0 = B + (size_t)c * ldb;
+        for (int j = k - 1; j >= 0; j--) {
+            const double *lj = L + (size_t)j * ldl;
+            double s0 = b0[j];
+            for (int i = j + 1; i < k; i++) {
+                s0 -= lj[i] * b0[i];
+            }
+            b0[j] = unit ? s0 : s0 / lj[j];
+        }
+    }
+}
+
+/**
+ * 求解 U*X = B，U为k×k上三角（非单位对角），B为k×nrhs，结果覆盖B
+ */
+void pard_dense_trsm_upper(int k, int nrhs, const double *U, int ldu,
+                           double *B, int ldb) {
+    int c = 0;
+    for (; c + 3 < nrhs; c += 4) {
+        double *b0 = B + (size_t)c * ldb;
+        double *b1 = b0 + ldb;
+        double *b2 = b1 + ldb;
+        double *b3 = b2 + ldb;
+        for (int j = k - 1; j >= 0; j--) {
+            const double *uj = U + (size_t)j * ldu;
+            double inv = 1.0 / uj[j];
+            double x0 = b0[j] * inv, x1 = b1[j] * inv, x2 = b2[j] * inv, x3 = b3[j] * inv;
+            b0[j] = x0;
+            b1[j] = x1;
+            b2[j] = x2;
+            b3[j] = x3;
+            for (int i = 0; i < j; i++) {
+                double u = uj[i];
+                b0[i] -= u * x0;
+                b1[i] -= u * x1;
+                b2[i] -= u * x2;
+                b3[i] -= u * x3;
+            }
+        }
+    }
+    for (; c < nrhs; c++) {
+        double *b0 = B + (size_t)c * ldb;
+        for (int j = k - 1; j >= 0; j--) {
+            const double *uj = U + (size_t)j * ldu;
+            double x0 = b0[j] / uj[j];
+            b0[j] = x0;
+            for (int i = 0; i < j; i++) {
+                b0[i] -= uj[i] * x0;
+            }
+        }
+    }
+}
+
+/**
+ * 求解 U^T*X = B，U为k×k上三角（非单位对角），B为k×nrhs，结果覆盖B
+ * U的第j列即U^T的第j行，按列内积前代
+ */
+void pard_dense_trsm_upper_trans(int k, int nrhs, const double *U, int ldu,
+                                 double *B, int ldb) {
+    int c = 0;
+    for (; c + 3 < nrhs; c += 4) {
+        double *b0 = B + (size_t)c * ldb;
+        double *b1 = b0 + ldb;
+        double *b2 = b1 + ldb;
+        double *b3 = b2 + ldb;
+        for (int j = 0; j < k; j++) {
+            const double *uj = U + (size_t)j * ldu;
+            double s0 = b0[j], s1 = b1[j], s2 = b2[j], s3 = b3[j];
+            for (int i = 0; i < j; i++) {
+                double u = uj[i];
+                s0 -= u * b0[i];
+                s1 -= u * b1[i];
+                s2 -= u * b2[i];
+                s3 -= u * b3[i];
+            }
+            double inv = 1.0 / uj[j];
+            b0[j] = s0 * inv;
+            b1[j] = s1 * inv;
+            b2[j] = s2 * inv;
+            b3[j] = s3 * inv;
+        }
+    }
+    for (; c < nrhs; c++) {
+        double *b0 = B + (size_t)c * ldb;
+        for (int j = 0; j < k; j++) {
+            const double *uj = U + (size_t)j * ldu;
+            double s0 = b0[j];
+            for (int i = 0; i < j; i++) {
+                s0 -= uj[i] * b0[i];
+            }
+            b0[j] = s0 / uj[j];
+        }
+    }
+}
+
+/*
+ * 单精度因子的求解核：因子块A/L/U为float，右端项与累加均为double。
+ * 用于混合精度模式（面板以单精度保存），访存量为双精度因子的一半
+ */
+
+/**
+ * C -= A*B，A为m×k单精度，B为k×n，C为m×n
+ */
+void pard_dense_gemm_nn_float(int m, int n, int k,
+                              const float *A, int lda,
+                              const double *B, int ldb,
+                              double *C, int ldc) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+
+    for (int i0 = 0; i0 < m; i0 += PARD_DENSE_ROW_BLOCK) {
+        int ib = (m - i0 < PARD_DENSE_ROW_BLOCK) ? (m - i0) : PARD_DENSE_ROW_BLOCK;
+        int j = 0;
+
+        for (; j + 3 < n; j += 4) {
+            double *c0 = C + i0 + (size_t)j * ldc;
+            double *c1 = c0 + ldc;
+            double *c2 = c1 + ldc;
+            double *c3 = c2 + ldc;
+            const double *b = B + (size_t)j * ldb;
+            for (int p = 0; p < k; p++) {
+                const float *a = A + i0 + (size_t)p * lda;
+                double b0 = b[p];
+                double b1 = b[p + ldb];
+                double b2 = b[p + 2 * (size_t)ldb];
+                double b3 = b[p + 3 * (size_t)ldb];
+                for (int i = 0; i < ib; i++) {
+                    double ai = a[i];
+                    c0[i] -= ai * b0;
+                    c1[i] -= ai * b1;
+                    c2[i] -= ai * b2;
+                    c3[i] -= ai * b3;
+                }
+            }
+        }
+
+        for (; j < n; j++) {
+            double *c0 = C + i0 + (size_t)j * ldc;
+            const double *b = B + (size_t)j * ldb;
+            for (int p = 0; p < k; p++) {
+                const float *a = A + i0 + (size_t)p * lda;
+                double b0 = b[p];
+                for (int i = 0; i < ib; i++) {
+                    c0[i] -= a[i] * b0;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * C -= A^T*B，A为k×m单精度，B为k×n，C为m×n
+ * 每次计算C的4列，A的每一列只读取一次
+ */
+void pard_dense_gemm_tn_float(int m, int n, int k,
+                              const float *A, int lda,
+                              const double *B, int ldb,
+                              double *C, int ldc) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+
+    int j = 0;
+    for (; j + 3 < n; j += 4) {
+        const double *b0 = B + (size_t)j * ldb;
+        const double *b1 = b0 + ldb;
+        const double *b2 = b1 + ldb;
+        const double *b3 = b2 + ldb;
+        double *c0 = C + (size_t)j * ldc;
+        double *c1 = c0 + ldc;
+        double *c2 = c1 + ldc;
+        double *c3 = c2 + ldc;
+        for (int i = 0; i < m; i++) {
+            const float *a0 = A + (size_t)i * lda;
+            double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+            for (int p = 0; p < k; p++) {
+                double ap = a0[p];
+                s0 += ap * b0[p];
+                s1 += ap * b1[p];
+                s2 += ap * b2[p];
+                s3 += ap * b3[p];
+            }
+            c0[i] -= s0;
+            c1[i] -= s1;
+            c2[i] -= s2;
+            c3[i] -= s3;
+        }
+    }
+    for (; j < n; j++) {
+        const double *b = B + (size_t)j * ldb;
+        double *c = C + (size_t)j * ldc;
+        for (int i = 0; i < m; i++) {
+            const float *a0 = A + (size_t)i * lda;
+            double s0 = 0.0;
+            for (int p = 0; p < k; p++) {
+                s0 += a0[p] * b[p];
+            }
+            c[i] -= s0;
+        }
+    }
+}
+
+/**
+ * 求解 L*X = B，L为k×k单精度下三角（unit非零时对角元视为1）
+ * 每次处理B的4列，L的每一列只读取一次
+ */
+void pard_dense_trsm_lower_float(int k, int nrhs, const float *L, int ldl,
+                                 double *B, int ldb, int unit) {
+    int c = 0;
+    for (; c + 3 < nrhs; c += 4) {
+        double *b0 = B + (size_t)c * ldb;
+        double *b1 = b0 + ldb;
+        double *b2 = b1 + ldb;
+        double *b3 = b2 + ldb;
+        for (int j = 0; j < k; j++) {
+            const float *lj = L + (size_t)j * ldl;
+            if (!unit) {
+                double d = lj[j];
+                b0[j] /= d;
+                b1[j] /= d;
+                b2[j] /= d;
+                b3[j] /= d;
+            }
+            double x0 = b0[j], x1 = b1[j], x2 = b2[j], x3 = b3[j];
+            for (int i = j + 1; i < k; i++) {
+                double l = lj[i];
+                b0[i] -= l * x0;
+                b1[i] -= l * x1;
+                b2[i] -= l * x2;
+                b3[i] -= l * x3;
+            }
+        }
+    }
+    for (; c < nrhs; c++) {
+        double *b0 = B + (size_t)c * ldb;
+        for (int j = 0; j < k; j++) {
+            const float *lj = L + (size_t)j * ldl;
+            if (!unit) {
+                b0[j] /= lj[j];
+            }
+            double x0 = b0[j];
+            for (int i = j + 1; i < k; i++) {
+                b0[i] -= lj[i] * x0;
+            }
+        }
+    }
+}
+
+/**
+ * 求解 L^T*X = B，L为k×k单精度下三角（unit非零时对角元视为1）
+ */
+void pard_dense_trsm_lower_trans_float(int k, int nrhs, const float *L, int ldl,
+                                       double *B, int ldb, int unit) {
+    int c = 0;
+    for (; c + 3 < nrhs; c += 4) {
+        double *b0 = B + (size_t)c * ldb;
+        double *b1 = b0 + ldb;
+        double *b2 = b1 + ldb;
+        double *b3 = b2 + ldb;
+        for (int j = k - 1; j >= 0; j--) {
+            const float *lj = L + (size_t)j * ldl;
+            double s0 = b0[j], s1 = b1[j], s2 = b2[j], s3 = b3[j];
+            for (int i = j + 1; i < k; i++) {
+                double l = lj[i];
+                s0 -= l * b0[i];
+                s1 -= l * b1[i];
+                s2 -= l * b2[i];
+                s3 -= l * b3[i];
+            }
+            if (!unit) {
+                double d = lj[j];
+                s0 /= d;
+                s1 /= d;
+                s2 /= d;
+                s3 /= d;
+            }
+            b0[j] = s0;
+            b1[j] = s1;
+            b2[j] = s2;
+            b3[j] = s3;
+        }
+    }
+    for (; c < nrhs; c++) {
+        double *b0 = B + (size_t)c * ldb;
+        for (int j = k - 1; j >= 0; j--) {
+            const float *lj = L + (size_t)j * ldl;
+            double s0 = b0[j];
+            for (int i = j + 1; i < k; i++) {
+                s0 -= lj[i] * b0[i];
+            }
+            b0[j] = unit ? s0 : s0 / lj[j];
+        }
+    }
+}
+
+/**
+ * 求解 U*X = B，U为k×k单精度上三角（非单位对角）
+ */
+void pard_dense_trsm_upper_float(int k, int nrhs, const float *U, int ldu,
+                                 double *B, int ldb) {
+    int c = 0;
+    for (; c + 3 < nrhs; c += 4) {
+        double *b0 = B + (size_t)c * ldb;
+        double *b1 = b0 + ldb;
+        double *b2 = b1 + ldb;
+        double *b3 = b2 + ldb;
+        for (int j = k - 1; j >= 0; j--) {
+            const float *uj = U + (size_t)j * ldu;
+            double d = uj[j];
+            double x0 = b0[j] / d, x1 = b1[j] / d, x2 = b2[j] / d, x3 = b3[j] / d;
+            b0[j] = x0;
+            b1[j] = x1;
+            b2[j] = x2;
+            b3[j] = x3;
+            for (int i = 0; i < j; i++) {
+                double u = uj[i];
+                b0[i] -= u * x0;
+                b1[i] -= u * x1;
+                b2[i] -= u * x2;
+                b3[i] -= u * x3;
+            }
+        }
+    }
+    for (; c < nrhs; c++) {
+        double *b0 = B + (size_t)c * ldb;
+        for (int j = k - 1; j >= 0; j--) {
+            const float *uj = U + (size_t)j * ldu;
+            double x0 = b0[j] / uj[j];
+            b0[j] = x0;
+            for (int i = 0; i < j; i++) {
+                b0[i] -= uj[i] * x0;
+            }
+        }
+    }
+}
+
+/**
+ * 求解 U^T*X = B，U为k×k单精度上三角（非单位对角）
+ */
+void pard_dense_trsm_upper_trans_float(int k, int nrhs, const float *U, int ldu,
+                                       double *B, int ldb) {
+    int c = 0;
+    for (; c + 3 < nrhs; c += 4) {
+        double *b0 = B + (size_t)c * ldb;
+        double *b1 = b0 + ldb;
+        double *b2 = b1 + ldb;
+        double *b3 = b2 + ldb;
+        for (int j = 0; j < k; j++) {
+            const float *uj = U + (size_t)j * ldu;
+            double s0 = b0[j], s1 = b1[j], s2 = b2[j], s3 = b3[j];
+            for (int i = 0; i < j; i++) {
+                double u = uj[i];
+                s0 -= u * b0[i];
+                s1 -= u * b1[i];
+                s2 -= u * b2[i];
+                s3 -= u * b3[i];
+            }
+            double d = uj[j];
+            b0[j] = s0 / d;
+            b1[j] = s1 / d;
+            b2[j] = s2 / d;
+            b3[j] = s3 / d;
+        }
+    }
+    for (; c < nrhs; c++) {
+        double *b0 = B + (size_t)c * ldb;
+        for (int j = 0; j < k; j++) {
+            const float *uj = U + (size_t)j * ldu;
+            double s0 = b0[j];
+            for (int i = 0; i < j; i++) {
+                s0 -= uj[i] * b0[i];
+            }
+            b0[j] = s0 / uj[j];
+        }
+    }
+}
@@ -3,260 +3,253 @@
 #include <string.h>
 #include <math.h>
 
+/* 前向声明 */
+extern int pard_multifrontal_factorization(pard_solver_t *solver);
+extern void pard_dense_gemm_lower_mt(int m, int n, int k,
+                                     const double *A, int lda,
+                                     const double *B, int ldb,
+                                     double *C, int ldc, int nthreads);
+
+/* Bunch-Kaufman参数 alpha = (1 + sqrt(17)) / 8，使元素增长因子有界 */
+#define PARD_LDLT_BK_ALPHA 0.6403882032022076
+
+/* 对称波前（仅下三角）中的元素A(i,j) */
+#define LDLT_AT(F, ld, i, j) \
+    ((i) >= (j) ? (F)[(i) + (size_t)(j) * (ld)] : (F)[(j) + (size_t)(i) * (ld)])
+
 /**
- * LDL^T分解（对称不定矩阵，使用Bunch-Kaufman pivoting）
- * 将矩阵A分解为P*A*P^T = L*D*L^T
- * 支持1x1和2x2主元块
+ * 对称交换波前矩阵的第i、j行和列（i < j，仅下三角存储）
+ * 已消去的列（c < i）中存放的L也随之交换行
  */
-int pard_ldlt_factorization(pard_solver_t *solver) {
-    if (solver == NULL || solver->matrix == NULL || solver->factors == NULL) {
-        return PARD_ERROR_INVALID_INPUT;
+static void ldlt_swap(double *F, int ld, int m, int *rows, int i, int j) {
+    if (i == j) {
+        return;
     }
-    
-    pard_csr_matrix_t *A = solver->matrix;
-    pard_factors_t *factors = solver->factors;
-    int n = A->n;
-    
-    /* 分配D和pivot_type数组 */
-    factors->d_values = (double *)malloc(n * sizeof(double));
-    factors->pivot_type = (int *)malloc(n * sizeof(int));
-    
-    if (factors->d_values == NULL || factors->pivot_type == NULL) {
-        free(factors->d_values);
-        free(factors->pivot_type);
-        return PARD_ERROR_MEMORY;
+    if (i > j) {
+        int t = i;
+        i = j;
+        j = t;
     }
-    
-    /* 初始化pivot_type为1（1x1主元） */
-    for (int i = 0; i < n; i++) {
-        factors->pivot_type[i] = 1;
+    double tmp;
+    for (int c = 0; c < i; c++) {
+        tmp = F[i + (size_t)c * ld];
+        F[i + (size_t)c * ld] = F[j + (size_t)c * ld];
+        F[j + (size_t)c * ld] = tmp;
     }
-    
-    /* 初始化置换数组（如果还没有分配） */
-    if (factors->perm == NULL) {
-        factors->perm = (int *)malloc(n * sizeof(int));
-        if (factors->perm == NULL) {
-            free(factors->d_values);
-            free(factors->pivot_type);
-            return PARD_ERROR_MEMORY;
+    tmp = F[i + (size_t)i * ld];
+    F[i + (size_t)i * ld] = F[j + (size_t)j * ld];
+    F[j + (size_t)j * ld] = tmp;
+    for (int c = i + 1; c < j; c++) {
+        tmp = F[c + (size_t)i * ld];
+        F[c + (size_t)i * ld] = F[j + (size_t)c * ld];
+        F[j + (size_t)c * ld] = tmp;
+    }
+    for (int r = j + 1; r < m; r++) {
+        tmp = F[r + (size_t)i * ld];
+        F[r + (size_t)i * ld] = F[r + (size_t)j * ld];
+        F[r + (size_t)j * ld] = tmp;
+    }
+    int tmp_idx = rows[i];
+    rows[i] = rows[j];
+    rows[j] = tmp_idx;
+}
+
+/**
+ * 剩余矩阵（行、列 >= p）第q列的最大非对角元，*imax返回其行号
+ */
+static double ldlt_col_max(const double *F, int ld, int m, int p, int q, int *imax) {
+    double best = 0.0;
+    int r = -1;
+    for (int i = p; i < m; i++) {
+        if (i == q) {
+            continue;
         }
-        for (int i = 0; i < n; i++) {
-            factors->perm[i] = i;  /* 初始为单位置换 */
+        double v = fabs(LDLT_AT(F, ld, i, q));
+        if (v > best) {
+            best = v;
+            r = i;
         }
     }
-    
-    /* 将CSR转换为临时密集存储 */
-    double **dense_A = (double **)malloc(n * sizeof(double *));
-    for (int i = 0; i < n; i++) {
-        dense_A[i] = (double *)calloc(n, sizeof(double));
+    if (imax != NULL) {
+        *imax = r;
     }
-    
-    for (int i = 0; i < n; i++) {
-        for (int j = A->row_ptr[i]; j < A->row_ptr[i + 1]; j++) {
-            int col = A->col_idx[j];
-            dense_A[i][col] = A->values[j];
-            if (A->is_symmetric && col != i) {
-                dense_A[col][i] = A->values[j];
-            }
-        }
+    return best;
+}
+
+/**
+ * 波前矩阵的部分LDL^T分解（Bunch-Kaufman主元，限制在完全求和块内）
+ * F为m×m列主序矩阵（仅使用下三角），前k行/列为完全求和部分，rows随对称交换同步调整。
+ * 对每个候选列按Bunch-Kaufman准则选择1x1或2x2主元；若准则要求的配对行不是完全求和行，
+ * 则尝试下一候选列，全部失败时把剩余主元推迟到父波前。根波前的所有行都是完全求和的，
+ * 因此标准Bunch-Kaufman总能选出主元；某列对角元与非对角元都不超过tiny
+ * （由调用者按矩阵的量级给出）时矩阵奇异。
+ * 返回时F的前npiv列存放D（对角块，2x2块的非对角元在F(p+1,p)）和L（D块以下部分），
+ * piv[0..npiv)为各主元类型（1或2，2x2块的两列都标记为2），
+ * 右下角(m-npiv)×(m-npiv)块为Schur补，Schur补更新由nthreads个线程并行执行
+ */
+int pard_ldlt_front(double *F, int ld, int m, int k, int *rows,
+                    int *piv, double tiny, int *npiv, int nthreads) {
+    /* w保存当前主元列在完全求和行上的原始值，W为Schur补更新使用的L21*D */
+    double *w = (double *)malloc((2 * (size_t)k + (size_t)(m - k) * k + 1) * sizeof(double));
+    if (w == NULL) {
+        return PARD_ERROR_MEMORY;
     }
-    
-    /* 简化的LDL^T分解：暂时只使用1x1主元，稍后可以添加2x2主元支持 */
-    /* Bunch-Kaufman LDL^T分解 */
-    int k = 0;
-    while (k < n) {
-        /* 选择主元策略：优先选择对角元素，如果对角元素太小，则选择列中最大的元素 */
-        double diag_val = fabs(dense_A[k][k]);
-        double alpha = diag_val;
-        int pivot_row = k;
-        
-        /* 如果对角元素太小，查找列中最大的元素 */
-        if (diag_val < 1e-10) {
-            alpha = 0.0;
-            for (int i = k; i < n; i++) {
-                if (fabs(dense_A[i][k]) > alpha) {
-                    alpha = fabs(dense_A[i][k]);
-                    pivot_row = i;
+    double *w2 = w + k;
+    double *W = w + 2 * (size_t)k;
+
+    int p = 0;
+    int err = PARD_SUCCESS;
+
+    while (p < k) {
+        int pc = -1, pr = -1, size = 0;
+
+        for (int q = p; q < k && size == 0; q++) {
+            double aqq = fabs(F[q + (size_t)q * ld]);
+            int r;
+            double lambda = ldlt_col_max(F, ld, m, p, q, &r);
+
+            if (lambda <= tiny && aqq <= tiny) {
+                /* 完全求和的零行/列：矩阵奇异 */
+                err = PARD_ERROR_NUMERICAL;
+                break;
+            } else if (aqq >= PARD_LDLT_BK_ALPHA * lambda) {
+                pc = q;
+                size = 1;
+            } else if (r < k) {
+                double sigma = ldlt_col_max(F, ld, m, p, r, NULL);
+                if (aqq * sigma >= PARD_LDLT_BK_ALPHA * lambda * lambda) {
+                    pc = q;
+                    size = 1;
+                } else if (fabs(F[r + (size_t)r * ld]) >= PARD_LDLT_BK_ALPHA * sigma) {
+                    pc = r;
+                    size = 1;
+                } else {
+                    pc = q;
+                    pr = r;
+                    size = 2;
                 }
             }
+            /* r不是完全求和行：该列暂不能作为主元 */
         }
-        
-        if (alpha < 1e-15) {
-            /* 数值奇异 */
-            for (int i = 0; i < n; i++) {
-                free(dense_A[i]);
-            }
-            free(dense_A);
-            return PARD_ERROR_NUMERICAL;
-        }
-        
-        /* 决定使用1x1还是2x2主元块 */
-        double lambda = 0.0;
-        int lambda_row = k;
-        
-        for (int i = k; i < n; i++) {
-            if (i != pivot_row && fabs(dense_A[i][k]) > lambda) {
-                lambda = fabs(dense_A[i][k]);
-                lambda_row = i;
-            }
+
+        if (err != PARD_SUCCESS || size == 0) {
+            break;  /* 奇异，或推迟剩余主元 */
         }
-        
-        double sigma = fabs(dense_A[pivot_row][pivot_row]);
-        
-        /* Bunch-Kaufman条件：如果满足，使用1x1主元，否则使用2x2 */
-        /* 暂时禁用2x2块，只使用1x1主元，简化实现 */
-        int use_2x2 = 0;
-        /* if (k < n - 1 && alpha * lambda > sigma * sigma) {
-            use_2x2 = 1;
-        } */
-        
-        if (use_2x2 && k < n - 1) {
-            /* 2x2主元块 */
-            factors->pivot_type[k] = 2;
-            factors->pivot_type[k + 1] = 2;
-            
-            /* 交换行和列（如果需要） */
-            if (pivot_row != k) {
-                /* 交换行 */
-                double *tmp = dense_A[k];
-                dense_A[k] = dense_A[pivot_row];
-                dense_A[pivot_row] = tmp;
-                
-                /* 交换列 */
-                for (int i = 0; i < n; i++) {
-                    double tmp_val = dense_A[i][k];
-                    dense_A[i][k] = dense_A[i][pivot_row];
-                    dense_A[i][pivot_row] = tmp_val;
-                }
-            }
-            
-            if (lambda_row != k + 1) {
-                /* 交换行 */
-                double *tmp = dense_A[k + 1];
-                dense_A[k + 1] = dense_A[lambda_row];
-                dense_A[lambda_row] = tmp;
-                
-                /* 交换列 */
-                for (int i = 0; i < n; i++) {
-                    double tmp_val = dense_A[i][k + 1];
-                    dense_A[i][k + 1] = dense_A[i][lambda_row];
-                    dense_A[i][lambda_row] = tmp_val;
-                }
+
+        if (size == 1) {
+            ldlt_swap(F, ld, m, rows, p, pc);
+
+            double *cp = F + (size_t)p * ld;
+            double d = cp[p];
+            for (int j = p + 1; j < k; j++) {
+                w[j] = cp[j];
             }
-            
-            /* 计算2x2块 */
-            double a11 = dense_A[k][k];
-            double a12 = dense_A[k][k + 1];
-            double a22 = dense_A[k + 1][k + 1];
-            double det = a11 * a22 - a12 * a12;
-            
-            if (fabs(det) < 1e-15) {
-                for (int i = 0; i < n; i++) {
-                    free(dense_A[i]);
-                }
-                free(dense_A);
-                return PARD_ERROR_NUMERICAL;
+            double inv_d = 1.0 / d;
+            for (int i = p + 1; i < m; i++) {
+                cp[i] *= inv_d;
             }
-            
-            /* 2x2块的D矩阵：D = inv(A_block) = [a22/det  -a12/det; -a12/det  a11/det] */
-            /* 但我们需要存储的是块对角形式，这里简化：只存储对角元素 */
-            factors->d_values[k] = a22 / det;
-            factors->d_values[k + 1] = a11 / det;
-            
-            /* 更新剩余矩阵：对于2x2块，L的更新更复杂 */
-            /* 首先计算 L = A * inv(D)，其中D是2x2块 */
-            for (int i = k + 2; i < n; i++) {
-                double l1_old = dense_A[i][k];
-                double l2_old = dense_A[i][k + 1];
-                
-                /* L[i][k] 和 L[i][k+1] 的更新 */
-                dense_A[i][k] = (a22 * l1_old - a12 * l2_old) / det;
-                dense_A[i][k + 1] = (a11 * l2_old - a12 * l1_old) / det;
-                
-                /* 更新 A[i][j] = A[i][j] - L[i][k]*A[k][j] - L[i][k+1]*A[k+1][j] */
-                for (int j = k + 2; j < n; j++) {
-                    dense_A[i][j] -= dense_A[i][k] * dense_A[k][j] + 
-                                     dense_A[i][k + 1] * dense_A[k + 1][j];
+
+            /* 更新其余完全求和列（所有行） */
+            for (int j = p + 1; j < k; j++) {
+                double *cj = F + (size_t)j * ld;
+                double u = w[j];
+                if (u != 0.0) {
+                    for (int i = j; i < m; i++) {
+                        cj[i] -= cp[i] * u;
+                    }
                 }
             }
-            
-            k += 2;
+
+            piv[p] = 1;
+            p++;
         } else {
-            /* 1x1主元 */
-            factors->pivot_type[k] = 1;
-            
-            if (pivot_row != k) {
-                /* 交换行 */
-                double *tmp = dense_A[k];
-                dense_A[k] = dense_A[pivot_row];
-                dense_A[pivot_row] = tmp;
-                
-                /* 交换列 */
-                for (int i = 0; i < n; i++) {
-                    double tmp_val = dense_A[i][k];
-                    dense_A[i][k] = dense_A[i][pivot_row];
-                    dense_A[i][pivot_row] = tmp_val;
-                }
-                
-                /* 记录置换 */
-                int tmp_perm = factors->perm[k];
-                factors->perm[k] = factors->perm[pivot_row];
-                factors->perm[pivot_row] = tmp_perm;
+            ldlt_swap(F, ld, m, rows, p, pc);
+            if (pr == p) {
+                pr = pc;
             }
-            
-            factors->d_values[k] = dense_A[k][k];
-            
-            /* 检查数值稳定性：使用相对阈值 */
-            double max_diag = fabs(dense_A[k][k]);
-            for (int i = k; i < n; i++) {
-                if (fabs(dense_A[i][i]) > max_diag) {
-                    max_diag = fabs(dense_A[i][i]);
-                }
+            ldlt_swap(F, ld, m, rows, p + 1, pr);
+
+            double *c0 = F + (size_t)p * ld;
+            double *c1 = F + (size_t)(p + 1) * ld;
+            double a = c0[p], b = c0[p + 1], c = c1[p + 1];
+            double det = a * c - b * b;
+            if (det == 0.0) {
+                err = PARD_ERROR_NUMERICAL;
+                break;
             }
-            if (fabs(factors->d_values[k]) < 1e-12 * max_diag) {
-                for (int i = 0; i < n; i++) {
-                    free(dense_A[i]);
-                }
-                free(dense_A);
-                return PARD_ERROR_NUMERICAL;
+            for (int j = p + 2; j < k; j++) {
+                w[j] = c0[j];
+                w2[j] = c1[j];
+            }
+            /* L = [A(i,p) A(i,p+1)] * D^-1 */
+            for (int i = p + 2; i < m; i++) {
+                double x0 = c0[i], x1 = c1[i];
+                c0[i] = (c * x0 - b * x1) / det;
+                c1[i] = (a * x1 - b * x0) / det;
             }
-            
-            /* 更新剩余矩阵 */
-            for (int i = k + 1; i < n; i++) {
-                dense_A[i][k] /= factors->d_values[k];
-                for (int j = k + 1; j < n; j++) {
-                    dense_A[i][j] -= dense_A[i][k] * dense_A[k][j];
+
+            for (int j = p + 2; j < k; j++) {
+                double *cj = F + (size_t)j * ld;
+                double u0 = w[j], u1 = w2[j];
+                if (u0 != 0.0 || u1 != 0.0) {
+                    for (int i = j; i < m; i++) {
+                        cj[i] -= c0[i] * u0 + c1[i] * u1;
+                    }
                 }
             }
-            
-            k++;
+
+            piv[p] = 2;
+            piv[p + 1] = 2;
+            p += 2;
         }
     }
-    
-    /* 将L复制到factors */
-    int pos = 0;
-    for (int i = 0; i < n; i++) {
-        factors->row_ptr[i] = pos;
-        for (int j = 0; j < i; j++) {
-            if (fabs(dense_A[i][j]) > 1e-15) {
-                factors->col_idx[pos] = j;
-                factors->l_values[pos] = dense_A[i][j];
-                pos++;
+
+    *npiv = p;
+
+    /* Schur补：C -= L21 * D * L21^T */
+    if (err == PARD_SUCCESS && p > 0 && k < m) {
+        int mc = m - k;
+        for (int t = 0; t < p; ) {
+            const double *l0 = F + k + (size_t)t * ld;
+            double *W0 = W + (size_t)t * mc;
+            if (piv[t] == 1) {
+                double d = F[t + (size_t)t * ld];
+                for (int i = 0; i < mc; i++) {
+                    W0[i] = l0[i] * d;
+                }
+                t++;
+            } else {
+                const double *l1 = l0 + ld;
+                double *W1 = W0 + mc;
+                double a = F[t + (size_t)t * ld];
+                double b = F[t + 1 + (size_t)t * ld];
+                double c = F[t + 1 + (size_t)(t + 1) * ld];
+                for (int i = 0; i < mc; i++) {
+                    W0[i] = l0[i] * a + l1[i] * b;
+                    W1[i] = l0[i] * b + l1[i] * c;
+                }
+                t += 2;
             }
         }
-        /* 对角线元素设为1 */
-        factors->col_idx[pos] = i;
-        factors->l_values[pos] = 1.0;
-        pos++;
+        pard_dense_gemm_lower_mt(mc, mc, p, W, mc,
+                                 F + k, ld,
+                                 F + k + (size_t)k * ld, ld, nthreads);
     }
-    factors->row_ptr[n] = pos;
-    factors->nnz = pos;
-    
-    /* 清理 */
-    for (int i = 0; i < n; i++) {
-        free(dense_A[i]);
+
+    free(w);
+    return err;
+}
+
+/**
+ * LDL^T分解（对称不定矩阵，使用Bunch-Kaufman主元）
+ * 将矩阵A分解为P*A*P^T = L*D*L^T，D由1x1和2x2对角块组成，
+ * 2x2块的非对角元存放在factors->d_offdiag中。
+ * 使用超节点多波前方法，主元在波前的完全求和块内选取，无法选取时推迟到父波前
+ */
+int pard_ldlt_factorization(pard_solver_t *solver) {
+    if (solver == NULL || solver->matrix == NULL || solver->factors == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
     }
-    free(dense_A);
-    
-    return PARD_SUCCESS;
+
+    return pard_multifrontal_factorization(solver);
 }
@@ -0,0 +1,1558 @@
+#include "pard.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/* 前向声明 */
+extern int pard_cholesky_front(double *F, int ld, int m, int k, int nthreads);
+extern int pard_lu_front(double *F, int ld, int mr, int mc, int k, int *rows, int *cols,
+                         int is_root, double tiny, int *npiv, int nthreads);
+extern int pard_ldlt_front(double *F, int ld, int m, int k, int *rows,
+                           int *piv, double tiny, int *npiv, int nthreads);
+extern int pard_get_num_threads(const pard_solver_t *solver);
+extern int pard_solve_schedule(pard_factors_t *factors, int nthreads);
+extern int pard_ooc_open(pard_ooc_t **ooc, const char *dir, size_t limit, int npanels, int is_lu);
+extern int pard_ooc_write(pard_ooc_t *ooc, int s, int m, int k, double *L, double *U);
+extern int pard_ooc_flush(pard_ooc_t *ooc);
+extern void pard_ooc_close(pard_ooc_t *ooc);
+extern int pard_ooc_stream_begin(pard_ooc_t *ooc, const int *order, int count);
+extern int pard_ooc_stream_next(pard_ooc_t *ooc, double **L, double **U);
+extern void pard_ooc_stream_release(pard_ooc_t *ooc);
+extern void pard_ooc_stream_end(pard_ooc_t *ooc);
+
+/* 树并行阶段的子树个数至少为线程数的该倍数，便于负载均衡 */
+#define PARD_MF_SUBTREES_PER_THREAD 2
+
+/**
+ * 多波前分解的类型
+ */
+typedef enum {
+    MF_KIND_CHOLESKY,    /* 对称正定：波前仅使用下三角 */
+    MF_KIND_LDLT,        /* 对称不定：波前仅使用下三角，1x1/2x2主元 */
+    MF_KIND_LU           /* 非对称：行、列索引分别维护 */
+} mf_kind_t;
+
+/**
+ * 多波前分解使用的超节点结构
+ * 由置换后矩阵的对称模式 A+A^T 得到
+ */
+typedef struct {
+    int n;
+    int nsuper;
+    int *super_ptr;      /* 第s个超节点包含列[super_ptr[s], super_ptr[s+1]) */
+    int *col_to_super;   /* 每列所属的超节点 */
+    int *super_parent;   /* 超节点消元树，根为-1 */
+    int *child_head;     /* 超节点子节点链表 */
+    int *child_next;
+    int *row_ptr;        /* 超节点下方的行结构（不含自身列），长度nsuper+1 */
+    int *row_idx;
+    int *asm_ptr;        /* 按超节点归类的原矩阵元素下标，长度nsuper+1 */
+    int *asm_idx;
+    int *asm_row;        /* 对应元素所在的行 */
+} mf_structure_t;
+
+/**
+ * 已完成波前的因子面板
+ * 对称情形cols为NULL（与rows相同）且U为NULL
+ */
+typedef struct {
+    int m;          /* 波前阶数 */
+    int k;          /* 实际消去的主元数 */
+    int *rows;      /* 行全局索引，前k个为主元行 */
+    int *cols;      /* 列全局索引，前k个为主元列 */
+    double *L;      /* m×k 列主序面板，上方k×k块的严格下三角为单位L11（LU），对角块为D（LDLT） */
+    double *U;      /* k×m 列主序面板（LU） */
+    float *Lf;      /* 混合精度模式：L、U舍入为单精度保存，L、U为NULL */
+    float *Uf;
+    int *piv;       /* 主元类型，1或2（LDLT） */
+    double *d;      /* LDLT的D，外存模式写出面板前或混合精度模式舍入前提取，否则为NULL（由mf_keep_panels提取） */
+} mf_block_t;
+
+/**
+ * 传递给父波前的贡献块
+ */
+typedef struct {
+    int m;          /* 贡献块阶数 */
+    int ndelay;     /* 被推迟的主元数，位于索引列表最前面 */
+    int *rows;      /* 行全局索引 */
+    int *cols;      /* 列全局索引（对称情形为NULL） */
+    double *C;      /* m×m 列主序，对称情形仅下三角有效 */
+} mf_contrib_t;
+
+/**
+ * 分解过程的共享状态
+ * 不同超节点的blocks/contribs互不重叠，子节点的贡献块只由父节点读取并释放
+ */
+typedef struct {
+    const pard_csr_matrix_t *A;
+    const mf_structure_t *st;
+    mf_kind_t kind;
+    mf_block_t *blocks;
+    mf_contrib_t *contribs;
+    pard_ooc_t *ooc;         /* 非NULL时完成的面板交给后台线程写入外存 */
+    int single;              /* 混合精度：波前完成时面板直接舍入为单精度 */
+    double tiny;             /* 主元视为零的阈值：eps*max|a_ij|，每次分解计算一次 */
+} mf_context_t;
+
+/**
+ * 每个线程私有的工作区
+ */
+typedef struct {
+    int *rmap;               /* 全局行号 -> 当前波前局部行号 */
+    int *cmap;               /* 全局列号 -> 当前波前局部列号（对称情形与rmap相同） */
+} mf_workspace_t;
+
+/**
+ * 任务双端队列（环形缓冲）：所有者从尾部取（后进先出，保持局部性），其他线程从头部窃取。
+ * 只有所有者入队，且只在刚完成一个任务后压入父节点，而所有者只在本地队列为空时才窃取，
+ * 因此队列长度不超过初始任务数与1的较大者
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    int *items;
+    int cap;
+    int head;
+    int tail;
+} mf_deque_t;
+
+/**
+ * 树并行阶段的调度器
+ * 找不到任务的线程在idle_cond上睡眠，任务入队、全部完成或出错时唤醒；
+ * queued在idle_lock之外修改，唤醒方修改后再加锁发信号，睡眠方持锁检查，不会丢失唤醒
+ */
+typedef struct {
+    mf_context_t *ctx;
+    mf_deque_t *deques;
+    int nworkers;
+    const char *is_top;      /* 顶层超节点，留给第二阶段 */
+    atomic_int *pending;     /* 尚未完成的子节点数 */
+    atomic_int remaining;    /* 尚未完成的树并行任务数 */
+    atomic_int queued;       /* 各队列中等待处理的任务数 */
+    atomic_int error;
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cond;
+} mf_scheduler_t;
+
+typedef struct {
+    mf_scheduler_t *sched;
+    int id;
+    mf_workspace_t ws;
+} mf_worker_t;
+
+static void mf_structure_free(mf_structure_t *st) {
+    free(st->super_ptr);
+    free(st->col_to_super);
+    free(st->super_parent);
+    free(st->child_head);
+    free(st->child_next);
+    free(st->row_ptr);
+    free(st->row_idx);
+    free(st->asm_ptr);
+    free(st->asm_idx);
+    free(st->asm_row);
+    memset(st, 0, sizeof(*st));
+}
+
+/**
+ * 构建对称模式 A+A^T 的严格下三角行结构：第k行列出所有i<k且A(k,i)或A(i,k)非零的i
+ * 同时存在A(k,i)与A(i,k)时会出现重复，后续遍历对重复不敏感
+ */
+static int mf_lower_pattern(const pard_csr_matrix_t *A, int **lp_ptr, int **lp_idx) {
+    int n = A->n;
+    int *ptr = (int *)calloc(n + 1, sizeof(int));
+    if (ptr == NULL) {
+        return PARD_ERROR_MEMORY;
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++) {
+            int j = A->col_idx[p];
+            if (j != i) {
+                ptr[(i > j ? i : j) + 1]++;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        ptr[i + 1] += ptr[i];
+    }
+
+    int *idx = (int *)malloc((ptr[n] > 0 ? ptr[n] : 1) * sizeof(int));
+    int *pos = (int *)malloc(n * sizeof(int));
+    if (idx == NULL || pos == NULL) {
+        free(ptr);
+        free(idx);
+        free(pos);
+        return PARD_ERROR_MEMORY;
+    }
+    memcpy(pos, ptr, n * sizeof(int));
+
+    for (int i = 0; i < n; i++) {
+        for (int p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++) {
+            int j = A->col_idx[p];
+            if (j < i) {
+                idx[pos[i]++] = j;
+            } else if (j > i) {
+                idx[pos[j]++] = i;
+            }
+        }
+    }
+
+    free(pos);
+    *lp_ptr = ptr;
+    *lp_idx = idx;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 符号分析未提供超节点时的后备：消元树、列计数、基本超节点及其行结构
+ * 所有遍历都基于消元树上的行子树，总代价为O(|L|)
+ */
+static int mf_fundamental_structure(const pard_csr_matrix_t *A, mf_structure_t *st) {
+    int n = A->n;
+    memset(st, 0, sizeof(*st));
+    st->n = n;
+
+    int *lp_ptr = NULL, *lp_idx = NULL;
+    int err = mf_lower_pattern(A, &lp_ptr, &lp_idx);
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+
+    int *parent = (int *)malloc(n * sizeof(int));
+    int *ancestor = (int *)malloc(n * sizeof(int));
+    int *colcount = (int *)calloc(n, sizeof(int));
+    int *nchild = (int *)calloc(n, sizeof(int));
+    int *mark = (int *)malloc(n * sizeof(int));
+    if (parent == NULL || ancestor == NULL || colcount == NULL ||
+        nchild == NULL || mark == NULL) {
+        free(lp_ptr);
+        free(lp_idx);
+        free(parent);
+        free(ancestor);
+        free(colcount);
+        free(nchild);
+        free(mark);
+        return PARD_ERROR_MEMORY;
+    }
+
+    /* 消元树（带路径压缩的祖先数组） */
+    for (int k = 0; k < n; k++) {
+        parent[k] = -1;
+        ancestor[k] = -1;
+        for (int p = lp_ptr[k]; p < lp_ptr[k + 1]; p++) {
+            int i = lp_idx[p];
+            while (i != -1 && i < k) {
+                int next = ancestor[i];
+                ancestor[i] = k;
+                if (next == -1) {
+                    parent[i] = k;
+                }
+                i = next;
+            }
+        }
+    }
+
+    /* 列计数：L的第k行是A第k行各非零元到k在消元树上路径的并集 */
+    for (int k = 0; k < n; k++) {
+        mark[k] = k;
+        for (int p = lp_ptr[k]; p < lp_ptr[k + 1]; p++) {
+            for (int j = lp_idx[p]; mark[j] != k; j = parent[j]) {
+                mark[j] = k;
+                colcount[j]++;
+            }
+        }
+    }
+    for (int j = 0; j < n; j++) {
+        if (parent[j] != -1) {
+            nchild[parent[j]]++;
+        }
+    }
+
+    /* 基本超节点：j与j+1合并当且仅当j+1是j唯一的父节点、j是j+1唯一的子节点且结构相同 */
+    st->col_to_super = (int *)malloc(n * sizeof(int));
+    st->super_ptr = (int *)malloc((n + 1) * sizeof(int));
+    if (st->col_to_super == NULL || st->super_ptr == NULL) {
+        err = PARD_ERROR_MEMORY;
+    } else {
+        int ns = 0;
+        for (int j = 0; j < n; j++) {
+            if (j == 0 || parent[j - 1] != j || nchild[j] != 1 ||
+                colcount[j - 1] != colcount[j] + 1) {
+                st->super_ptr[ns++] = j;
+            }
+            st->col_to_super[j] = ns - 1;
+        }
+        st->super_ptr[ns] = n;
+        st->nsuper = ns;
+
+        st->super_parent = (int *)malloc(ns * sizeof(int));
+        st->row_ptr = (int *)calloc(ns + 1, sizeof(int));
+        if (st->super_parent == NULL || st->row_ptr == NULL) {
+            err = PARD_ERROR_MEMORY;
+        }
+    }
+
+    if (err == PARD_SUCCESS) {
+        int ns = st->nsuper;
+        for (int s = 0; s < ns; s++) {
+            int last = st->super_ptr[s + 1] - 1;
+            st->super_parent[s] = (parent[last] == -1) ? -1 : st->col_to_super[parent[last]];
+        }
+
+        /* 超节点行结构：两遍行子树遍历（计数、填充），行号天然递增 */
+        int *smark = (int *)malloc(ns * sizeof(int));
+        if (smark == NULL) {
+            err = PARD_ERROR_MEMORY;
+        } else {
+            for (int pass = 0; pass < 2 && err == PARD_SUCCESS; pass++) {
+                int *fill = NULL;
+                if (pass == 1) {
+                    for (int s = 0; s < ns; s++) {
+                        st->row_ptr[s + 1] += st->row_ptr[s];
+                    }
+                    st->row_idx = (int *)malloc((st->row_ptr[ns] > 0 ? st->row_ptr[ns] : 1) * sizeof(int));
+                    fill = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+                    if (st->row_idx == NULL || fill == NULL) {
+                        free(fill);
+                        err = PARD_ERROR_MEMORY;
+                        break;
+                    }
+                    memcpy(fill, st->row_ptr, ns * sizeof(int));
+                }
+                for (int s = 0; s < ns; s++) {
+                    smark[s] = -1;
+                }
+                for (int k = 0; k < n; k++) {
+                    mark[k] = -1;
+                }
+                for (int k = 0; k < n; k++) {
+                    mark[k] = k;
+                    for (int p = lp_ptr[k]; p < lp_ptr[k + 1]; p++) {
+                        for (int j = lp_idx[p]; mark[j] != k; j = parent[j]) {
+                            mark[j] = k;
+                            int s = st->col_to_super[j];
+                            if (k >= st->super_ptr[s + 1] && smark[s] != k) {
+                                smark[s] = k;
+                                if (pass == 0) {
+                                    st->row_ptr[s + 1]++;
+                                } else {
+                                    st->row_idx[fill[s]++] = k;
+                                }
+                            }
+                        }
+                    }
+                }
+                free(fill);
+            }
+            free(smark);
+        }
+    }
+
+    free(lp_ptr);
+    free(lp_idx);
+    free(parent);
+    free(ancestor);
+    free(colcount);
+    free(nchild);
+    free(mark);
+
+    if (err != PARD_SUCCESS) {
+        mf_structure_free(st);
+    }
+    return err;
+}
+
+/**
+ * 使用符号分析得到的超节点划分（可能含松弛合并）：复制划分、超节点消元树和行结构
+ */
+static int mf_structure_from_factors(const pard_factors_t *factors, mf_structure_t *st) {
+    int n = factors->n;
+    int ns = factors->nsuper;
+    int nrows = factors->super_row_ptr[ns];
+    memset(st, 0, sizeof(*st));
+    st->n = n;
+    st->nsuper = ns;
+    st->super_ptr = (int *)malloc((ns + 1) * sizeof(int));
+    st->col_to_super = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    st->super_parent = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    st->row_ptr = (int *)malloc((ns + 1) * sizeof(int));
+    st->row_idx = (int *)malloc((nrows > 0 ? nrows : 1) * sizeof(int));
+    if (st->super_ptr == NULL || st->col_to_super == NULL || st->super_parent == NULL ||
+        st->row_ptr == NULL || st->row_idx == NULL) {
+        mf_structure_free(st);
+        return PARD_ERROR_MEMORY;
+    }
+    memcpy(st->super_ptr, factors->super_ptr, (ns + 1) * sizeof(int));
+    memcpy(st->super_parent, factors->super_parent, ns * sizeof(int));
+    memcpy(st->row_ptr, factors->super_row_ptr, (ns + 1) * sizeof(int));
+    memcpy(st->row_idx, factors->super_row_idx, nrows * sizeof(int));
+    for (int s = 0; s < ns; s++) {
+        for (int j = st->super_ptr[s]; j < st->super_ptr[s + 1]; j++) {
+            st->col_to_super[j] = s;
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 分析阶段：超节点划分与行结构（优先使用符号分析的结果），
+ * 然后建立子节点链表，并把原矩阵元素按超节点归类
+ */
+static int mf_analyze(const pard_csr_matrix_t *A, const pard_factors_t *factors,
+                      mf_structure_t *st) {
+    int err;
+    if (factors->super_ptr != NULL && factors->nsuper > 0 &&
+        factors->super_ptr[factors->nsuper] == A->n) {
+        err = mf_structure_from_factors(factors, st);
+    } else {
+        err = mf_fundamental_structure(A, st);
+    }
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+
+    int n = A->n;
+    int ns = st->nsuper;
+    st->child_head = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    st->child_next = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    if (st->child_head == NULL || st->child_next == NULL) {
+        mf_structure_free(st);
+        return PARD_ERROR_MEMORY;
+    }
+    for (int s = 0; s < ns; s++) {
+        st->child_head[s] = -1;
+    }
+    /* 逆序插入使子节点链表按编号递增 */
+    for (int s = ns - 1; s >= 0; s--) {
+        int p = st->super_parent[s];
+        if (p != -1) {
+            st->child_next[s] = st->child_head[p];
+            st->child_head[p] = s;
+        } else {
+            st->child_next[s] = -1;
+        }
+    }
+
+    /* 原矩阵元素按超节点归类：元素(i,j)由min(i,j)所在的超节点组装 */
+    st->asm_ptr = (int *)calloc(ns + 1, sizeof(int));
+    st->asm_idx = (int *)malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(int));
+    st->asm_row = (int *)malloc((A->nnz > 0 ? A->nnz : 1) * sizeof(int));
+    int *fill = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    if (st->asm_ptr == NULL || st->asm_idx == NULL || st->asm_row == NULL || fill == NULL) {
+        err = PARD_ERROR_MEMORY;
+    } else {
+        for (int i = 0; i < n; i++) {
+            for (int p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++) {
+                int j = A->col_idx[p];
+                st->asm_ptr[st->col_to_super[i < j ? i : j] + 1]++;
+            }
+        }
+        for (int s = 0; s < ns; s++) {
+            st->asm_ptr[s + 1] += st->asm_ptr[s];
+        }
+        memcpy(fill, st->asm_ptr, ns * sizeof(int));
+        for (int i = 0; i < n; i++) {
+            for (int p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++) {
+                int j = A->col_idx[p];
+                int q = fill[st->col_to_super[i < j ? i : j]]++;
+                st->asm_idx[q] = p;
+                st->asm_row[q] = i;
+            }
+        }
+    }
+    free(fill);
+
+    if (err != PARD_SUCCESS) {
+        mf_structure_free(st);
+    }
+    return err;
+}
+
+/**
+ * 释放因子中保存的超节点面板（面板描述数组还不存在时也释放面板索引）
+ */
+void pard_free_panels(pard_factors_t *factors) {
+    if (factors == NULL) {
+        return;
+    }
+    for (int s = 0; factors->panels != NULL && s < factors->npanels; s++) {
+        pard_panel_t *P = &factors->panels[s];
+        free(P->rows);
+        free(P->cols);
+        free(P->L);
+        free(P->U);
+        free(P->Lf);
+        free(P->Uf);
+        free(P->piv);
+        free(P->d);
+    }
+    free(factors->panels);
+    free(factors->row_panel);
+    free(factors->col_panel);
+    free(factors->panel_owner);
+    free(factors->top_row_index);
+    free(factors->top_col_index);
+    factors->panels = NULL;
+    factors->npanels = 0;
+    factors->row_panel = NULL;
+    factors->col_panel = NULL;
+    factors->panel_owner = NULL;
+    factors->top_row_index = NULL;
+    factors->top_col_index = NULL;
+    factors->ntop_rows = 0;
+    factors->sched_nthreads = 0;
+    pard_ooc_close(factors->ooc);
+    factors->ooc = NULL;
+}
+
+/**
+ * LDL^T面板中D的对角块移到d（长度2k+1），原位置清零，使面板的上方k×k块成为单位下三角L11
+ */
+static void mf_extract_d(mf_block_t *b, double *d) {
+    for (int t = 0; t < b->k; t++) {
+        d[t] = b->L[t + (size_t)t * b->m];
+        if (b->piv[t] == 2 && t + 1 < b->k) {
+            d[b->k + t] = b->L[t + 1 + (size_t)t * b->m];
+            d[t + 1] = b->L[t + 1 + (size_t)(t + 1) * b->m];
+            b->L[t + 1 + (size_t)t * b->m] = 0.0;
+            t++;
+        }
+    }
+}
+
+/**
+ * 把各超节点的面板移交给因子，因子的数值只保存在面板中
+ * LDL^T面板的D由mf_extract_d移到P->d；
+ * 同时记录每个主元行（列）所在的面板，供稀疏右端项求解定位起点，
+ * 以及主元顺序factors->perm/col_perm（第t个主元的行/列，被推迟的主元排在祖先面板中）。
+ * 混合精度模式下面板已在波前完成时舍入为单精度（Lf、Uf），直接移交。
+ * 外存模式下L、U已写入ctx->ooc，面板只保留索引与D，ctx->ooc随之移交给因子
+ */
+static int mf_keep_panels(pard_factors_t *factors, mf_context_t *ctx) {
+    int ns = ctx->st->nsuper;
+    int n = factors->n;
+    int is_lu = (ctx->kind == MF_KIND_LU);
+
+    /* 根波前中仍未消去的主元 */
+    int npiv = 0;
+    for (int s = 0; s < ns; s++) {
+        npiv += ctx->blocks[s].k;
+    }
+    if (npiv != n) {
+        return PARD_ERROR_NUMERICAL;
+    }
+
+    pard_panel_t *panels = (pard_panel_t *)calloc(ns > 0 ? ns : 1, sizeof(pard_panel_t));
+    int *row_panel = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *col_panel = is_lu ? (int *)malloc((n > 0 ? n : 1) * sizeof(int)) : NULL;
+    int *perm = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *col_perm = is_lu ? (int *)malloc((n > 0 ? n : 1) * sizeof(int)) : NULL;
+    if (panels == NULL || row_panel == NULL || perm == NULL ||
+        (is_lu && (col_panel == NULL || col_perm == NULL))) {
+        free(panels);
+        free(row_panel);
+        free(col_panel);
+        free(perm);
+        free(col_perm);
+        return PARD_ERROR_MEMORY;
+    }
+
+    if (ctx->kind == MF_KIND_LDLT) {
+        for (int s = 0; s < ns; s++) {
+            int k = ctx->blocks[s].k;
+            if (ctx->blocks[s].d != NULL) {
+                continue;
+            }
+            panels[s].d = (double *)calloc(2 * (size_t)k + 1, sizeof(double));
+            if (panels[s].d == NULL) {
+                for (int t = 0; t < s; t++) {
+                    free(panels[t].d);
+                }
+                free(panels);
+                free(row_panel);
+                free(col_panel);
+                free(perm);
+                free(col_perm);
+                return PARD_ERROR_MEMORY;
+            }
+        }
+    }
+    int step = 0;
+    for (int s = 0; s < ns; s++) {
+        mf_block_t *b = &ctx->blocks[s];
+        pard_panel_t *P = &panels[s];
+        P->m = b->m;
+        P->k = b->k;
+        P->parent = ctx->st->super_parent[s];
+        P->rows = b->rows;
+        P->cols = b->cols;
+        P->L = b->L;
+        P->U = b->U;
+        P->Lf = b->Lf;
+        P->Uf = b->Uf;
+        P->piv = b->piv;
+        for (int t = 0; t < b->k; t++, step++) {
+            row_panel[b->rows[t]] = s;
+            perm[step] = b->rows[t];
+            if (is_lu) {
+                col_panel[b->cols[t]] = s;
+                col_perm[step] = b->cols[t];
+            }
+        }
+        if (ctx->kind == MF_KIND_LDLT) {
+            if (b->d != NULL) {
+                P->d = b->d;
+            } else {
+                mf_extract_d(b, P->d);
+            }
+        }
+        memset(b, 0, sizeof(*b));
+    }
+
+    pard_free_panels(factors);
+    free(factors->perm);
+    free(factors->col_perm);
+    factors->perm = perm;
+    factors->col_perm = col_perm;
+    factors->npanels = ns;
+    factors->panels = panels;
+    factors->row_panel = row_panel;
+    factors->col_panel = col_panel;
+    factors->ooc = ctx->ooc;
+    ctx->ooc = NULL;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 释放导出的CSR因子数值与D（结构数组保留，下次导出时替换）
+ */
+void pard_free_csr_values(pard_factors_t *factors) {
+    if (factors == NULL) {
+        return;
+    }
+    free(factors->l_values);
+    free(factors->u_values);
+    free(factors->d_values);
+    free(factors->d_offdiag);
+    free(factors->pivot_type);
+    factors->l_values = NULL;
+    factors->u_values = NULL;
+    factors->d_values = NULL;
+    factors->d_offdiag = NULL;
+    factors->pivot_type = NULL;
+}
+
+/* 面板L(a,t)、U(t,a)的双精度值（单精度面板转换） */
+static double mf_panel_l(const pard_panel_t *P, const double *L, int a, int t) {
+    return (L != NULL) ? L[a + (size_t)t * P->m] : (double)P->Lf[a + (size_t)t * P->m];
+}
+
+static double mf_panel_u(const pard_panel_t *P, const double *U, int t, int a) {
+    return (U != NULL) ? U[t + (size_t)a * P->k] : (double)P->Uf[t + (size_t)a * P->k];
+}
+
+/**
+ * 按需（pardiso_set_csr_factors）把面板导出为CSR因子：P*A*Q = L*U，
+ * L、U的行列都按主元顺序编号（第t个主元为重排后矩阵的第perm[t]行、第col_perm[t]列），
+ * 取代符号分解的结构数组；L每行的列号递增，含单位对角元。
+ * Cholesky因子 A = L*L^T 以 A = (L*D^-1)*(D*L^T)（D = diag(L)）的形式导出，与LU的形式相同。
+ * LDL^T因子 P*A*P^T = L*D*L^T 只导出单位下三角L（U的结构数组置为NULL），
+ * D写入d_values/d_offdiag/pivot_type：2x2块的两个主元pivot_type都为2，
+ * d_offdiag记在块的第一个主元上，块内的L(i+1,i)恒为0，不存储。
+ * 单精度面板转为双精度导出，外存面板按编号顺序读回。
+ * 导出的数组与面板互相独立，求解仍使用面板
+ */
+static int mf_export_csr(pard_factors_t *factors) {
+    int n = factors->n;
+    int ns = factors->npanels;
+    int is_chol = (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF);
+    int is_ldlt = (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF);
+    size_t nb = (size_t)(n > 0 ? n : 1);
+
+    int *rpos = (int *)malloc(nb * sizeof(int));
+    int *cpos = (int *)malloc(nb * sizeof(int));
+    int *piv_start = (int *)malloc((ns + 1) * sizeof(int));
+    int *order = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    int *l_row_ptr = (int *)calloc(n + 1, sizeof(int));
+    int *u_row_ptr = is_ldlt ? NULL : (int *)calloc(n + 1, sizeof(int));
+    int *l_pos = (int *)malloc(nb * sizeof(int));
+    double *d_values = is_ldlt ? (double *)malloc(nb * sizeof(double)) : NULL;
+    double *d_offdiag = is_ldlt ? (double *)calloc(nb, sizeof(double)) : NULL;
+    int *pivot_type = is_ldlt ? (int *)malloc(nb * sizeof(int)) : NULL;
+    int *pair_second = is_ldlt ? (int *)calloc(nb, sizeof(int)) : NULL;
+    if (rpos == NULL || cpos == NULL || piv_start == NULL || order == NULL ||
+        l_row_ptr == NULL || l_pos == NULL || (!is_ldlt && u_row_ptr == NULL) ||
+        (is_ldlt && (d_values == NULL || d_offdiag == NULL ||
+                     pivot_type == NULL || pair_second == NULL))) {
+        free(rpos);
+        free(cpos);
+        free(piv_start);
+        free(order);
+        free(l_row_ptr);
+        free(u_row_ptr);
+        free(l_pos);
+        free(d_values);
+        free(d_offdiag);
+        free(pivot_type);
+        free(pair_second);
+        return PARD_ERROR_MEMORY;
+    }
+
+    /* 主元位置 */
+    const int *col_perm = (factors->col_perm != NULL) ? factors->col_perm : factors->perm;
+    for (int t = 0; t < n; t++) {
+        rpos[factors->perm[t]] = t;
+        cpos[col_perm[t]] = t;
+    }
+    piv_start[0] = 0;
+    for (int s = 0; s < ns; s++) {
+        piv_start[s + 1] = piv_start[s] + factors->panels[s].k;
+        order[s] = s;
+    }
+
+    /* D的对角块（面板中常驻，外存模式也不必读回），pair_second标记2x2块的第二个主元 */
+    for (int s = 0; is_ldlt && s < ns; s++) {
+        const pard_panel_t *P = &factors->panels[s];
+        for (int t = 0; t < P->k; t++) {
+            int i = piv_start[s] + t;
+            d_values[i] = P->d[t];
+            pivot_type[i] = 1;
+            if (P->piv[t] == 2 && t + 1 < P->k) {
+                d_offdiag[i] = P->d[P->k + t];
+                d_values[i + 1] = P->d[t + 1];
+                pivot_type[i] = 2;
+                pivot_type[i + 1] = 2;
+                pair_second[i + 1] = 1;
+                t++;
+            }
+        }
+    }
+
+    /* 计数：面板第a行在L中贡献min(a,k)个非对角元（主元行另加对角1），U的第t行长度为m-t */
+    for (int s = 0; s < ns; s++) {
+        const pard_panel_t *P = &factors->panels[s];
+        for (int a = 0; a < P->m; a++) {
+            int cnt = (a < P->k) ? a + 1 : P->k;
+            if (is_ldlt && a < P->k && pair_second[piv_start[s] + a]) {
+                cnt--;
+            }
+            l_row_ptr[rpos[P->rows[a]] + 1] += cnt;
+        }
+        for (int t = 0; !is_ldlt && t < P->k; t++) {
+            u_row_ptr[piv_start[s] + t + 1] = P->m - t;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        l_row_ptr[i + 1] += l_row_ptr[i];
+        if (!is_ldlt) {
+            u_row_ptr[i + 1] += u_row_ptr[i];
+        }
+    }
+
+    int l_nnz = l_row_ptr[n];
+    int u_nnz = is_ldlt ? 0 : u_row_ptr[n];
+    int *l_col_idx = (int *)malloc((l_nnz > 0 ? l_nnz : 1) * sizeof(int));
+    double *l_values = (double *)malloc((l_nnz > 0 ? l_nnz : 1) * sizeof(double));
+    int *u_col_idx = is_ldlt ? NULL : (int *)malloc((u_nnz > 0 ? u_nnz : 1) * sizeof(int));
+    double *u_values = is_ldlt ? NULL : (double *)malloc((u_nnz > 0 ? u_nnz : 1) * sizeof(double));
+    int err = PARD_SUCCESS;
+    if (l_col_idx == NULL || l_values == NULL ||
+        (!is_ldlt && (u_col_idx == NULL || u_values == NULL))) {
+        err = PARD_ERROR_MEMORY;
+    }
+    if (err == PARD_SUCCESS && factors->ooc != NULL) {
+        err = pard_ooc_stream_begin(factors->ooc, order, ns);
+    }
+    memcpy(l_pos, l_row_ptr, n * sizeof(int));
+
+    /* 按主元位置递增顺序填充，L每行的列号天然递增 */
+    for (int s = 0; s < ns && err == PARD_SUCCESS; s++) {
+        const pard_panel_t *P = &factors->panels[s];
+        const int *pcols = (P->cols != NULL) ? P->cols : P->rows;
+        const double *L = P->L;
+        const double *U = P->U;
+        if (factors->ooc != NULL) {
+            double *Ls = NULL, *Us = NULL;
+            err = pard_ooc_stream_next(factors->ooc, &Ls, &Us);
+            if (err != PARD_SUCCESS) {
+                break;
+            }
+            L = Ls;
+            U = Us;
+        }
+        for (int a = 0; a < P->m; a++) {
+            int i = rpos[P->rows[a]];
+            int kmax = (a < P->k) ? a : P->k;
+            if (is_ldlt && a < P->k && pair_second[i]) {
+                kmax--;
+            }
+            for (int t = 0; t < kmax; t++) {
+                double v = mf_panel_l(P, L, a, t);
+                if (is_chol) {
+                    v /= mf_panel_l(P, L, t, t);
+                }
+                l_col_idx[l_pos[i]] = piv_start[s] + t;
+                l_values[l_pos[i]] = v;
+                l_pos[i]++;
+            }
+            if (a < P->k) {
+                l_col_idx[l_pos[i]] = i;
+                l_values[l_pos[i]] = 1.0;
+                l_pos[i]++;
+            }
+        }
+        for (int t = 0; !is_ldlt && t < P->k; t++) {
+            int up = u_row_ptr[piv_start[s] + t];
+            double d = is_chol ? mf_panel_l(P, L, t, t) : 0.0;
+            for (int a = t; a < P->m; a++) {
+                u_col_idx[up] = cpos[pcols[a]];
+                u_values[up] = is_chol ? d * mf_panel_l(P, L, a, t) : mf_panel_u(P, U, t, a);
+                up++;
+            }
+        }
+        if (factors->ooc != NULL) {
+            pard_ooc_stream_release(factors->ooc);
+        }
+    }
+    if (factors->ooc != NULL) {
+        pard_ooc_stream_end(factors->ooc);
+    }
+
+    free(rpos);
+    free(cpos);
+    free(piv_start);
+    free(order);
+    free(l_pos);
+    free(pair_second);
+    if (err != PARD_SUCCESS) {
+        free(l_row_ptr);
+        free(u_row_ptr);
+        free(l_col_idx);
+        free(l_values);
+        free(u_col_idx);
+        free(u_values);
+        free(d_values);
+        free(d_offdiag);
+        free(pivot_type);
+        return err;
+    }
+
+    free(factors->row_ptr);
+    free(factors->col_idx);
+    free(factors->u_row_ptr);
+    free(factors->u_col_idx);
+    pard_free_csr_values(factors);
+    factors->row_ptr = l_row_ptr;
+    factors->col_idx = l_col_idx;
+    factors->l_values = l_values;
+    factors->u_row_ptr = u_row_ptr;
+    factors->u_col_idx = u_col_idx;
+    factors->u_values = u_values;
+    factors->d_values = d_values;
+    factors->d_offdiag = d_offdiag;
+    factors->pivot_type = pivot_type;
+    factors->nnz = l_nnz + u_nnz;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 释放面板与贡献块
+ */
+static void mf_free_blocks(mf_block_t *blocks, mf_contrib_t *contribs, int nsuper) {
+    for (int s = 0; s < nsuper; s++) {
+        if (blocks != NULL) {
+            free(blocks[s].rows);
+            free(blocks[s].cols);
+            free(blocks[s].L);
+            free(blocks[s].U);
+            free(blocks[s].Lf);
+            free(blocks[s].Uf);
+            free(blocks[s].piv);
+            free(blocks[s].d);
+        }
+        if (contribs != NULL) {
+            free(contribs[s].rows);
+            free(contribs[s].cols);
+            free(contribs[s].C);
+        }
+    }
+    free(blocks);
+    free(contribs);
+}
+
+/**
+ * 组装波前：原矩阵元素与子节点贡献块（扩展加）
+ */
+static void mf_assemble(const mf_context_t *ctx, const mf_workspace_t *ws,
+                        int s, double *F, int m) {
+    const pard_csr_matrix_t *A = ctx->A;
+    const mf_structure_t *st = ctx->st;
+    const int *rmap = ws->rmap;
+    const int *cmap = ws->cmap;
+
+    /* 原矩阵元素：对称矩阵可能同时存储两个三角，镜像位置取同一值，因此直接赋值 */
+    for (int q = st->asm_ptr[s]; q < st->asm_ptr[s + 1]; q++) {
+        int p = st->asm_idx[q];
+        int i = rmap[st->asm_row[q]];
+        int j = cmap[A->col_idx[p]];
+        if (ctx->kind == MF_KIND_LU) {
+            F[i + (size_t)j * m] = A->values[p];
+        } else if (i >= j) {
+            F[i + (size_t)j * m] = A->values[p];
+        } else {
+            F[j + (size_t)i * m] = A->values[p];
+        }
+    }
+
+    /* 扩展加：将子节点的贡献块累加到当前波前 */
+    for (int c = st->child_head[s]; c != -1; c = st->child_next[c]) {
+        mf_contrib_t *cb = &ctx->contribs[c];
+        if (cb->C == NULL) {
+            continue;
+        }
+        if (ctx->kind == MF_KIND_LU) {
+            for (int b = 0; b < cb->m; b++) {
+                double *dst = F + (size_t)cmap[cb->cols[b]] * m;
+                const double *src = cb->C + (size_t)b * cb->m;
+                for (int a = 0; a < cb->m; a++) {
+                    dst[rmap[cb->rows[a]]] += src[a];
+                }
+            }
+        } else {
+            for (int b = 0; b < cb->m; b++) {
+                int lb = rmap[cb->rows[b]];
+                const double *src = cb->C + (size_t)b * cb->m;
+                for (int a = b; a < cb->m; a++) {
+                    int la = rmap[cb->rows[a]];
+                    if (la >= lb) {
+                        F[la + (size_t)lb * m] += src[a];
+                    } else {
+                        F[lb + (size_t)la * m] += src[a];
+                    }
+                }
+            }
+        }
+        free(cb->rows);
+        free(cb->cols);
+        free(cb->C);
+        cb->rows = NULL;
+        cb->cols = NULL;
+        cb->C = NULL;
+    }
+}
+
+/**
+ * 外存模式：面板的L、U交给写回线程（LDL^T先提取D），内存中只留索引。
+ * 后续波前只读取贡献块，不再访问已完成的面板
+ */
+static int mf_spill_block(mf_context_t *ctx, int s) {
+    mf_block_t *b = &ctx->blocks[s];
+    if (ctx->kind == MF_KIND_LDLT) {
+        b->d = (double *)calloc(2 * (size_t)b->k + 1, sizeof(double));
+        if (b->d == NULL) {
+            return PARD_ERROR_MEMORY;
+        }
+        if (b->L != NULL) {
+            mf_extract_d(b, b->d);
+        }
+    }
+    int err = pard_ooc_write(ctx->ooc, s, b->m, b->k, b->L, b->U);
+    b->L = NULL;
+    b->U = NULL;
+    return err;
+}
+
+/**
+ * 混合精度模式：把波前F（阶数b->m）中刚完成的面板直接舍入为单精度Lf、Uf，不保留双精度副本。
+ * LDL^T的D先以双精度提取到b->d（mf_extract_d只改动F的主元块，不影响随后复制的贡献块）
+ */
+static int mf_round_block(const mf_context_t *ctx, mf_block_t *b, double *F) {
+    int m = b->m, k = b->k;
+    size_t size = (size_t)m * k;
+    if (ctx->kind == MF_KIND_LDLT) {
+        b->d = (double *)calloc(2 * (size_t)k + 1, sizeof(double));
+        if (b->d == NULL) {
+            return PARD_ERROR_MEMORY;
+        }
+        b->L = F;
+        mf_extract_d(b, b->d);
+        b->L = NULL;
+    }
+    b->Lf = (float *)malloc(size * sizeof(float));
+    if (b->Lf == NULL) {
+        return PARD_ERROR_MEMORY;
+    }
+    for (size_t q = 0; q < size; q++) {
+        b->Lf[q] = (float)F[q];
+    }
+    if (ctx->kind == MF_KIND_LU) {
+        b->Uf = (float *)malloc(size * sizeof(float));
+        if (b->Uf == NULL) {
+            return PARD_ERROR_MEMORY;
+        }
+        for (int j = 0; j < m; j++) {
+            for (int t = 0; t < k; t++) {
+                b->Uf[t + (size_t)j * k] = (float)F[t + (size_t)j * m];
+            }
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 处理一个超节点：组装波前、部分分解、保存面板并生成贡献块
+ * 波前的完全求和部分由超节点自身列和子节点推迟的主元组成，
+ * 稠密部分分解使用nthreads个线程
+ */
+static int mf_process_front(mf_context_t *ctx, const mf_workspace_t *ws, int s,
+                            int nthreads) {
+    const mf_structure_t *st = ctx->st;
+    int is_lu = (ctx->kind == MF_KIND_LU);
+    int is_ldlt = (ctx->kind == MF_KIND_LDLT);
+    int is_root = (st->super_parent[s] == -1);
+
+    int first = st->super_ptr[s];
+    int ncol = st->super_ptr[s + 1] - first;
+    int nrow = st->row_ptr[s + 1] - st->row_ptr[s];
+    int ndelay = 0;
+    for (int c = st->child_head[s]; c != -1; c = st->child_next[c]) {
+        ndelay += ctx->contribs[c].ndelay;
+    }
+    int k = ncol + ndelay;
+    int m = k + nrow;
+
+    int *rows = (int *)malloc(m * sizeof(int));
+    int *cols = is_lu ? (int *)malloc(m * sizeof(int)) : NULL;
+    int *piv = is_ldlt ? (int *)malloc((k > 0 ? k : 1) * sizeof(int)) : NULL;
+    double *F = (double *)calloc((size_t)m * m, sizeof(double));
+    if (rows == NULL || (is_lu && cols == NULL) || (is_ldlt && piv == NULL) || F == NULL) {
+        free(rows);
+        free(cols);
+        free(piv);
+        free(F);
+        return PARD_ERROR_MEMORY;
+    }
+
+    /* 波前索引：超节点自身列、子节点推迟的主元、下方行结构 */
+    int t = 0;
+    for (int j = 0; j < ncol; j++, t++) {
+        rows[t] = first + j;
+        if (is_lu) {
+            cols[t] = first + j;
+        }
+    }
+    for (int c = st->child_head[s]; c != -1; c = st->child_next[c]) {
+        const mf_contrib_t *cb = &ctx->contribs[c];
+        for (int d = 0; d < cb->ndelay; d++, t++) {
+            rows[t] = cb->rows[d];
+            if (is_lu) {
+                cols[t] = cb->cols[d];
+            }
+        }
+    }
+    memcpy(rows + k, st->row_idx + st->row_ptr[s], nrow * sizeof(int));
+    if (is_lu) {
+        memcpy(cols + k, st->row_idx + st->row_ptr[s], nrow * sizeof(int));
+    }
+    for (t = 0; t < m; t++) {
+        ws->rmap[rows[t]] = t;
+        if (is_lu) {
+            ws->cmap[cols[t]] = t;
+        }
+    }
+
+    mf_assemble(ctx, ws, s, F, m);
+
+    int npiv = k;
+    int err;
+    if (is_lu) {
+        err = pard_lu_front(F, m, m, m, k, rows, cols, is_root, ctx->tiny, &npiv, nthreads);
+    } else if (is_ldlt) {
+        err = pard_ldlt_front(F, m, m, k, rows, piv, ctx->tiny, &npiv, nthreads);
+    } else {
+        err = pard_cholesky_front(F, m, m, k, nthreads);
+    }
+    if (err != PARD_SUCCESS) {
+        free(rows);
+        free(cols);
+        free(piv);
+        free(F);
+        return err;
+    }
+
+    /* 保存面板 */
+    mf_block_t *b = &ctx->blocks[s];
+    b->m = m;
+    b->k = npiv;
+    b->rows = rows;
+    b->cols = cols;
+    b->piv = piv;
+    if (npiv > 0 && ctx->single) {
+        if (mf_round_block(ctx, b, F) != PARD_SUCCESS) {
+            free(F);
+            return PARD_ERROR_MEMORY;
+        }
+    } else if (npiv > 0) {
+        b->L = (double *)malloc((size_t)m * npiv * sizeof(double));
+        if (b->L == NULL) {
+            free(F);
+            return PARD_ERROR_MEMORY;
+        }
+        memcpy(b->L, F, (size_t)m * npiv * sizeof(double));
+        if (is_lu) {
+            b->U = (double *)malloc((size_t)npiv * m * sizeof(double));
+            if (b->U == NULL) {
+                free(F);
+                return PARD_ERROR_MEMORY;
+            }
+            for (int j = 0; j < m; j++) {
+                memcpy(b->U + (size_t)j * npiv, F + (size_t)j * m, npiv * sizeof(double));
+            }
+        }
+    }
+
+    /* 贡献块：推迟的主元位于最前面 */
+    int mc = m - npiv;
+    if (mc > 0 && !is_root) {
+        mf_contrib_t *cb = &ctx->contribs[s];
+        cb->m = mc;
+        cb->ndelay = k - npiv;
+        cb->rows = (int *)malloc(mc * sizeof(int));
+        cb->cols = is_lu ? (int *)malloc(mc * sizeof(int)) : NULL;
+        cb->C = (double *)malloc((size_t)mc * mc * sizeof(double));
+        if (cb->rows == NULL || (is_lu && cb->cols == NULL) || cb->C == NULL) {
+            free(F);
+            return PARD_ERROR_MEMORY;
+        }
+        memcpy(cb->rows, rows + npiv, mc * sizeof(int));
+        if (is_lu) {
+            memcpy(cb->cols, cols + npiv, mc * sizeof(int));
+        }
+        for (int j = 0; j < mc; j++) {
+            int i0 = is_lu ? 0 : j;
+            memcpy(cb->C + (size_t)j * mc + i0, F + npiv + i0 + (size_t)(npiv + j) * m,
+                   (mc - i0) * sizeof(double));
+        }
+    }
+
+    free(F);
+    if (ctx->ooc != NULL) {
+        return mf_spill_block(ctx, s);
+    }
+    return PARD_SUCCESS;
+}
+
+static int mf_workspace_init(mf_workspace_t *ws, int n, mf_kind_t kind) {
+    ws->rmap = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    ws->cmap = (kind == MF_KIND_LU) ? (int *)malloc((n > 0 ? n : 1) * sizeof(int)) : ws->rmap;
+    if (ws->rmap == NULL || ws->cmap == NULL) {
+        if (ws->cmap != ws->rmap) {
+            free(ws->cmap);
+        }
+        free(ws->rmap);
+        ws->rmap = NULL;
+        ws->cmap = NULL;
+        return PARD_ERROR_MEMORY;
+    }
+    return PARD_SUCCESS;
+}
+
+static void mf_workspace_free(mf_workspace_t *ws) {
+    if (ws->cmap != ws->rmap) {
+        free(ws->cmap);
+    }
+    free(ws->rmap);
+    ws->rmap = NULL;
+    ws->cmap = NULL;
+}
+
+static void mf_deque_push(mf_deque_t *dq, int s) {
+    pthread_mutex_lock(&dq->lock);
+    dq->items[dq->tail++ % dq->cap] = s;
+    pthread_mutex_unlock(&dq->lock);
+}
+
+/**
+ * 唤醒等待任务的线程：all非零时唤醒全部（任务全部完成或出错）
+ */
+static void mf_sched_wake(mf_scheduler_t *sched, int all) {
+    pthread_mutex_lock(&sched->idle_lock);
+    if (all) {
+        pthread_cond_broadcast(&sched->idle_cond);
+    } else {
+        pthread_cond_signal(&sched->idle_cond);
+    }
+    pthread_mutex_unlock(&sched->idle_lock);
+}
+
+/**
+ * 所有者从尾部取任务，空时返回-1
+ */
+static int mf_deque_pop(mf_deque_t *dq) {
+    int s = -1;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail > dq->head) {
+        s = dq->items[--dq->tail % dq->cap];
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return s;
+}
+
+/**
+ * 从头部窃取任务（最早入队的任务通常离叶子最远，对应的子树工作量更大）
+ */
+static int mf_deque_steal(mf_deque_t *dq) {
+    int s = -1;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail > dq->head) {
+        s = dq->items[dq->head++ % dq->cap];
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return s;
+}
+
+/**
+ * 树并行阶段的工作线程：处理本地任务，本地为空时依次尝试从其他线程窃取，
+ * 所有队列都为空时睡眠到有新任务入队。
+ * 一个超节点的最后一个子节点完成后，父节点被压入完成者的本地队列
+ */
+static void *mf_worker_main(void *arg) {
+    mf_worker_t *w = (mf_worker_t *)arg;
+    mf_scheduler_t *sched = w->sched;
+    const mf_structure_t *st = sched->ctx->st;
+
+    while (atomic_load(&sched->remaining) > 0 &&
+           atomic_load(&sched->error) == PARD_SUCCESS) {
+        int s = mf_deque_pop(&sched->deques[w->id]);
+        for (int t = 1; s < 0 && t < sched->nworkers; t++) {
+            s = mf_deque_steal(&sched->deques[(w->id + t) % sched->nworkers]);
+        }
+        if (s < 0) {
+            pthread_mutex_lock(&sched->idle_lock);
+            while (atomic_load(&sched->queued) == 0 &&
+                   atomic_load(&sched->remaining) > 0 &&
+                   atomic_load(&sched->error) == PARD_SUCCESS) {
+                pthread_cond_wait(&sched->idle_cond, &sched->idle_lock);
+            }
+            pthread_mutex_unlock(&sched->idle_lock);
+            continue;
+        }
+        atomic_fetch_sub(&sched->queued, 1);
+
+        int err = mf_process_front(sched->ctx, &w->ws, s, 1);
+        if (err != PARD_SUCCESS) {
+            int expected = PARD_SUCCESS;
+            atomic_compare_exchange_strong(&sched->error, &expected, err);
+            mf_sched_wake(sched, 1);
+        }
+
+        int p = st->super_parent[s];
+        if (p != -1 && !sched->is_top[p] && atomic_fetch_sub(&sched->pending[p], 1) == 1) {
+            mf_deque_push(&sched->deques[w->id], p);
+            atomic_fetch_add(&sched->queued, 1);
+            mf_sched_wake(sched, 0);
+        }
+        if (atomic_fetch_sub(&sched->remaining, 1) == 1) {
+            mf_sched_wake(sched, 1);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 划分树并行阶段与顶层阶段
+ * 以 k*m^2 估计每个波前的运算量，从根开始反复拆开运算量最大的子树（其根标记为顶层），
+ * 直到最大子树不超过总量的 1/(PARD_MF_SUBTREES_PER_THREAD*nworkers)。
+ * 剩余子树互相独立，由工作线程并行处理；顶层超节点数量少、波前大，
+ * 随后按编号顺序处理，在波前内部使用多线程稠密核函数
+ */
+static int mf_split_tree(const mf_structure_t *st, int nworkers, char *is_top) {
+    int ns = st->nsuper;
+    double *work = (double *)malloc((ns > 0 ? ns : 1) * sizeof(double));
+    int *cand = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    if (work == NULL || cand == NULL) {
+        free(work);
+        free(cand);
+        return PARD_ERROR_MEMORY;
+    }
+
+    double total = 0.0;
+    int ncand = 0;
+    for (int s = 0; s < ns; s++) {
+        double k = (double)(st->super_ptr[s + 1] - st->super_ptr[s]);
+        double m = k + (double)(st->row_ptr[s + 1] - st->row_ptr[s]);
+        work[s] = k * m * m;
+        is_top[s] = 0;
+    }
+    /* 子节点编号小于父节点，按编号顺序累加得到子树运算量 */
+    for (int s = 0; s < ns; s++) {
+        if (st->super_parent[s] != -1) {
+            work[st->super_parent[s]] += work[s];
+        } else {
+            total += work[s];
+            cand[ncand++] = s;
+        }
+    }
+
+    double limit = total / ((double)PARD_MF_SUBTREES_PER_THREAD * nworkers);
+    while (ncand > 0) {
+        int best = 0;
+        for (int a = 1; a < ncand; a++) {
+            if (work[cand[a]] > work[cand[best]]) {
+                best = a;
+            }
+        }
+        int x = cand[best];
+        if (work[x] <= limit) {
+            break;
+        }
+        is_top[x] = 1;
+        cand[best] = cand[--ncand];
+        for (int c = st->child_head[x]; c != -1; c = st->child_next[c]) {
+            cand[ncand++] = c;
+        }
+    }
+
+    free(work);
+    free(cand);
+    return PARD_SUCCESS;
+}
+
+/**
+ * 树并行阶段：用nworkers个线程（含调用线程）处理所有非顶层超节点
+ * 非顶层叶子按编号（后序）连续分段，作为各线程的初始任务，使同一子树的叶子落在同一线程
+ */
+static int mf_tree_parallel(mf_context_t *ctx, const char *is_top, int nworkers,
+                            mf_workspace_t *ws) {
+    const mf_structure_t *st = ctx->st;
+    int ns = st->nsuper;
+
+    int ntasks = 0, nleaves = 0;
+    for (int s = 0; s < ns; s++) {
+        if (!is_top[s]) {
+            ntasks++;
+            if (st->child_head[s] == -1) {
+                nleaves++;
+            }
+        }
+    }
+    if (ntasks == 0) {
+        return PARD_SUCCESS;
+    }
+
+    mf_scheduler_t sched;
+    sched.ctx = ctx;
+    sched.nworkers = nworkers;
+    sched.is_top = is_top;
+    sched.deques = (mf_deque_t *)calloc(nworkers, sizeof(mf_deque_t));
+    sched.pending = (atomic_int *)malloc(ns * sizeof(atomic_int));
+    int *items = (int *)malloc(((size_t)nleaves + nworkers) * sizeof(int));
+    mf_worker_t *workers = (mf_worker_t *)calloc(nworkers, sizeof(mf_worker_t));
+    pthread_t *tids = (pthread_t *)malloc(nworkers * sizeof(pthread_t));
+    int *started = (int *)calloc(nworkers, sizeof(int));
+    if (sched.deques == NULL || sched.pending == NULL || items == NULL ||
+        workers == NULL || tids == NULL || started == NULL) {
+        free(sched.deques);
+        free(sched.pending);
+        free(items);
+        free(workers);
+        free(tids);
+        free(started);
+        return PARD_ERROR_MEMORY;
+    }
+
+    /* 第leaf个叶子分给线程leaf*nworkers/nleaves */
+    int offset = 0;
+    for (int w = 0; w < nworkers; w++) {
+        int lo = (int)(((long long)w * nleaves + nworkers - 1) / nworkers);
+        int hi = (int)(((long long)(w + 1) * nleaves + nworkers - 1) / nworkers);
+        pthread_mutex_init(&sched.deques[w].lock, NULL);
+        sched.deques[w].items = items + offset;
+        sched.deques[w].cap = hi - lo + 1;
+        sched.deques[w].head = 0;
+        sched.deques[w].tail = 0;
+        offset += hi - lo + 1;
+        workers[w].sched = &sched;
+        workers[w].id = w;
+        workers[w].ws = ws[w];
+    }
+    for (int s = 0; s < ns; s++) {
+        atomic_init(&sched.pending[s], 0);
+    }
+    for (int s = 0; s < ns; s++) {
+        if (!is_top[s] && st->super_parent[s] != -1) {
+            atomic_fetch_add(&sched.pending[st->super_parent[s]], 1);
+        }
+    }
+    atomic_init(&sched.remaining, ntasks);
+    atomic_init(&sched.queued, nleaves);
+    atomic_init(&sched.error, PARD_SUCCESS);
+    pthread_mutex_init(&sched.idle_lock, NULL);
+    pthread_cond_init(&sched.idle_cond, NULL);
+
+    int leaf = 0;
+    for (int s = 0; s < ns; s++) {
+        if (!is_top[s] && st->child_head[s] == -1) {
+            mf_deque_t *dq = &sched.deques[(int)((long long)leaf * nworkers / nleaves)];
+            dq->items[dq->tail++] = s;
+            leaf++;
+        }
+    }
+
+    /* 线程创建失败时其初始任务会被其他线程窃取 */
+    for (int w = 1; w < nworkers; w++) {
+        started[w] = (pthread_create(&tids[w], NULL, mf_worker_main, &workers[w]) == 0);
+    }
+    mf_worker_main(&workers[0]);
+    for (int w = 1; w < nworkers; w++) {
+        if (started[w]) {
+            pthread_join(tids[w], NULL);
+        }
+    }
+
+    int err = atomic_load(&sched.error);
+    for (int w = 0; w < nworkers; w++) {
+        pthread_mutex_destroy(&sched.deques[w].lock);
+    }
+    pthread_mutex_destroy(&sched.idle_lock);
+    pthread_cond_destroy(&sched.idle_cond);
+    free(sched.deques);
+    free(sched.pending);
+    free(items);
+    free(workers);
+    free(tids);
+    free(started);
+    return err;
+}
+
+/**
+ * 多波前数值分解（超节点版本）
+ * 按超节点消元树自底向上处理，每个波前只包含因子的非零结构，
+ * 稠密部分分解与Schur补更新由分块核函数完成。
+ * 对称正定矩阵使用Cholesky波前，对称不定矩阵使用Bunch-Kaufman主元的LDL^T波前，
+ * 非对称矩阵使用带阈值部分主元的LU波前。
+ * 多线程时分两个阶段：互相独立的子树由工作窃取调度器并行处理，
+ * 其上的顶层大波前按顺序处理，波前内部的Schur补更新按列划分给各线程。
+ * 混合精度模式下每个波前完成时面板即舍入为单精度，双精度面板不在内存中累积；
+ * 设置了外存目录时完成的面板由后台线程写入临时文件，常驻的面板数值不超过内存上限，
+ * 混合精度设置此时不起作用
+ */
+int pard_multifrontal_factorization(pard_solver_t *solver) {
+    if (solver == NULL || solver->matrix == NULL || solver->factors == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    pard_csr_matrix_t *A = solver->matrix;
+    pard_factors_t *factors = solver->factors;
+    int n = A->n;
+
+    if (n <= 0 || factors->n != n) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    mf_structure_t st;
+    int err = mf_analyze(A, factors, &st);
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+
+    mf_context_t ctx;
+    ctx.A = A;
+    ctx.st = &st;
+    if (solver->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF) {
+        ctx.kind = MF_KIND_CHOLESKY;
+    } else if (solver->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF) {
+        ctx.kind = MF_KIND_LDLT;
+    } else {
+        ctx.kind = MF_KIND_LU;
+    }
+
+    int nthreads = pard_get_num_threads(solver);
+    if (nthreads > st.nsuper) {
+        nthreads = st.nsuper > 0 ? st.nsuper : 1;
+    }
+
+    ctx.ooc = NULL;
+    ctx.single = solver->mixed_precision && solver->ooc_dir == NULL;
+    /* 零主元与奇异性按矩阵的量级判断，整体缩放矩阵不改变分解是否成功 */
+    double amax = 0.0;
+    for (int p = 0; p < A->nnz; p++) {
+        amax = fmax(amax, fabs(A->values[p]));
+    }
+    ctx.tiny = DBL_EPSILON * amax;
+    ctx.blocks = (mf_block_t *)calloc(st.nsuper, sizeof(mf_block_t));
+    ctx.contribs = (mf_contrib_t *)calloc(st.nsuper, sizeof(mf_contrib_t));
+    char *is_top = (char *)malloc(st.nsuper > 0 ? st.nsuper : 1);
+    mf_workspace_t *ws = (mf_workspace_t *)calloc(nthreads, sizeof(mf_workspace_t));
+    if (ctx.blocks == NULL || ctx.contribs == NULL || is_top == NULL || ws == NULL) {
+        free(is_top);
+        free(ws);
+        mf_free_blocks(ctx.blocks, ctx.contribs, 0);
+        mf_structure_free(&st);
+        return PARD_ERROR_MEMORY;
+    }
+    for (int w = 0; w < nthreads && err == PARD_SUCCESS; w++) {
+        err = mf_workspace_init(&ws[w], n, ctx.kind);
+    }
+
+    if (err == PARD_SUCCESS && solver->ooc_dir != NULL) {
+        err = pard_ooc_open(&ctx.ooc, solver->ooc_dir, solver->ooc_memory_limit, st.nsuper,
+                            ctx.kind == MF_KIND_LU);
+    }
+
+    /* 单线程时所有超节点都在顶层阶段按顺序处理 */
+    if (err == PARD_SUCCESS) {
+        if (nthreads > 1) {
+            err = mf_split_tree(&st, nthreads, is_top);
+            if (err == PARD_SUCCESS) {
+                err = mf_tree_parallel(&ctx, is_top, nthreads, ws);
+            }
+        } else {
+            memset(is_top, 1, st.nsuper);
+        }
+    }
+
+    /* 子超节点编号总是小于父超节点，按编号顺序即为合法的自底向上顺序 */
+    for (int s = 0; s < st.nsuper && err == PARD_SUCCESS; s++) {
+        if (is_top[s]) {
+            err = mf_process_front(&ctx, &ws[0], s, nthreads);
+        }
+    }
+
+    /* 等待写回线程写完全部面板 */
+    if (ctx.ooc != NULL) {
+        int ferr = pard_ooc_flush(ctx.ooc);
+        if (err == PARD_SUCCESS) {
+            err = ferr;
+        }
+    }
+    if (err == PARD_SUCCESS) {
+        err = mf_keep_panels(factors, &ctx);
+    }
+    if (err == PARD_SUCCESS) {
+        err = pard_solve_schedule(factors, nthreads);
+    }
+    if (err == PARD_SUCCESS && solver->csr_factors) {
+        err = mf_export_csr(factors);
+    }
+    if (err != PARD_SUCCESS) {
+        pard_free_panels(factors);
+    }
+    if (err == PARD_SUCCESS) {
+        factors->single_precision = ctx.single;
+    }
+
+    for (int w = 0; w < nthreads; w++) {
+        mf_workspace_free(&ws[w]);
+    }
+    free(ws);
+    free(is_top);
+    pard_ooc_close(ctx.ooc);
+    mf_free_blocks(ctx.blocks, ctx.contribs, st.nsuper);
+    mf_structure_free(&st);
+
+    return err;
+}
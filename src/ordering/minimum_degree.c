@@ -2,97 +2,477 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <math.h>
+
+/* 前向声明 */
+extern int pard_build_symmetric_graph(const pard_csr_matrix_t *matrix, int **xadj, int **adj);
+extern void pard_csr_release_storage(pard_csr_matrix_t *matrix);
+int apply_permutation_map(pard_csr_matrix_t *matrix, const int *perm, const int *inv_perm,
+                          int *map);
+
+/* 已吸收对象的父节点编码：FLIP(i) = -i-2，FLIP(-1) = -1 保持为根 */
+#define AMD_FLIP(i) (-(i) - 2)
+
+/**
+ * 构建 A+A^T 的邻接结构，并预留elbow room供商图生成新元素
+ * 返回的idx数组长度为*nzmax
+ */
+static int amd_build_graph(const pard_csr_matrix_t *matrix, int **ptr_out, int **idx_out,
+                           int *nzmax) {
+    int n = matrix->n;
+    int *ptr = NULL, *idx = NULL;
+    int err = pard_build_symmetric_graph(matrix, &ptr, &idx);
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+
+    /* 在末尾预留 nnz/5 + 2n 的空间 */
+    int cnz = ptr[n];
+    int size = cnz + cnz / 5 + 2 * n + 1;
+    int *grown = (int *)realloc(idx, size * sizeof(int));
+    if (grown == NULL) {
+        free(ptr);
+        free(idx);
+        return PARD_ERROR_MEMORY;
+    }
+
+    *ptr_out = ptr;
+    *idx_out = grown;
+    *nzmax = size;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 清空标记数组w：保证返回后所有存活对象满足 w[i] < mark
+ */
+static int amd_clear_mark(int mark, int lemax, int *w, int n) {
+    if (mark < 2 || mark + lemax < 0) {
+        for (int k = 0; k < n; k++) {
+            if (w[k] != 0) {
+                w[k] = 1;
+            }
+        }
+        mark = 2;
+    }
+    return mark;
+}
+
+/**
+ * 非递归深度优先后序遍历以j为根的树，post[k..]依次写入后序节点，返回新的k
+ */
+static int amd_tree_dfs(int j, int k, int *head, const int *next, int *post, int *stack) {
+    int top = 0;
+    stack[0] = j;
+    while (top >= 0) {
+        int p = stack[top];
+        int i = head[p];
+        if (i == -1) {
+            top--;
+            post[k++] = p;
+        } else {
+            head[p] = next[i];
+            stack[++top] = i;
+        }
+    }
+    return k;
+}
 
 /**
  * 近似最小度算法（AMD）
- * 返回置换数组perm，使得perm[i]是原矩阵第i行在新矩阵中的位置
+ * 在商图（quotient graph）上模拟对称消元：已消去的节点成为元素（element），
+ * 变量的邻接表由元素列表和剩余的原始边组成，不显式生成fill-in。
+ * 使用近似外部度、按度分桶的双向链表、哈希检测不可区分变量（超变量）、
+ * 质量消元（mass elimination）与主动元素吸收（aggressive absorption），
+ * 度数超过 max(16, 10*sqrt(n)) 的稠密行被推迟到最后。
+ * 最终对组装树做后序遍历得到消元顺序。
+ * 返回perm[k]为第k个消去的原节点，inv_perm[i]为原节点i的新位置
  */
 int pard_minimum_degree(const pard_csr_matrix_t *matrix, int **perm, int **inv_perm) {
     if (matrix == NULL || perm == NULL || inv_perm == NULL) {
         return PARD_ERROR_INVALID_INPUT;
     }
-    
+
     int n = matrix->n;
-    
-    *perm = (int *)malloc(n * sizeof(int));
-    *inv_perm = (int *)malloc(n * sizeof(int));
+
+    *perm = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    *inv_perm = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
     if (*perm == NULL || *inv_perm == NULL) {
-        if (*perm != NULL) free(*perm);
-        if (*inv_perm != NULL) free(*inv_perm);
+        free(*perm);
+        free(*inv_perm);
+        *perm = NULL;
+        *inv_perm = NULL;
         return PARD_ERROR_MEMORY;
     }
-    
-    /* 初始化：所有节点都未消除 */
-    int *eliminated = (int *)calloc(n, sizeof(int));
-    int *degree = (int *)malloc(n * sizeof(int));
-    if (eliminated == NULL || degree == NULL) {
+
+    int *Cp = NULL, *Ci = NULL, nzmax = 0;
+    int err = amd_build_graph(matrix, &Cp, &Ci, &nzmax);
+    /* 工作数组：8个长度为n+1的整型数组，外加长度为n+1的后序结果 */
+    int *work = (err == PARD_SUCCESS) ? (int *)malloc(9 * (size_t)(n + 1) * sizeof(int)) : NULL;
+    if (err != PARD_SUCCESS || work == NULL) {
+        free(Cp);
+        free(Ci);
         free(*perm);
         free(*inv_perm);
-        free(eliminated);
-        free(degree);
+        *perm = NULL;
+        *inv_perm = NULL;
         return PARD_ERROR_MEMORY;
     }
-    
-    /* 计算初始度 */
+
+    int *len = work;                     /* 邻接表长度 */
+    int *nv = work + (n + 1);            /* 超变量大小，0表示已被吸收 */
+    int *next = work + 2 * (n + 1);      /* 度链表/哈希链表的后继 */
+    int *head = work + 3 * (n + 1);      /* 度链表表头 */
+    int *elen = work + 4 * (n + 1);      /* 邻接表中元素的个数，-2表示已成为元素 */
+    int *degree = work + 5 * (n + 1);    /* 近似外部度 */
+    int *w = work + 6 * (n + 1);         /* 标记数组 */
+    int *hhead = work + 7 * (n + 1);     /* 哈希桶表头 */
+    int *last = work + 8 * (n + 1);      /* 度链表前驱；最后复用为后序结果 */
+
+    int dense = (int)(10.0 * sqrt((double)n));
+    if (dense < 16) {
+        dense = 16;
+    }
+    if (dense > n - 2) {
+        dense = n - 2;
+    }
+
+    int cnz = Cp[n];
+    int nel = 0, mindeg = 0, lemax = 0;
+
+    /* 初始化商图 */
+    for (int k = 0; k < n; k++) {
+        len[k] = Cp[k + 1] - Cp[k];
+    }
+    len[n] = 0;
+    for (int i = 0; i <= n; i++) {
+        head[i] = -1;
+        last[i] = -1;
+        next[i] = -1;
+        hhead[i] = -1;
+        nv[i] = 1;
+        w[i] = 1;
+        elen[i] = 0;
+        degree[i] = len[i];
+    }
+    int mark = amd_clear_mark(0, 0, w, n);
+    /* 虚拟元素n收纳所有稠密行 */
+    elen[n] = -2;
+    Cp[n] = -1;
+    w[n] = 0;
+
+    /* 初始化度链表 */
     for (int i = 0; i < n; i++) {
-        degree[i] = 0;
-        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-            int col = matrix->col_idx[j];
-            if (col != i) {
-                degree[i]++;
+        int d = degree[i];
+        if (d == 0) {
+            /* 孤立节点直接成为元素 */
+            elen[i] = -2;
+            nel++;
+            Cp[i] = -1;
+            w[i] = 0;
+        } else if (d > dense) {
+            /* 稠密节点吸收进元素n */
+            nv[i] = 0;
+            elen[i] = -1;
+            nel++;
+            Cp[i] = AMD_FLIP(n);
+            nv[n]++;
+        } else {
+            if (head[d] != -1) {
+                last[head[d]] = i;
             }
+            next[i] = head[d];
+            head[d] = i;
         }
     }
-    
-    /* 贪心选择：每次选择度最小的节点 */
-    int order = 0;
-    while (order < n) {
-        /* 找到度最小的未消除节点 */
-        int min_degree = INT_MAX;
-        int min_node = -1;
-        
-        for (int i = 0; i < n; i++) {
-            if (!eliminated[i] && degree[i] < min_degree) {
-                min_degree = degree[i];
-                min_node = i;
+
+    while (nel < n) {
+        /* 选择近似度最小的节点k */
+        int k = -1;
+        for (; mindeg < n && (k = head[mindeg]) == -1; mindeg++) {
+        }
+        if (next[k] != -1) {
+            last[next[k]] = -1;
+        }
+        head[mindeg] = next[k];
+        int elenk = elen[k];
+        int nvk = nv[k];
+        nel += nvk;
+
+        /* 空间不足时压缩Ci（垃圾回收） */
+        if (elenk > 0 && cnz + mindeg >= nzmax) {
+            for (int j = 0; j < n; j++) {
+                int p = Cp[j];
+                if (p >= 0) {
+                    Cp[j] = Ci[p];
+                    Ci[p] = AMD_FLIP(j);
+                }
             }
+            int q = 0;
+            for (int p = 0; p < cnz; ) {
+                int j = AMD_FLIP(Ci[p++]);
+                if (j >= 0) {
+                    Ci[q] = Cp[j];
+                    Cp[j] = q++;
+                    for (int k3 = 0; k3 < len[j] - 1; k3++) {
+                        Ci[q++] = Ci[p++];
+                    }
+                }
+            }
+            cnz = q;
         }
-        
-        if (min_node == -1) {
-            break;  /* 所有节点都已处理 */
+
+        /* 构造新元素Lk：k的元素列表与原始邻居的并集 */
+        int dk = 0;
+        nv[k] = -nvk;
+        int p = Cp[k];
+        int pk1 = (elenk == 0) ? p : cnz;
+        int pk2 = pk1;
+        for (int k1 = 1; k1 <= elenk + 1; k1++) {
+            int e, pj, ln;
+            if (k1 > elenk) {
+                e = k;
+                pj = p;
+                ln = len[k] - elenk;
+            } else {
+                e = Ci[p++];
+                pj = Cp[e];
+                ln = len[e];
+            }
+            for (int k2 = 1; k2 <= ln; k2++) {
+                int i = Ci[pj++];
+                int nvi = nv[i];
+                if (nvi <= 0) {
+                    continue;  /* 已消去或已在Lk中 */
+                }
+                dk += nvi;
+                nv[i] = -nvi;
+                Ci[pk2++] = i;
+                /* 从度链表中移除i */
+                if (next[i] != -1) {
+                    last[next[i]] = last[i];
+                }
+                if (last[i] != -1) {
+                    next[last[i]] = next[i];
+                } else {
+                    head[degree[i]] = next[i];
+                }
+            }
+            if (e != k) {
+                /* 元素e被吸收进k */
+                Cp[e] = AMD_FLIP(k);
+                w[e] = 0;
+            }
         }
-        
-        /* 将min_node添加到消除顺序 */
-        (*perm)[order] = min_node;
-        (*inv_perm)[min_node] = order;
-        eliminated[min_node] = 1;
-        order++;
-        
-        /* 更新邻居的度（模拟消除min_node后的fill-in） */
-        for (int j = matrix->row_ptr[min_node]; j < matrix->row_ptr[min_node + 1]; j++) {
-            int neighbor = matrix->col_idx[j];
-            if (!eliminated[neighbor]) {
-                /* 检查是否需要增加度（由于fill-in） */
-                /* 简化版本：假设消除min_node后，其所有邻居之间会形成边 */
-                /* 这里使用更简单的启发式：度减1（因为消除了与min_node的边） */
-                degree[neighbor]--;
-                if (degree[neighbor] < 0) degree[neighbor] = 0;
+        if (elenk != 0) {
+            cnz = pk2;
+        }
+        degree[k] = dk;
+        Cp[k] = pk1;
+        len[k] = pk2 - pk1;
+        elen[k] = -2;
+
+        /* 计算集合差 |Le \ Lk| */
+        mark = amd_clear_mark(mark, lemax, w, n);
+        for (int pk = pk1; pk < pk2; pk++) {
+            int i = Ci[pk];
+            int eln = elen[i];
+            if (eln <= 0) {
+                continue;
+            }
+            int nvi = -nv[i];
+            int wnvi = mark - nvi;
+            for (p = Cp[i]; p <= Cp[i] + eln - 1; p++) {
+                int e = Ci[p];
+                if (w[e] >= mark) {
+                    w[e] -= nvi;
+                } else if (w[e] != 0) {
+                    w[e] = degree[e] + wnvi;
+                }
+            }
+        }
+
+        /* 更新Lk中各变量的近似度 */
+        for (int pk = pk1; pk < pk2; pk++) {
+            int i = Ci[pk];
+            int p1 = Cp[i];
+            int p2 = p1 + elen[i] - 1;
+            int pn = p1;
+            unsigned int h = 0;
+            int d = 0;
+            for (p = p1; p <= p2; p++) {
+                int e = Ci[p];
+                if (w[e] != 0) {
+                    int dext = w[e] - mark;
+                    if (dext > 0) {
+                        d += dext;
+                        Ci[pn++] = e;
+                        h += (unsigned int)e;
+                    } else {
+                        /* 主动吸收：Le是Lk的子集 */
+                        Cp[e] = AMD_FLIP(k);
+                        w[e] = 0;
+                    }
+                }
+            }
+            elen[i] = pn - p1 + 1;
+            int p3 = pn;
+            int p4 = p1 + len[i];
+            for (p = p2 + 1; p < p4; p++) {
+                int j = Ci[p];
+                int nvj = nv[j];
+                if (nvj <= 0) {
+                    continue;  /* 原始边已被Lk覆盖或节点已消去 */
+                }
+                d += nvj;
+                Ci[pn++] = j;
+                h += (unsigned int)j;
+            }
+            if (d == 0) {
+                /* 质量消元：i的邻接完全包含在Lk中 */
+                Cp[i] = AMD_FLIP(k);
+                int nvi = -nv[i];
+                dk -= nvi;
+                nvk += nvi;
+                nel += nvi;
+                nv[i] = 0;
+                elen[i] = -1;
+            } else {
+                if (d < degree[i]) {
+                    degree[i] = d;
+                }
+                /* 把k放在i的元素列表首位 */
+                Ci[pn] = Ci[p3];
+                Ci[p3] = Ci[p1];
+                Ci[p1] = k;
+                len[i] = pn - p1 + 1;
+                h %= (unsigned int)n;
+                next[i] = hhead[h];
+                hhead[h] = i;
+                last[i] = (int)h;
+            }
+        }
+        degree[k] = dk;
+        if (dk > lemax) {
+            lemax = dk;
+        }
+        mark = amd_clear_mark(mark + lemax, lemax, w, n);
+
+        /* 超变量检测：哈希值相同的变量逐对比较邻接表 */
+        for (int pk = pk1; pk < pk2; pk++) {
+            int i = Ci[pk];
+            if (nv[i] >= 0) {
+                continue;
+            }
+            int h = last[i];
+            i = hhead[h];
+            hhead[h] = -1;
+            for (; i != -1 && next[i] != -1; i = next[i], mark++) {
+                int ln = len[i];
+                int eln = elen[i];
+                for (p = Cp[i] + 1; p <= Cp[i] + ln - 1; p++) {
+                    w[Ci[p]] = mark;
+                }
+                int jlast = i;
+                for (int j = next[i]; j != -1; ) {
+                    int ok = (len[j] == ln) && (elen[j] == eln);
+                    for (p = Cp[j] + 1; ok && p <= Cp[j] + ln - 1; p++) {
+                        if (w[Ci[p]] != mark) {
+                            ok = 0;
+                        }
+                    }
+                    if (ok) {
+                        /* j与i不可区分：并入i */
+                        Cp[j] = AMD_FLIP(i);
+                        nv[i] += nv[j];
+                        nv[j] = 0;
+                        elen[j] = -1;
+                        j = next[j];
+                        next[jlast] = j;
+                    } else {
+                        jlast = j;
+                        j = next[j];
+                    }
+                }
+            }
+        }
+
+        /* 完成新元素：剩余变量放回度链表 */
+        p = pk1;
+        for (int pk = pk1; pk < pk2; pk++) {
+            int i = Ci[pk];
+            int nvi = -nv[i];
+            if (nvi <= 0) {
+                continue;
+            }
+            nv[i] = nvi;
+            int d = degree[i] + dk - nvi;
+            if (d > n - nel - nvi) {
+                d = n - nel - nvi;
+            }
+            if (head[d] != -1) {
+                last[head[d]] = i;
+            }
+            next[i] = head[d];
+            last[i] = -1;
+            head[d] = i;
+            if (d < mindeg) {
+                mindeg = d;
             }
+            degree[i] = d;
+            Ci[p++] = i;
+        }
+        nv[k] = nvk;
+        len[k] = p - pk1;
+        if (len[k] == 0) {
+            /* k是组装树的根 */
+            Cp[k] = -1;
+            w[k] = 0;
+        }
+        if (elenk != 0) {
+            cnz = p;
         }
     }
-    
-    /* 处理剩余节点 */
+
+    /* 后序遍历组装树：被吸收的变量排在吸收它的元素之前 */
     for (int i = 0; i < n; i++) {
-        if (!eliminated[i]) {
-            (*perm)[order] = i;
-            (*inv_perm)[i] = order;
-            order++;
+        Cp[i] = AMD_FLIP(Cp[i]);
+    }
+    for (int j = 0; j <= n; j++) {
+        head[j] = -1;
+    }
+    for (int j = n; j >= 0; j--) {
+        if (nv[j] > 0) {
+            continue;
         }
+        next[j] = head[Cp[j]];
+        head[Cp[j]] = j;
     }
-    
-    free(eliminated);
-    free(degree);
-    
+    for (int e = n; e >= 0; e--) {
+        if (nv[e] <= 0) {
+            continue;
+        }
+        if (Cp[e] != -1) {
+            next[e] = head[Cp[e]];
+            head[Cp[e]] = e;
+        }
+    }
+    int *post = last;
+    for (int k = 0, i = 0; i <= n; i++) {
+        if (Cp[i] == -1) {
+            k = amd_tree_dfs(i, k, head, next, post, w);
+        }
+    }
+
+    /* post[n]为虚拟元素n，其余即为消元顺序 */
+    for (int k = 0; k < n; k++) {
+        (*perm)[k] = post[k];
+        (*inv_perm)[post[k]] = k;
+    }
+
+    free(Cp);
+    free(Ci);
+    free(work);
+
     return PARD_SUCCESS;
 }
 
@@ -100,11 +480,22 @@ int pard_minimum_degree(const pard_csr_matrix_t *matrix, int **perm, int **inv_p
  * 应用置换到矩阵
  */
 int apply_permutation(pard_csr_matrix_t *matrix, const int *perm, const int *inv_perm) {
+    return apply_permutation_map(matrix, perm, inv_perm, NULL);
+}
+
+/**
+ * 应用置换到矩阵，并跟踪元素位置：map非NULL时，map[q]为某个元素在置换前矩阵中的位置，
+ * 返回时改为它在置换后矩阵中的位置（长度为矩阵的非零元数）。
+ * 重复元素各自保留在不同位置，映射逐个对应
+ */
+int apply_permutation_map(pard_csr_matrix_t *matrix, const int *perm, const int *inv_perm,
+                          int *map) {
     if (matrix == NULL || perm == NULL || inv_perm == NULL) {
         return PARD_ERROR_INVALID_INPUT;
     }
     
     int n = matrix->n;
+    int nnz = matrix->nnz;
     
     /* 创建新的CSR矩阵 */
     pard_csr_matrix_t *new_matrix;
@@ -115,9 +506,15 @@ int apply_permutation(pard_csr_matrix_t *matrix, const int *perm, const int *inv
     
     new_matrix->is_symmetric = matrix->is_symmetric;
     
-    /* 计算新矩阵每行的非零元素数 */
+    /* 计算新矩阵每行的非零元素数；origin[新位置] = 旧位置 */
     int *row_counts = (int *)calloc(n, sizeof(int));
-    if (row_counts == NULL) {
+    int *origin = NULL;
+    if (map != NULL) {
+        origin = (int *)malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+    }
+    if (row_counts == NULL || (map != NULL && origin == NULL)) {
+        free(row_counts);
+        free(origin);
         pard_csr_free(&new_matrix);
         return PARD_ERROR_MEMORY;
     }
@@ -146,6 +543,9 @@ int apply_permutation(pard_csr_matrix_t *matrix, const int *perm, const int *inv
             int pos = new_matrix->row_ptr[i] + row_counts[i];
             new_matrix->col_idx[pos] = new_col;
             new_matrix->values[pos] = val;
+            if (origin != NULL) {
+                origin[pos] = j;
+            }
             row_counts[i]++;
         }
         
@@ -161,11 +561,34 @@ int apply_permutation(pard_csr_matrix_t *matrix, const int *perm, const int *inv
                     new_matrix->values[j] = new_matrix->values[k];
                     new_matrix->col_idx[k] = tmp_idx;
                     new_matrix->values[k] = tmp_val;
+                    if (origin != NULL) {
+                        int tmp_org = origin[j];
+                        origin[j] = origin[k];
+                        origin[k] = tmp_org;
+                    }
                 }
             }
         }
     }
     
+    /* 旧位置 -> 新位置：对origin求逆后复合到map */
+    if (origin != NULL) {
+        int *dest = (int *)malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+        if (dest == NULL) {
+            free(row_counts);
+            free(origin);
+            pard_csr_free(&new_matrix);
+            return PARD_ERROR_MEMORY;
+        }
+        for (int pos = 0; pos < nnz; pos++) {
+            dest[origin[pos]] = pos;
+        }
+        for (int q = 0; q < nnz; q++) {
+            map[q] = dest[map[q]];
+        }
+        free(dest);
+        free(origin);
+    }
     free(row_counts);
     
     /* 保存新矩阵的指针（在释放旧指针之前） */
@@ -174,16 +597,8 @@ int apply_permutation(pard_csr_matrix_t *matrix, const int *perm, const int *inv
     double *new_values = new_matrix->values;
     int new_nnz = new_matrix->nnz;
     
-    /* 替换原矩阵：安全释放旧指针 */
-    if (matrix->row_ptr != NULL) {
-        free(matrix->row_ptr);
-    }
-    if (matrix->col_idx != NULL) {
-        free(matrix->col_idx);
-    }
-    if (matrix->values != NULL) {
-        free(matrix->values);
-    }
+    /* 替换原矩阵：释放旧数组（映射读入的矩阵解除映射） */
+    pard_csr_release_storage(matrix);
     
     /* 复制新矩阵的指针和数据 */
     matrix->row_ptr = new_row_ptr;
@@ -1,12 +1,24 @@
+#define _XOPEN_SOURCE 700
 #include "pard.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include <mpi.h>
 
+/* 超节点松弛合并的默认参数 */
+#define PARD_DEFAULT_RELAX_MAX_COLS 32
+#define PARD_DEFAULT_RELAX_MAX_ZEROS 0.1
+
+/* 自动选择线程数时的上限 */
+#define PARD_MAX_AUTO_THREADS 64
+
 /* 前向声明 */
 extern int pard_minimum_degree(const pard_csr_matrix_t *matrix, int **perm, int **inv_perm);
 extern int pard_nested_dissection(const pard_csr_matrix_t *matrix, int **perm, int **inv_perm);
+extern int pard_compute_ordering(const pard_csr_matrix_t *matrix, pard_ordering_t method,
+                                 const int *user_perm, int **perm, int **inv_perm,
+                                 pard_ordering_t *used);
 extern int pard_build_elimination_tree(const pard_csr_matrix_t *matrix,
                                        int **parent, int **first_child, int **next_sibling);
 extern int pard_symbolic_factorization(const pard_csr_matrix_t *matrix,
@@ -16,10 +28,68 @@ extern int pard_lu_factorization(pard_solver_t *solver);
 extern int pard_ldlt_factorization(pard_solver_t *solver);
 extern int pard_cholesky_factorization(pard_solver_t *solver);
 extern int pard_solve_system(pard_solver_t *solver, int nrhs, const double *rhs, double *sol);
+extern int pard_solve_transpose_system(pard_solver_t *solver, int nrhs, const double *rhs,
+                                       double *sol);
+extern int pard_mixed_precision_solve(pard_solver_t *solver, int nrhs, const double *rhs,
+                                      double *sol, int transpose, int *stagnated);
+extern int pard_solve_sparse_system(pard_solver_t *solver, int rhs_nnz, const int *rhs_idx,
+                                    const double *rhs_val, int nout, const int *out_idx,
+                                    double *out_val);
 extern int pard_iterative_refinement(pard_solver_t *solver, int nrhs,
                                       const double *rhs, double *sol,
                                       int max_iter, double tol);
 extern int apply_permutation(pard_csr_matrix_t *matrix, const int *perm, const int *inv_perm);
+extern int apply_permutation_map(pard_csr_matrix_t *matrix, const int *perm, const int *inv_perm,
+                                 int *map);
+extern int pard_etree_postorder(int n, const int *parent, int **post);
+extern int pard_supernode_partition(pard_factors_t *factors, const int *parent,
+                                    int relax_max_cols, double relax_max_zeros);
+extern int pard_symbolic_estimate(pard_solver_t *solver);
+extern void pard_free_panels(pard_factors_t *factors);
+extern void pard_free_csr_values(pard_factors_t *factors);
+extern size_t pard_solve_work_size(const pard_factors_t *factors, int nrhs);
+extern size_t pard_refinement_work_size(const pard_solver_t *solver, int nrhs);
+extern size_t pard_solve_sparse_iwork_size(const pard_factors_t *factors);
+extern int pard_state_write(const pard_solver_t *solver, const char *filename);
+extern int pard_state_read(pard_solver_t *solver, const char *filename, int mode);
+extern void pard_factors_unmap(pard_factors_t *factors);
+extern int pard_factors_detach(pard_factors_t *factors);
+
+/**
+ * 单调时钟的墙钟时间（秒）。分解与求解都是多线程的，clock()给出的进程CPU时间会随线程数增长
+ */
+static double pard_wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+/**
+ * 按work_max_nrhs准备求解与迭代精化的工作区，已有的工作区够用时保留。
+ * 工作区只是避免逐次分配的缓存：分配失败时置空，求解时会改为临时分配
+ */
+static void pard_setup_workspace(pard_solver_t *solver) {
+    int nrhs = (solver->work_max_nrhs > 0) ? solver->work_max_nrhs : 1;
+    size_t solve_size = pard_solve_work_size(solver->factors, nrhs);
+    size_t refine_size = pard_refinement_work_size(solver, nrhs);
+    size_t iwork_size = pard_solve_sparse_iwork_size(solver->factors);
+    
+    if (solve_size > solver->solve_work_size) {
+        free(solver->solve_work);
+        solver->solve_work = (double *)malloc(solve_size * sizeof(double));
+        solver->solve_work_size = (solver->solve_work != NULL) ? solve_size : 0;
+    }
+    if (refine_size > solver->refine_work_size) {
+        free(solver->refine_work);
+        solver->refine_work = (double *)malloc(refine_size * sizeof(double));
+        solver->refine_work_size = (solver->refine_work != NULL) ? refine_size : 0;
+    }
+    if (iwork_size > solver->solve_iwork_size) {
+        free(solver->solve_iwork);
+        solver->solve_iwork = (int *)calloc(iwork_size, sizeof(int));
+        solver->solve_iwork_size = (solver->solve_iwork != NULL) ? iwork_size : 0;
+    }
+}
 
 /**
  * 初始化求解器
@@ -35,6 +105,8 @@ int pardiso_init(pard_solver_t **solver, pard_matrix_type_t mtype, MPI_Comm comm
     }
     
     (*solver)->matrix_type = mtype;
+    (*solver)->relax_max_cols = PARD_DEFAULT_RELAX_MAX_COLS;
+    (*solver)->relax_max_zeros = PARD_DEFAULT_RELAX_MAX_ZEROS;
     (*solver)->comm = comm;
     (*solver)->is_parallel = (comm != MPI_COMM_NULL);
     
@@ -50,21 +122,289 @@ int pardiso_init(pard_solver_t **solver, pard_matrix_type_t mtype, MPI_Comm comm
 }
 
 /**
- * 符号分解
+ * 设置重排序方法（在pardiso_symbolic之前调用）
+ * PARD_ORDERING_USER时user_perm为长度n的置换（user_perm[new] = old），会被复制保存，
+ * 符号分解时校验其合法性；其他方法忽略n和user_perm
  */
-int pardiso_symbolic(pard_solver_t *solver, pard_csr_matrix_t *matrix) {
-    if (solver == NULL || matrix == NULL) {
+int pardiso_set_ordering(pard_solver_t *solver, pard_ordering_t ordering,
+                         int n, const int *user_perm) {
+    if (solver == NULL || ordering < PARD_ORDERING_AMD || ordering > PARD_ORDERING_AUTO) {
         return PARD_ERROR_INVALID_INPUT;
     }
+    if (ordering == PARD_ORDERING_USER && (user_perm == NULL || n <= 0)) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    
+    if (solver->user_perm != NULL) {
+        free(solver->user_perm);
+        solver->user_perm = NULL;
+    }
+    solver->user_perm_n = 0;
+    
+    if (ordering == PARD_ORDERING_USER) {
+        solver->user_perm = (int *)malloc(n * sizeof(int));
+        if (solver->user_perm == NULL) {
+            return PARD_ERROR_MEMORY;
+        }
+        memcpy(solver->user_perm, user_perm, n * sizeof(int));
+        solver->user_perm_n = n;
+    }
+    
+    solver->ordering = ordering;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 释放分解因子结构及其全部数组（也用于pardiso_load失败时回滚）
+ */
+void pard_free_factors(pard_factors_t *factors) {
+    if (factors == NULL) {
+        return;
+    }
+    pard_factors_unmap(factors);
+    free(factors->row_ptr);
+    free(factors->col_idx);
+    free(factors->l_values);
+    free(factors->u_row_ptr);
+    free(factors->u_col_idx);
+    free(factors->u_values);
+    free(factors->d_values);
+    free(factors->d_offdiag);
+    free(factors->pivot_type);
+    free(factors->perm);
+    free(factors->col_perm);
+    free(factors->super_ptr);
+    free(factors->super_parent);
+    free(factors->super_row_ptr);
+    free(factors->super_row_idx);
+    pard_free_panels(factors);
+    free(factors);
+}
+
+/**
+ * 符号分解失败时释放已保存的置换与数值映射，并解除对调用者矩阵的引用
+ * （pardiso_load读入、由求解器持有的矩阵保留，由pardiso_cleanup释放）
+ */
+static void pard_symbolic_reset(pard_solver_t *solver) {
+    if (!solver->owns_matrix) {
+        solver->matrix = NULL;
+    }
+    free(solver->perm);
+    free(solver->inv_perm);
+    free(solver->value_map);
+    solver->perm = NULL;
+    solver->inv_perm = NULL;
+    solver->value_map = NULL;
+    solver->value_map_nnz = 0;
+}
+
+/**
+ * 在已置换的矩阵上再施加消元树后序post（post[new] = 当前编号），并合成到solver->perm，
+ * 同时更新数值映射
+ */
+static int pard_compose_postorder(pard_solver_t *solver, const int *post) {
+    int n = solver->matrix->n;
+    int *inv_post = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *composed = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (inv_post == NULL || composed == NULL) {
+        free(inv_post);
+        free(composed);
+        return PARD_ERROR_MEMORY;
+    }
+    for (int k = 0; k < n; k++) {
+        inv_post[post[k]] = k;
+    }
+    
+    int err = apply_permutation_map(solver->matrix, post, inv_post, solver->value_map);
+    if (err == PARD_SUCCESS) {
+        for (int k = 0; k < n; k++) {
+            composed[k] = solver->perm[post[k]];
+        }
+        memcpy(solver->perm, composed, n * sizeof(int));
+        for (int k = 0; k < n; k++) {
+            solver->inv_perm[solver->perm[k]] = k;
+        }
+    }
     
-    clock_t start = clock();
+    free(inv_post);
+    free(composed);
+    return err;
+}
+
+/**
+ * 设置超节点松弛合并参数（在pardiso_symbolic之前调用）
+ * max_cols为合并后超节点的最大列数（<= 1 表示只使用基本超节点），
+ * max_zeros为合并引入的显式零元占超节点存储的最大比例
+ */
+int pardiso_set_supernode_relaxation(pard_solver_t *solver, int max_cols, double max_zeros) {
+    if (solver == NULL || max_zeros < 0.0 || max_zeros >= 1.0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    solver->relax_max_cols = max_cols;
+    solver->relax_max_zeros = max_zeros;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 设置数值分解使用的线程数，num_threads <= 0 表示自动选择
+ */
+int pardiso_set_num_threads(pard_solver_t *solver, int num_threads) {
+    if (solver == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    solver->num_threads = (num_threads > 0) ? num_threads : 0;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 混合精度模式（在pardiso_factor之前调用）：enable非零时因子舍入为单精度保存，
+ * 因子内存约减半，求解时在双精度下迭代精化到双精度精度。波前仍以双精度计算、完成后才舍入，
+ * 分解的运算量与时间不变；
+ * 若精化停滞（矩阵对单精度因子过于病态），自动以双精度重新分解并关闭该模式。仅支持单进程
+ */
+int pardiso_set_mixed_precision(pard_solver_t *solver, int enable) {
+    if (solver == NULL || (enable && solver->is_parallel)) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    solver->mixed_precision = (enable != 0);
+    return PARD_SUCCESS;
+}
+
+/**
+ * CSR因子导出（在pardiso_factor之前调用）：enable非零时数值分解后把超节点面板另外导出为
+ * factors中的CSR因子L、U（P*A*Q = L*U，行列按主元顺序编号，取代符号分解的结构数组），
+ * 供调用者直接使用因子。导出的数组是面板之外的一份副本，因子内存约增加一倍；求解仍使用面板。
+ * 混合精度的单精度面板按双精度导出，外存面板按顺序读回导出
+ */
+int pardiso_set_csr_factors(pard_solver_t *solver, int enable) {
+    if (solver == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    solver->csr_factors = (enable != 0);
+    return PARD_SUCCESS;
+}
+
+/**
+ * 外存因子（在pardiso_factor之前调用）：scratch_dir非NULL时数值分解把完成的面板
+ * 交给后台线程写入该目录下的临时文件（创建后即删除），求解时由预取线程按前代、回代的
+ * 遍历顺序读回。memory_limit为同时驻留内存的面板数值字节数上限（单个面板更大时一次只留一个），
+ * 波前与贡献块不在此列。外存模式下求解顺序进行，不使用混合精度，因子不能用pardiso_save保存。
+ * scratch_dir为NULL时关闭。仅支持单进程
+ */
+int pardiso_set_out_of_core(pard_solver_t *solver, const char *scratch_dir, size_t memory_limit) {
+    if (solver == NULL || (scratch_dir != NULL && solver->is_parallel)) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    char *dir = NULL;
+    if (scratch_dir != NULL) {
+        size_t len = strlen(scratch_dir);
+        dir = (char *)malloc(len + 1);
+        if (dir == NULL) {
+            return PARD_ERROR_MEMORY;
+        }
+        memcpy(dir, scratch_dir, len + 1);
+    }
+    free(solver->ooc_dir);
+    solver->ooc_dir = dir;
+    solver->ooc_memory_limit = memory_limit;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 选择pardiso_refine的精化方法；restart为FGMRES的重启长度，<= 0 表示默认值
+ */
+int pardiso_set_refinement(pard_solver_t *solver, pard_refinement_t method, int restart) {
+    if (solver == NULL || (method != PARD_REFINE_RICHARDSON && method != PARD_REFINE_FGMRES &&
+                           method != PARD_REFINE_PCG)) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    solver->refine_method = method;
+    solver->refine_restart = (restart > 0) ? restart : 0;
+    if (solver->factors != NULL && solver->matrix != NULL) {
+        pard_setup_workspace(solver);
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 设置求解工作区容纳的最大右端项数（默认1）。工作区在数值分解后分配，
+ * 之后nrhs不超过max_nrhs的求解与迭代精化不再分配内存；更多的右端项仍可求解，只是临时分配
+ */
+int pardiso_set_max_nrhs(pard_solver_t *solver, int max_nrhs) {
+    if (solver == NULL || max_nrhs <= 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    solver->work_max_nrhs = max_nrhs;
+    if (solver->factors != NULL && solver->matrix != NULL) {
+        pard_setup_workspace(solver);
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 查询nrhs个右端项的求解与迭代精化所需的工作区大小（字节），需在数值分解之后调用
+ */
+int pardiso_get_workspace_size(const pard_solver_t *solver, int nrhs, size_t *bytes) {
+    if (solver == NULL || solver->factors == NULL || solver->matrix == NULL || nrhs <= 0 ||
+        bytes == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    *bytes = (pard_solve_work_size(solver->factors, nrhs) +
+              pard_refinement_work_size(solver, nrhs)) * sizeof(double) +
+             pard_solve_sparse_iwork_size(solver->factors) * sizeof(int);
+    return PARD_SUCCESS;
+}
+
+/**
+ * 实际使用的线程数：显式设置的值优先，其次是环境变量PARD_NUM_THREADS，
+ * 最后为在线处理器数（不超过PARD_MAX_AUTO_THREADS）
+ */
+int pard_get_num_threads(const pard_solver_t *solver) {
+    if (solver != NULL && solver->num_threads > 0) {
+        return solver->num_threads;
+    }
+    const char *env = getenv("PARD_NUM_THREADS");
+    if (env != NULL && atoi(env) > 0) {
+        return atoi(env);
+    }
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) {
+        return 1;
+    }
+    return (ncpu > PARD_MAX_AUTO_THREADS) ? PARD_MAX_AUTO_THREADS : (int)ncpu;
+}
+
+/**
+ * 符号分析：重排序、消元树、符号分解与超节点划分
+ * 同时建立数值映射：原始矩阵第p个元素在重排后矩阵中的位置。映射随每次置换逐个元素跟踪，
+ * 重复元素对应各自的位置，因此pardiso_refactor与重新分析同一矩阵得到相同的重排后数值
+ */
+static int pard_symbolic_analysis(pard_solver_t *solver, pard_csr_matrix_t *matrix) {
+    double start = pard_wall_time();
     
     solver->matrix = matrix;
     
-    /* 重排序：使用最小度算法 */
+    int nnz = matrix->nnz;
+    solver->value_map = (int *)malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+    if (solver->value_map == NULL) {
+        pard_symbolic_reset(solver);
+        return PARD_ERROR_MEMORY;
+    }
+    solver->value_map_nnz = nnz;
+    for (int p = 0; p < nnz; p++) {
+        solver->value_map[p] = p;
+    }
+    
+    /* 重排序：按solver->ordering选择方法（默认AMD） */
+    if (solver->ordering == PARD_ORDERING_USER && solver->user_perm_n != matrix->n) {
+        pard_symbolic_reset(solver);
+        return PARD_ERROR_INVALID_INPUT;
+    }
     int *perm = NULL, *inv_perm = NULL;
-    int err = pard_minimum_degree(matrix, &perm, &inv_perm);
+    int err = pard_compute_ordering(matrix, solver->ordering, solver->user_perm,
+                                    &perm, &inv_perm, &solver->ordering_used);
     if (err != PARD_SUCCESS) {
+        pard_symbolic_reset(solver);
         return err;
     }
     
@@ -72,10 +412,9 @@ int pardiso_symbolic(pard_solver_t *solver, pard_csr_matrix_t *matrix) {
     solver->inv_perm = inv_perm;
     
     /* 应用置换 */
-    err = apply_permutation(matrix, perm, inv_perm);
+    err = apply_permutation_map(matrix, perm, inv_perm, solver->value_map);
     if (err != PARD_SUCCESS) {
-        free(perm);
-        free(inv_perm);
+        pard_symbolic_reset(solver);
         return err;
     }
     
@@ -83,48 +422,114 @@ int pardiso_symbolic(pard_solver_t *solver, pard_csr_matrix_t *matrix) {
     int *parent = NULL, *first_child = NULL, *next_sibling = NULL;
     err = pard_build_elimination_tree(matrix, &parent, &first_child, &next_sibling);
     if (err != PARD_SUCCESS) {
-        free(perm);
-        free(inv_perm);
+        pard_symbolic_reset(solver);
         return err;
     }
     
-    /* 符号分解 */
-    pard_factors_t *factors = NULL;
-    err = pard_symbolic_factorization(matrix, parent, first_child, next_sibling, &factors);
+    /* 按消元树后序重新编号（等价排序，填充不变），使超节点的列连续、子超节点与父超节点相邻 */
+    int *post = NULL;
+    err = pard_etree_postorder(matrix->n, parent, &post);
+    if (err == PARD_SUCCESS) {
+        int is_identity = 1;
+        for (int k = 0; k < matrix->n && is_identity; k++) {
+            is_identity = (post[k] == k);
+        }
+        if (!is_identity) {
+            err = pard_compose_postorder(solver, post);
+            free(parent);
+            free(first_child);
+            free(next_sibling);
+            parent = first_child = next_sibling = NULL;
+            if (err == PARD_SUCCESS) {
+                err = pard_build_elimination_tree(matrix, &parent, &first_child, &next_sibling);
+            }
+        }
+        free(post);
+    }
     if (err != PARD_SUCCESS) {
-        free(perm);
-        free(inv_perm);
         free(parent);
         free(first_child);
         free(next_sibling);
+        pard_symbolic_reset(solver);
         return err;
     }
     
-    solver->factors = factors;
-    solver->factors->matrix_type = solver->matrix_type;  /* 设置正确的矩阵类型 */
-    solver->fill_in_nnz = factors->nnz;
-    
+    /* 符号分解 */
+    pard_factors_t *factors = NULL;
+    err = pard_symbolic_factorization(matrix, parent, first_child, next_sibling, &factors);
+    if (err == PARD_SUCCESS) {
+        /* 超节点划分 */
+        err = pard_supernode_partition(factors, parent, solver->relax_max_cols,
+                                       solver->relax_max_zeros);
+        if (err != PARD_SUCCESS) {
+            pard_free_factors(factors);
+        }
+    }
     free(parent);
     free(first_child);
     free(next_sibling);
+    if (err != PARD_SUCCESS) {
+        pard_symbolic_reset(solver);
+        return err;
+    }
+    
+    solver->factors = factors;
+    solver->factors->matrix_type = solver->matrix_type;  /* 设置正确的矩阵类型 */
+    err = pard_symbolic_estimate(solver);
+    if (err != PARD_SUCCESS) {
+        pard_free_factors(factors);
+        solver->factors = NULL;
+        pard_symbolic_reset(solver);
+        return err;
+    }
     
-    clock_t end = clock();
-    solver->analysis_time = ((double)(end - start)) / CLOCKS_PER_SEC;
+    solver->analysis_time = pard_wall_time() - start;
     
     return PARD_SUCCESS;
 }
 
 /**
- * 数值分解
+ * 符号分解
+ * 重排序、消元树和符号分解只依赖非零模式；同时记录原始元素到重排后位置的映射，
+ * 之后模式不变、数值改变时可用pardiso_refactor直接重分解
+ */
+int pardiso_symbolic(pard_solver_t *solver, pard_csr_matrix_t *matrix) {
+    if (solver == NULL || matrix == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    
+    /* 释放上一次的分析结果（包括pardiso_load读入的矩阵，除非重新分析的正是它） */
+    pard_free_factors(solver->factors);
+    solver->factors = NULL;
+    pard_symbolic_reset(solver);
+    if (solver->owns_matrix && solver->matrix != matrix) {
+        pard_csr_free(&solver->matrix);
+        solver->owns_matrix = 0;
+    }
+    
+    return pard_symbolic_analysis(solver, matrix);
+}
+
+/**
+ * 数值分解（失败时上一次的因子已被丢弃，需重新分解成功后才能求解）
  */
 int pardiso_factor(pard_solver_t *solver) {
     if (solver == NULL || solver->matrix == NULL || solver->factors == NULL) {
         return PARD_ERROR_INVALID_INPUT;
     }
     
-    clock_t start = clock();
+    double start = pard_wall_time();
     
-    int err;
+    /* pardiso_load映射读入的因子：保留超节点结构，其余由本次分解重新生成 */
+    int err = pard_factors_detach(solver->factors);
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+    
+    /* 先丢弃上一次的面板：本次分解失败时求解将拒绝执行，而不是使用与当前数值不符的旧因子 */
+    pard_free_panels(solver->factors);
+    pard_free_csr_values(solver->factors);
+    solver->factors->single_precision = 0;
     
     if (solver->is_parallel) {
         err = pard_mpi_factorization(solver);
@@ -138,12 +543,41 @@ int pardiso_factor(pard_solver_t *solver) {
         }
     }
     
-    clock_t end = clock();
-    solver->factorization_time = ((double)(end - start)) / CLOCKS_PER_SEC;
+    if (err == PARD_SUCCESS) {
+        pard_setup_workspace(solver);
+    }
+    
+    solver->factorization_time = pard_wall_time() - start;
     
     return err;
 }
 
+/**
+ * 单进程求解（transpose非零时求解A^T*x = b）
+ * 单精度因子先做混合精度迭代精化；精化停滞时关闭混合精度，以双精度重新分解后再求解
+ */
+static int pard_serial_solve(pard_solver_t *solver, int nrhs, const double *rhs, double *sol,
+                             int transpose) {
+    if (!solver->factors->single_precision) {
+        return transpose ? pard_solve_transpose_system(solver, nrhs, rhs, sol)
+                         : pard_solve_system(solver, nrhs, rhs, sol);
+    }
+    
+    int stagnated = 0;
+    int err = pard_mixed_precision_solve(solver, nrhs, rhs, sol, transpose, &stagnated);
+    if (err != PARD_SUCCESS || !stagnated) {
+        return err;
+    }
+    
+    solver->mixed_precision = 0;
+    err = pardiso_factor(solver);
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+    return transpose ? pard_solve_transpose_system(solver, nrhs, rhs, sol)
+                     : pard_solve_system(solver, nrhs, rhs, sol);
+}
+
 /**
  * 求解
  */
@@ -152,7 +586,7 @@ int pardiso_solve(pard_solver_t *solver, int nrhs, double *rhs, double *sol) {
         return PARD_ERROR_INVALID_INPUT;
     }
     
-    clock_t start = clock();
+    double start = pard_wall_time();
     
     int err;
     
@@ -189,17 +623,120 @@ int pardiso_solve(pard_solver_t *solver, int nrhs, double *rhs, double *sol) {
             local_sol = NULL;
         }
     } else {
-        err = pard_solve_system(solver, nrhs, rhs, sol);
+        err = pard_serial_solve(solver, nrhs, rhs, sol, 0);
+    }
+    
+    solver->solve_time = pard_wall_time() - start;
+    
+    return err;
+}
+
+/**
+ * 转置求解：A^T*x = b，复用pardiso_factor得到的因子（用于伴随方程等场合），
+ * 不需要对A^T重新做符号分析和数值分解。对称矩阵等价于pardiso_solve；仅支持单进程
+ */
+int pardiso_solve_transpose(pard_solver_t *solver, int nrhs, double *rhs, double *sol) {
+    if (solver == NULL || solver->factors == NULL || rhs == NULL || sol == NULL ||
+        solver->is_parallel) {
+        return PARD_ERROR_INVALID_INPUT;
     }
     
-    clock_t end = clock();
-    solver->solve_time = ((double)(end - start)) / CLOCKS_PER_SEC;
+    double start = pard_wall_time();
+    int err = pard_serial_solve(solver, nrhs, rhs, sol, 1);
+    solver->solve_time = pard_wall_time() - start;
     
     return err;
 }
 
 /**
- * 迭代精化
+ * 稀疏右端项、部分解求解：A*x = b
+ * b只在rhs_idx[0..rhs_nnz)处非零（值为rhs_val，重复下标累加），
+ * 结果out_val[t] = x[out_idx[t]]；out_idx为NULL时out_val为长度n的完整解。
+ * 前代只访问从b的非零行在消元树上可达的因子列，回代只访问所需分量依赖的部分，
+ * 适合少量非零元的右端项和只需要少数解分量的场合（如Schur补的列、灵敏度分析）。
+ * 下标与pardiso_solve相同，为重排后矩阵的编号；仅支持单进程。
+ * 单精度因子（混合精度模式）需要完整的残差做迭代精化，因此展开为稠密右端项求解
+ */
+int pardiso_solve_sparse(pard_solver_t *solver, int rhs_nnz, const int *rhs_idx,
+                         const double *rhs_val, int nout, const int *out_idx,
+                         double *out_val) {
+    if (solver == NULL || solver->factors == NULL || solver->is_parallel) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    
+    if (solver->factors->single_precision) {
+        int n = solver->factors->n;
+        if (rhs_nnz < 0 || (rhs_nnz > 0 && (rhs_idx == NULL || rhs_val == NULL)) ||
+            out_val == NULL || (out_idx != NULL && nout < 0)) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+        for (int a = 0; a < rhs_nnz; a++) {
+            if (rhs_idx[a] < 0 || rhs_idx[a] >= n) {
+                return PARD_ERROR_INVALID_INPUT;
+            }
+        }
+        for (int a = 0; out_idx != NULL && a < nout; a++) {
+            if (out_idx[a] < 0 || out_idx[a] >= n) {
+                return PARD_ERROR_INVALID_INPUT;
+            }
+        }
+        double *b = (double *)calloc(n > 0 ? n : 1, sizeof(double));
+        double *x = (double *)malloc((n > 0 ? n : 1) * sizeof(double));
+        if (b == NULL || x == NULL) {
+            free(b);
+            free(x);
+            return PARD_ERROR_MEMORY;
+        }
+        for (int a = 0; a < rhs_nnz; a++) {
+            b[rhs_idx[a]] += rhs_val[a];
+        }
+        int err = pardiso_solve(solver, 1, b, x);
+        if (err == PARD_SUCCESS) {
+            if (out_idx != NULL) {
+                for (int a = 0; a < nout; a++) {
+                    out_val[a] = x[out_idx[a]];
+                }
+            } else {
+                memcpy(out_val, x, n * sizeof(double));
+            }
+        }
+        free(b);
+        free(x);
+        return err;
+    }
+    
+    double start = pard_wall_time();
+    int err = pard_solve_sparse_system(solver, rhs_nnz, rhs_idx, rhs_val,
+                                       nout, out_idx, out_val);
+    solver->solve_time = pard_wall_time() - start;
+    
+    return err;
+}
+
+/**
+ * 数值重分解：非零模式与上次pardiso_symbolic相同，只有数值改变。
+ * values按调用pardiso_symbolic时矩阵的原始元素顺序给出，经数值映射写入重排后的矩阵，
+ * 随后直接进行数值分解，不重复重排序、消元树和符号分解
+ */
+int pardiso_refactor(pard_solver_t *solver, const double *values) {
+    if (solver == NULL || solver->matrix == NULL || solver->factors == NULL ||
+        solver->value_map == NULL || values == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    
+    double *dst = solver->matrix->values;
+    const int *map = solver->value_map;
+    for (int p = 0; p < solver->value_map_nnz; p++) {
+        dst[map[p]] = values[p];
+    }
+    
+    return pardiso_factor(solver);
+}
+
+/**
+ * 迭代精化：max_iter为每个右端项最多的求解次数，tol为残差2范数的收敛阈值。
+ * 方法由pardiso_set_refinement选择；结束后迭代次数与后向误差记录在
+ * solver->refine_iterations、solver->refine_berr
  */
 int pardiso_refine(pard_solver_t *solver, int nrhs, double *rhs, double *sol,
                    int max_iter, double tol) {
@@ -210,6 +747,46 @@ int pardiso_refine(pard_solver_t *solver, int nrhs, double *rhs, double *sol,
     return pard_iterative_refinement(solver, nrhs, rhs, sol, max_iter, tol);
 }
 
+/**
+ * 保存求解器状态：置换、数值映射、重排后的矩阵、符号结构与分解因子（含面板），
+ * 写成带段表的二进制文件，各数组按64字节对齐并附校验和。
+ * 只做过符号分析时只保存分析结果，读入后仍需pardiso_factor。
+ * MPI并行时各进程持有相同的因子，由调用者选择一个进程保存；外存因子不能保存
+ */
+int pardiso_save(const pard_solver_t *solver, const char *filename) {
+    if (solver == NULL || filename == NULL ||
+        (solver->factors != NULL && solver->factors->ooc != NULL)) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    return pard_state_write(solver, filename);
+}
+
+/**
+ * 从pardiso_save写出的文件恢复求解器，跳过符号分析与数值分解，随后可直接求解、精化或重分解。
+ * mode为pard_bin_mode_t的组合：PARD_BIN_MMAP时因子数组（CSR因子、超节点结构、面板）
+ * 直接指向文件映射，按需换入，不复制；矩阵与置换总是复制。PARD_BIN_VERIFY校验文件的校验和。
+ * 求解器持有读入的矩阵（solver->matrix），pardiso_cleanup时一并释放；线程数等运行时设置不保存
+ */
+int pardiso_load(pard_solver_t **solver, const char *filename, MPI_Comm comm, int mode) {
+    if (solver == NULL || filename == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    
+    int err = pardiso_init(solver, PARD_MATRIX_TYPE_REAL_NONSYMMETRIC, comm);
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+    err = pard_state_read(*solver, filename, mode);
+    if (err != PARD_SUCCESS) {
+        pardiso_cleanup(solver);
+        return err;
+    }
+    if ((*solver)->factors->panels != NULL) {
+        pard_setup_workspace(*solver);
+    }
+    return PARD_SUCCESS;
+}
+
 /**
  * 清理资源
  */
@@ -224,6 +801,9 @@ int pardiso_cleanup(pard_solver_t **solver) {
     /* apply_permutation会修改matrix的内部结构，但matrix本身由调用者管理 */
     /* 如果需要在cleanup中释放，调用者应该在cleanup之后手动释放 */
     /* 这里我们不释放matrix，只清理solver自己的资源 */
+    if (s->owns_matrix) {
+        pard_csr_free(&s->matrix);
+    }
     s->matrix = NULL;
     
     if (s->perm != NULL) {
@@ -236,47 +816,27 @@ int pardiso_cleanup(pard_solver_t **solver) {
         s->inv_perm = NULL;
     }
     
-    if (s->factors != NULL) {
-        if (s->factors->row_ptr != NULL) {
-            free(s->factors->row_ptr);
-            s->factors->row_ptr = NULL;
-        }
-        if (s->factors->col_idx != NULL) {
-            free(s->factors->col_idx);
-            s->factors->col_idx = NULL;
-        }
-        if (s->factors->l_values != NULL) {
-            free(s->factors->l_values);
-            s->factors->l_values = NULL;
-        }
-        if (s->factors->u_row_ptr != NULL) {
-            free(s->factors->u_row_ptr);
-            s->factors->u_row_ptr = NULL;
-        }
-        if (s->factors->u_col_idx != NULL) {
-            free(s->factors->u_col_idx);
-            s->factors->u_col_idx = NULL;
-        }
-        if (s->factors->u_values != NULL) {
-            free(s->factors->u_values);
-            s->factors->u_values = NULL;
-        }
-        if (s->factors->d_values != NULL) {
-            free(s->factors->d_values);
-            s->factors->d_values = NULL;
-        }
-        if (s->factors->pivot_type != NULL) {
-            free(s->factors->pivot_type);
-            s->factors->pivot_type = NULL;
-        }
-        if (s->factors->perm != NULL) {
-            free(s->factors->perm);
-            s->factors->perm = NULL;
-        }
-        free(s->factors);
-        s->factors = NULL;
+    if (s->user_perm != NULL) {
+        free(s->user_perm);
+        s->user_perm = NULL;
     }
     
+    free(s->value_map);
+    s->value_map = NULL;
+    
+    free(s->ooc_dir);
+    s->ooc_dir = NULL;
+    
+    free(s->solve_work);
+    free(s->refine_work);
+    free(s->solve_iwork);
+    s->solve_work = NULL;
+    s->refine_work = NULL;
+    s->solve_iwork = NULL;
+    
+    pard_free_factors(s->factors);
+    s->factors = NULL;
+    
     free(s);
     *solver = NULL;
     
@@ -3,58 +3,121 @@
 #include <string.h>
 #include <math.h>
 
+/* 混合精度求解的最大精化步数 */
+#define PARD_MIXED_MAX_ITER 10
+/* 混合精度求解的目标：范数后向误差 |b - A*x| / (|A|*|x| + |b|)（无穷范数） */
+#define PARD_MIXED_BERR_TOL 1e-14
+/* 一步精化后后向误差至少降为原来的该比例，否则视为停滞 */
+#define PARD_MIXED_MIN_REDUCTION 0.5
+/* FGMRES的默认重启长度 */
+#define PARD_DEFAULT_GMRES_RESTART 20
+
+/* 前向声明 */
+extern int pard_solve_system(pard_solver_t *solver, int nrhs, const double *rhs, double *sol);
+extern int pard_solve_transpose_system(pard_solver_t *solver, int nrhs, const double *rhs,
+                                       double *sol);
+extern double *pard_workspace_acquire(double *work, size_t work_size, size_t len);
+extern void pard_workspace_release(const double *work, double *buf);
+extern int pard_get_num_threads(const pard_solver_t *solver);
+
 /**
- * 迭代精化：提高求解精度
- * 使用残差修正方法
+ * 残差 R = B - A*X（n×nrhs列主序）：非转置时用多线程SpMM，所有右端项一趟扫描A；
+ * transpose非零时为 B - A^T*X，逐列按A的行散射。
+ * pack为SpMM把X转为按行存放的缓冲区（nrhs > 1时需n*nrhs个double，此时SpMM不会失败）
  */
-int pard_iterative_refinement(pard_solver_t *solver, int nrhs, 
-                                const double *rhs, double *sol,
-                                int max_iter, double tol) {
-    if (solver == NULL || rhs == NULL || sol == NULL || nrhs <= 0) {
-        return PARD_ERROR_INVALID_INPUT;
-    }
-    
-    pard_csr_matrix_t *A = solver->matrix;
+static void refinement_residual(pard_solver_t *solver, int nrhs, const double *B,
+                                const double *X, double *R, double *pack, int transpose) {
+    const pard_csr_matrix_t *A = solver->matrix;
     int n = A->n;
-    
-    double *residual = (double *)malloc(n * nrhs * sizeof(double));
-    double *correction = (double *)malloc(n * nrhs * sizeof(double));
-    double *temp = (double *)malloc(n * sizeof(double));
-    
-    if (residual == NULL || correction == NULL || temp == NULL) {
-        free(residual);
-        free(correction);
-        free(temp);
-        return PARD_ERROR_MEMORY;
+    memcpy(R, B, (size_t)n * nrhs * sizeof(double));
+    if (!transpose) {
+        (void)pard_csr_spmm(A, nrhs, -1.0, X, 1.0, R, pack, pard_get_num_threads(solver));
+        return;
     }
-    
-    /* 计算初始残差 */
-    for (int rhs_idx = 0; rhs_idx < nrhs; rhs_idx++) {
-        double *sol_rhs = sol + rhs_idx * n;
-        double *rhs_rhs = (double *)rhs + rhs_idx * n;
-        double *res_rhs = residual + rhs_idx * n;
-        
-        /* 计算残差：r = b - A*x */
+    for (int c = 0; c < nrhs; c++) {
+        const double *x = X + (size_t)c * n;
+        double *r = R + (size_t)c * n;
         for (int i = 0; i < n; i++) {
-            double sum = 0.0;
             for (int j = A->row_ptr[i]; j < A->row_ptr[i + 1]; j++) {
-                sum += A->values[j] * sol_rhs[A->col_idx[j]];
+                r[A->col_idx[j]] -= A->values[j] * x[i];
             }
-            res_rhs[i] = rhs_rhs[i] - sum;
         }
     }
+}
+
+/**
+ * y = A*x（多线程SpMV）
+ */
+static void refinement_matvec(pard_solver_t *solver, const double *x, double *y) {
+    (void)pard_csr_spmm(solver->matrix, 1, 1.0, x, 0.0, y, NULL, pard_get_num_threads(solver));
+}
+
+static double refinement_dot(int n, const double *x, const double *y) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+/**
+ * |A|（transpose非零时为|A^T|）的无穷范数
+ */
+static double refinement_anorm(const pard_csr_matrix_t *A, int transpose, double *work) {
+    int n = A->n;
+    memset(work, 0, n * sizeof(double));
+    for (int i = 0; i < n; i++) {
+        for (int j = A->row_ptr[i]; j < A->row_ptr[i + 1]; j++) {
+            work[transpose ? A->col_idx[j] : i] += fabs(A->values[j]);
+        }
+    }
+    double anorm = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (work[i] > anorm) {
+            anorm = work[i];
+        }
+    }
+    return anorm;
+}
+
+/**
+ * 范数后向误差 |b - A*x| / (|A|*|x| + |b|)（无穷范数），res为已算出的残差
+ */
+static double refinement_berr(int n, double anorm, const double *b, const double *x,
+                              const double *res) {
+    double rnorm = 0.0, xnorm = 0.0, bnorm = 0.0;
+    for (int i = 0; i < n; i++) {
+        rnorm = fmax(rnorm, fabs(res[i]));
+        xnorm = fmax(xnorm, fabs(x[i]));
+        bnorm = fmax(bnorm, fabs(b[i]));
+    }
+    double denom = anorm * xnorm + bnorm;
+    return (denom > 0.0) ? rnorm / denom : 0.0;
+}
+
+/**
+ * Richardson迭代（经典迭代精化）：r = b - A*x，解A*c = r，x += c。
+ * 所有右端项一起求解，直到最大残差的2范数小于tol。buf至少2*n*nrhs个double
+ */
+static int refine_richardson(pard_solver_t *solver, int nrhs, const double *rhs, double *sol,
+                             int max_iter, double tol, int *iters, double *buf) {
+    pard_csr_matrix_t *A = solver->matrix;
+    int n = A->n;
+    
+    double *residual = buf;
+    double *correction = buf + (size_t)n * nrhs;
+    
+    /* 计算初始残差：r = b - A*x（correction此时空闲，用作SpMM的缓冲区） */
+    refinement_residual(solver, nrhs, rhs, sol, residual, correction, 0);
     
     /* 迭代精化 */
+    *iters = 0;
     for (int iter = 0; iter < max_iter; iter++) {
         /* 计算残差的范数 */
         double max_res_norm = 0.0;
         for (int rhs_idx = 0; rhs_idx < nrhs; rhs_idx++) {
             double *res_rhs = residual + rhs_idx * n;
-            double res_norm = 0.0;
-            for (int i = 0; i < n; i++) {
-                res_norm += res_rhs[i] * res_rhs[i];
-            }
-            res_norm = sqrt(res_norm);
+            double res_norm = sqrt(refinement_dot(n, res_rhs, res_rhs));
             if (res_norm > max_res_norm) {
                 max_res_norm = res_norm;
             }
@@ -67,11 +130,9 @@ int pard_iterative_refinement(pard_solver_t *solver, int nrhs,
         /* 求解修正量：A*correction = residual */
         int err = pard_solve_system(solver, nrhs, residual, correction);
         if (err != PARD_SUCCESS) {
-            free(residual);
-            free(correction);
-            free(temp);
             return err;
         }
+        (*iters)++;
         
         /* 更新解：x = x + correction */
         for (int rhs_idx = 0; rhs_idx < nrhs; rhs_idx++) {
@@ -83,24 +144,338 @@ int pard_iterative_refinement(pard_solver_t *solver, int nrhs,
         }
         
         /* 重新计算残差 */
-        for (int rhs_idx = 0; rhs_idx < nrhs; rhs_idx++) {
-            double *sol_rhs = sol + rhs_idx * n;
-            double *rhs_rhs = (double *)rhs + rhs_idx * n;
-            double *res_rhs = residual + rhs_idx * n;
+        refinement_residual(solver, nrhs, rhs, sol, residual, correction, 0);
+    }
+    
+    return PARD_SUCCESS;
+}
+
+/**
+ * FGMRES(restart)的工作区：V、Z、Hessenberg矩阵H与Givens旋转
+ */
+static size_t refine_fgmres_work_size(int n, int restart) {
+    size_t m = (size_t)restart;
+    return (2 * m + 1) * n + (m + 1) * m + 4 * m + 1;
+}
+
+/**
+ * 单个右端项的FGMRES(restart)，右预条件 M^-1 = pard_solve_system（即分解因子）。
+ * 柔性（flexible）形式保存预条件后的向量Z，因此预条件子可以是不精确的（单精度因子、
+ * 扰动主元等），解更新为 x += Z*y。Arnoldi使用修正Gram-Schmidt，最小二乘用Givens旋转。
+ * x为初始解，迭代到残差2范数小于tol或共做max_iter次预条件求解。
+ * buf至少refine_fgmres_work_size(n, restart)个double
+ */
+static int refine_fgmres(pard_solver_t *solver, const double *b, double *x,
+                         int max_iter, double tol, int restart, int *iters, double *buf) {
+    pard_csr_matrix_t *A = solver->matrix;
+    int n = A->n;
+    int m = restart;
+    
+    double *V = buf;
+    double *Z = V + (size_t)(m + 1) * n;
+    double *H = Z + (size_t)m * n;
+    double *cs = H + (size_t)(m + 1) * m;
+    double *sn = cs + m;
+    double *g = sn + m;
+    double *y = g + m + 1;
+    
+    int err = PARD_SUCCESS;
+    *iters = 0;
+    while (*iters < max_iter && err == PARD_SUCCESS) {
+        refinement_residual(solver, 1, b, x, V, NULL, 0);
+        double beta = sqrt(refinement_dot(n, V, V));
+        if (beta < tol) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            V[i] /= beta;
+        }
+        g[0] = beta;
+        
+        /* H按列存放：H[i + j*(m+1)] */
+        int k = 0;
+        while (k < m && *iters < max_iter) {
+            double *vk = V + (size_t)k * n;
+            double *zk = Z + (size_t)k * n;
+            double *w = V + (size_t)(k + 1) * n;
+            double *hk = H + (size_t)k * (m + 1);
+            err = pard_solve_system(solver, 1, vk, zk);
+            if (err != PARD_SUCCESS) {
+                break;
+            }
+            (*iters)++;
+            refinement_matvec(solver, zk, w);
+            for (int i = 0; i <= k; i++) {
+                const double *vi = V + (size_t)i * n;
+                hk[i] = refinement_dot(n, w, vi);
+                for (int t = 0; t < n; t++) {
+                    w[t] -= hk[i] * vi[t];
+                }
+            }
+            hk[k + 1] = sqrt(refinement_dot(n, w, w));
             
+            for (int i = 0; i < k; i++) {
+                double h0 = hk[i], h1 = hk[i + 1];
+                hk[i] = cs[i] * h0 + sn[i] * h1;
+                hk[i + 1] = -sn[i] * h0 + cs[i] * h1;
+            }
+            double r = hypot(hk[k], hk[k + 1]);
+            cs[k] = (r > 0.0) ? hk[k] / r : 1.0;
+            sn[k] = (r > 0.0) ? hk[k + 1] / r : 0.0;
+            double h1 = hk[k + 1];
+            hk[k] = r;
+            g[k + 1] = -sn[k] * g[k];
+            g[k] = cs[k] * g[k];
+            k++;
+            
+            /* 残差范数即|g[k]|；Krylov子空间不再扩大时结束本轮 */
+            if (fabs(g[k]) < tol || h1 == 0.0) {
+                break;
+            }
+            for (int t = 0; t < n; t++) {
+                w[t] /= h1;
+            }
+        }
+        
+        /* 回代求y（H为k×k上三角），x += Z*y */
+        for (int i = k - 1; i >= 0; i--) {
+            double sum = g[i];
+            for (int j = i + 1; j < k; j++) {
+                sum -= H[i + (size_t)j * (m + 1)] * y[j];
+            }
+            double d = H[i + (size_t)i * (m + 1)];
+            y[i] = (d != 0.0) ? sum / d : 0.0;
+        }
+        for (int j = 0; j < k; j++) {
+            const double *zj = Z + (size_t)j * n;
+            for (int t = 0; t < n; t++) {
+                x[t] += y[j] * zj[t];
+            }
+        }
+        if (k > 0 && fabs(g[k]) < tol) {
+            break;
+        }
+    }
+    
+    return err;
+}
+
+/**
+ * 单个右端项的预条件共轭梯度法（对称正定矩阵），预条件子为 pard_solve_system。
+ * 迭代到残差2范数小于tol或共做max_iter次预条件求解。buf至少4*n个double
+ */
+static int refine_pcg(pard_solver_t *solver, const double *b, double *x,
+                      int max_iter, double tol, int *iters, double *buf) {
+    pard_csr_matrix_t *A = solver->matrix;
+    int n = A->n;
+    
+    double *r = buf;
+    double *z = buf + n;
+    double *p = buf + 2 * (size_t)n;
+    double *q = buf + 3 * (size_t)n;
+    
+    *iters = 0;
+    refinement_residual(solver, 1, b, x, r, NULL, 0);
+    int err = PARD_SUCCESS;
+    double rz = 0.0;
+    while (*iters < max_iter && sqrt(refinement_dot(n, r, r)) >= tol) {
+        err = pard_solve_system(solver, 1, r, z);
+        if (err != PARD_SUCCESS) {
+            break;
+        }
+        double rz_new = refinement_dot(n, r, z);
+        if (*iters == 0) {
+            memcpy(p, z, n * sizeof(double));
+        } else {
+            double beta = rz_new / rz;
             for (int i = 0; i < n; i++) {
-                double sum = 0.0;
-                for (int j = A->row_ptr[i]; j < A->row_ptr[i + 1]; j++) {
-                    sum += A->values[j] * sol_rhs[A->col_idx[j]];
-                }
-                res_rhs[i] = rhs_rhs[i] - sum;
+                p[i] = z[i] + beta * p[i];
             }
         }
+        rz = rz_new;
+        (*iters)++;
+        
+        refinement_matvec(solver, p, q);
+        double pq = refinement_dot(n, p, q);
+        if (pq <= 0.0) {
+            /* 矩阵（或预条件后的算子）不正定，CG无法继续 */
+            break;
+        }
+        double alpha = rz / pq;
+        for (int i = 0; i < n; i++) {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+        }
     }
     
-    free(residual);
-    free(correction);
-    free(temp);
+    return err;
+}
+
+/**
+ * pard_iterative_refinement与pard_mixed_precision_solve对nrhs个右端项所需的工作区大小（double个数），
+ * 按当前的精化方法计算
+ */
+size_t pard_refinement_work_size(const pard_solver_t *solver, int nrhs) {
+    if (solver == NULL || solver->matrix == NULL || nrhs <= 0) {
+        return 0;
+    }
+    int n = solver->matrix->n;
+    /* Richardson与混合精度：残差、修正量与一个长度n的向量（|A|的行和） */
+    size_t size = 2 * (size_t)n * nrhs + n + 1;
+    if (solver->refine_method == PARD_REFINE_PCG &&
+        solver->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF) {
+        size_t pcg = 4 * (size_t)n;
+        size = (pcg > size) ? pcg : size;
+    } else if (solver->refine_method != PARD_REFINE_RICHARDSON) {
+        int restart = (solver->refine_restart > 0) ? solver->refine_restart
+                                                   : PARD_DEFAULT_GMRES_RESTART;
+        size_t fgmres = refine_fgmres_work_size(n, restart);
+        size = (fgmres > size) ? fgmres : size;
+    }
+    return size;
+}
+
+/**
+ * 迭代精化：提高求解精度
+ * sol为初始解（通常是pardiso_solve的结果），tol为残差2范数的收敛阈值，
+ * max_iter为每个右端项最多做的预条件求解次数。按solver->refine_method选择：
+ * Richardson（经典残差修正），FGMRES（分解因子作预条件子，对扰动的因子更稳健），
+ * PCG（对称正定矩阵；其他类型改用FGMRES）。Krylov方法逐个右端项独立迭代、独立判断收敛。
+ * 结束后solver->refine_iterations为各右端项迭代次数的最大值，
+ * solver->refine_berr为各右端项范数后向误差的最大值
+ */
+int pard_iterative_refinement(pard_solver_t *solver, int nrhs, 
+                                const double *rhs, double *sol,
+                                int max_iter, double tol) {
+    if (solver == NULL || solver->matrix == NULL || rhs == NULL || sol == NULL || nrhs <= 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
     
+    pard_csr_matrix_t *A = solver->matrix;
+    int n = A->n;
+    pard_refinement_t method = solver->refine_method;
+    if (method == PARD_REFINE_PCG &&
+        solver->matrix_type != PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF) {
+        method = PARD_REFINE_FGMRES;
+    }
+    int restart = (solver->refine_restart > 0) ? solver->refine_restart
+                                               : PARD_DEFAULT_GMRES_RESTART;
+    
+    /* 临时向量取自求解器的工作区，不够时临时分配 */
+    double *buf = pard_workspace_acquire(solver->refine_work, solver->refine_work_size,
+                                         pard_refinement_work_size(solver, nrhs));
+    if (buf == NULL) {
+        return PARD_ERROR_MEMORY;
+    }
+    
+    int err = PARD_SUCCESS;
+    int max_iters = 0;
+    if (method == PARD_REFINE_FGMRES || method == PARD_REFINE_PCG) {
+        for (int r = 0; r < nrhs && err == PARD_SUCCESS; r++) {
+            int iters = 0;
+            if (method == PARD_REFINE_FGMRES) {
+                err = refine_fgmres(solver, rhs + (size_t)r * n, sol + (size_t)r * n,
+                                    max_iter, tol, restart, &iters, buf);
+            } else {
+                err = refine_pcg(solver, rhs + (size_t)r * n, sol + (size_t)r * n,
+                                 max_iter, tol, &iters, buf);
+            }
+            if (iters > max_iters) {
+                max_iters = iters;
+            }
+        }
+    } else {
+        err = refine_richardson(solver, nrhs, rhs, sol, max_iter, tol, &max_iters, buf);
+    }
+    if (err != PARD_SUCCESS) {
+        pard_workspace_release(solver->refine_work, buf);
+        return err;
+    }
+    
+    /* 各右端项的后向误差：buf依次为残差、SpMM缓冲区与|A|的行和 */
+    double *res = buf;
+    refinement_residual(solver, nrhs, rhs, sol, res, buf + (size_t)n * nrhs, 0);
+    double anorm = refinement_anorm(A, 0, buf + 2 * (size_t)n * nrhs);
+    double berr = 0.0;
+    for (int r = 0; r < nrhs; r++) {
+        size_t off = (size_t)r * n;
+        double e = refinement_berr(n, anorm, rhs + off, sol + off, res + off);
+        if (e > berr) {
+            berr = e;
+        }
+    }
+    pard_workspace_release(solver->refine_work, buf);
+    
+    solver->refine_iterations = max_iters;
+    solver->refine_berr = berr;
     return PARD_SUCCESS;
 }
+
+/**
+ * 混合精度求解：用单精度保存的因子求解，残差与解保持双精度，迭代精化到双精度精度
+ * 每一步计算范数后向误差 |b - A*x| / (|A|*|x| + |b|)，达到PARD_MIXED_BERR_TOL即结束；
+ * 若某一步后向误差下降不到一半，或PARD_MIXED_MAX_ITER步内未达到目标，
+ * 说明矩阵对单精度因子而言过于病态，*stagnated置1，由调用者改用双精度重新分解。
+ * transpose非零时求解A^T*x = b
+ */
+int pard_mixed_precision_solve(pard_solver_t *solver, int nrhs, const double *rhs,
+                               double *sol, int transpose, int *stagnated) {
+    if (solver == NULL || solver->matrix == NULL || rhs == NULL || sol == NULL ||
+        nrhs <= 0 || stagnated == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    
+    pard_csr_matrix_t *A = solver->matrix;
+    int n = A->n;
+    *stagnated = 0;
+    
+    double *buf = pard_workspace_acquire(solver->refine_work, solver->refine_work_size,
+                                         2 * (size_t)n * nrhs + n + 1);
+    if (buf == NULL) {
+        return PARD_ERROR_MEMORY;
+    }
+    double *residual = buf;
+    double *correction = buf + (size_t)n * nrhs;
+    double *rowsum = buf + 2 * (size_t)n * nrhs;
+    
+    double anorm = refinement_anorm(A, transpose, rowsum);
+    
+    int err = transpose ? pard_solve_transpose_system(solver, nrhs, rhs, sol)
+                        : pard_solve_system(solver, nrhs, rhs, sol);
+    double prev_berr = 0.0;
+    int converged = 0;
+    for (int iter = 0; err == PARD_SUCCESS && iter <= PARD_MIXED_MAX_ITER; iter++) {
+        /* correction此时空闲，用作SpMM的缓冲区 */
+        refinement_residual(solver, nrhs, rhs, sol, residual, correction, transpose);
+        double berr = 0.0;
+        for (int r = 0; r < nrhs; r++) {
+            size_t off = (size_t)r * n;
+            double e = refinement_berr(n, anorm, rhs + off, sol + off, residual + off);
+            if (e > berr) {
+                berr = e;
+            }
+        }
+        
+        if (berr <= PARD_MIXED_BERR_TOL) {
+            converged = 1;
+            break;
+        }
+        if ((iter > 0 && berr > PARD_MIXED_MIN_REDUCTION * prev_berr) ||
+            iter == PARD_MIXED_MAX_ITER) {
+            break;
+        }
+        prev_berr = berr;
+        
+        err = transpose ? pard_solve_transpose_system(solver, nrhs, residual, correction)
+                        : pard_solve_system(solver, nrhs, residual, correction);
+        for (size_t i = 0; err == PARD_SUCCESS && i < (size_t)n * nrhs; i++) {
+            sol[i] += correction[i];
+        }
+    }
+    if (err == PARD_SUCCESS && !converged) {
+        *stagnated = 1;
+    }
+    
+    pard_workspace_release(solver->refine_work, buf);
+    return err;
+}
@@ -1,14 +1,15 @@
 #include "pard.h"
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
 
 /* 前向声明 */
-int pard_backward_substitution_ldlt(const pard_factors_t *factors,
-                                    const double *y, double *x, int nrhs);
+extern int pard_supernodal_substitute(const pard_factors_t *factors, int nrhs,
+                                      const double *in, double *out, int backward);
 
 /**
  * 后向替换：求解 U*x = y（上三角系统）
+ * y按主元顺序编号，解x的第t行对应第t个主元列（LU为重排后矩阵的第factors->col_perm[t]列），
+ * 在数值分解保存的超节点面板上逐个面板逆序求解；Cholesky的U为L^T
  */
 int pard_backward_substitution(const pard_factors_t *factors,
                                 const double *y, double *x, int nrhs) {
@@ -16,49 +17,63 @@ int pard_backward_substitution(const pard_factors_t *factors,
         return PARD_ERROR_INVALID_INPUT;
     }
     
+    return pard_supernodal_substitute(factors, nrhs, y, x, 1);
+}
+
+/**
+ * 导出的CSR因子上的LDL^T回代（见pardiso_set_csr_factors）：先解D（1x1与2x2主元），
+ * L按行存放，第j行即L^T的第j列，因此L^T*x = z按列定向（散射）求解：
+ * 自下而上，x[j]确定后立即从x[c]（c < j，L(j,c)非零）中减去L(j,c)*x[j]，不需要转置存储
+ */
+static int backward_ldlt_csr(const pard_factors_t *factors, const double *y, double *x,
+                             int nrhs) {
     int n = factors->n;
-    
-    /* 复制y到x */
-    memcpy(x, y, n * nrhs * sizeof(double));
-    
-    /* 对于每个右端项 */
-    for (int rhs = 0; rhs < nrhs; rhs++) {
-        double *x_rhs = x + rhs * n;
+    for (int r = 0; r < nrhs; r++) {
+        const double *y_rhs = y + (size_t)r * n;
+        double *x_rhs = x + (size_t)r * n;
         
-        /* 后向替换 */
-        for (int i = n - 1; i >= 0; i--) {
-            double sum = x_rhs[i];
-            
-            /* 减去U[i][j] * x[j]（j > i） */
-            for (int j = factors->u_row_ptr[i]; j < factors->u_row_ptr[i + 1]; j++) {
-                int col = factors->u_col_idx[j];
-                if (col > i) {
-                    sum -= factors->u_values[j] * x_rhs[col];
+        for (int i = 0; i < n; ) {
+            if (factors->pivot_type[i] == 2 && i + 1 < n) {
+                double d11 = factors->d_values[i];
+                double d21 = factors->d_offdiag[i];
+                double d22 = factors->d_values[i + 1];
+                double det = d11 * d22 - d21 * d21;
+                if (det == 0.0) {
+                    return PARD_ERROR_NUMERICAL;
                 }
-            }
-            
-            /* 除以U[i][i] */
-            double diag = 0.0;
-            for (int j = factors->u_row_ptr[i]; j < factors->u_row_ptr[i + 1]; j++) {
-                if (factors->u_col_idx[j] == i) {
-                    diag = factors->u_values[j];
-                    break;
+                double y0 = y_rhs[i], y1 = y_rhs[i + 1];
+                x_rhs[i] = (d22 * y0 - d21 * y1) / det;
+                x_rhs[i + 1] = (d11 * y1 - d21 * y0) / det;
+                i += 2;
+            } else {
+                if (factors->d_values[i] == 0.0) {
+                    return PARD_ERROR_NUMERICAL;
                 }
+                x_rhs[i] = y_rhs[i] / factors->d_values[i];
+                i++;
+            }
+        }
+        
+        for (int j = n - 1; j > 0; j--) {
+            double xj = x_rhs[j];
+            if (xj == 0.0) {
+                continue;
             }
-            
-            if (fabs(diag) < 1e-15) {
-                return PARD_ERROR_NUMERICAL;
+            for (int p = factors->row_ptr[j]; p < factors->row_ptr[j + 1]; p++) {
+                int c = factors->col_idx[p];
+                if (c < j) {
+                    x_rhs[c] -= factors->l_values[p] * xj;
+                }
             }
-            
-            x_rhs[i] = sum / diag;
         }
     }
-    
     return PARD_SUCCESS;
 }
 
 /**
  * 后向替换（LDL^T分解）：求解 D*L^T*x = y
+ * 导出了CSR因子时直接在CSR的L上按列散射求解，否则先在各面板的主元块上解D（1x1与2x2主元），
+ * 再逆序逐个面板求解L^T*x = z；两种方式的代价都是O(nnz(L)*nrhs)
  */
 int pard_backward_substitution_ldlt(const pard_factors_t *factors,
                                     const double *y, double *x, int nrhs) {
@@ -66,73 +81,8 @@ int pard_backward_substitution_ldlt(const pard_factors_t *factors,
         return PARD_ERROR_INVALID_INPUT;
     }
     
-    int n = factors->n;
-    
-    /* 首先求解 D*z = y */
-    double *z = (double *)malloc(n * nrhs * sizeof(double));
-    if (z == NULL) {
-        return PARD_ERROR_MEMORY;
-    }
-    
-    for (int rhs = 0; rhs < nrhs; rhs++) {
-        const double *y_rhs = y + rhs * n;
-        double *z_rhs = z + rhs * n;
-        
-        int i = 0;
-        while (i < n) {
-            if (factors->pivot_type[i] == 2 && i < n - 1) {
-                /* 2x2主元块 */
-                /* 在LDLT分解中，对于2x2块，d_values存储的是D矩阵的逆的对角元素 */
-                /* D_inv = [d11 0; 0 d22]，其中d11 = a22/det, d22 = a11/det */
-                /* 所以 z = D_inv * y */
-                z_rhs[i] = factors->d_values[i] * y_rhs[i];
-                z_rhs[i + 1] = factors->d_values[i + 1] * y_rhs[i + 1];
-                i += 2;
-            } else {
-                /* 1x1主元 */
-                /* 检查数值稳定性 */
-                double max_d_val = fabs(factors->d_values[i]);
-                for (int j = 0; j < n; j++) {
-                    if (factors->pivot_type[j] == 1 && fabs(factors->d_values[j]) > max_d_val) {
-                        max_d_val = fabs(factors->d_values[j]);
-                    }
-                }
-                if (fabs(factors->d_values[i]) < 1e-12 * max_d_val) {
-                    free(z);
-                    return PARD_ERROR_NUMERICAL;
-                }
-                z_rhs[i] = y_rhs[i] / factors->d_values[i];
-                i++;
-            }
-        }
-    }
-    
-    /* 然后求解 L^T*x = z（后向替换） */
-    memcpy(x, z, n * nrhs * sizeof(double));
-    
-    for (int rhs = 0; rhs < nrhs; rhs++) {
-        double *x_rhs = x + rhs * n;
-        
-        for (int i = n - 1; i >= 0; i--) {
-            double sum = x_rhs[i];
-            
-            /* 减去L^T[i][j] * x[j]（j > i） */
-            for (int j = 0; j < n; j++) {
-                if (j > i) {
-                    /* 查找L[j][i] */
-                    for (int k = factors->row_ptr[j]; k < factors->row_ptr[j + 1]; k++) {
-                        if (factors->col_idx[k] == i) {
-                            sum -= factors->l_values[k] * x_rhs[j];
-                            break;
-                        }
-                    }
-                }
-            }
-            
-            x_rhs[i] = sum;
-        }
+    if (factors->l_values != NULL && factors->pivot_type != NULL) {
+        return backward_ldlt_csr(factors, y, x, nrhs);
     }
-    
-    free(z);
-    return PARD_SUCCESS;
+    return pard_supernodal_substitute(factors, nrhs, y, x, 1);
 }
@@ -3,11 +3,14 @@
 #include <string.h>
 
 /* 前向声明 */
-int pard_forward_substitution_ldlt(const pard_factors_t *factors,
-                                    const double *b, double *y, int nrhs);
+extern int pard_supernodal_substitute(const pard_factors_t *factors, int nrhs,
+                                      const double *in, double *out, int backward);
 
 /**
  * 前向替换：求解 L*y = b（下三角系统）
+ * b、y按主元顺序编号（第t行为重排后矩阵的第factors->perm[t]行），
+ * 在数值分解保存的超节点面板上逐个面板求解。
+ * LU为单位下三角L；Cholesky为因子L本身，与pard_backward_substitution的L^T配对
  */
 int pard_forward_substitution(const pard_factors_t *factors, 
                                const double *b, double *y, int nrhs) {
@@ -15,38 +18,13 @@ int pard_forward_substitution(const pard_factors_t *factors,
         return PARD_ERROR_INVALID_INPUT;
     }
     
-    int n = factors->n;
-    
-    /* 复制右端项 */
-    memcpy(y, b, n * nrhs * sizeof(double));
-    
-    /* 对于每个右端项 */
-    for (int rhs = 0; rhs < nrhs; rhs++) {
-        double *y_rhs = y + rhs * n;
-        
-        /* 前向替换 */
-        for (int i = 0; i < n; i++) {
-            double sum = y_rhs[i];
-            
-            /* 减去L[i][j] * y[j]（j < i） */
-            for (int j = factors->row_ptr[i]; j < factors->row_ptr[i + 1]; j++) {
-                int col = factors->col_idx[j];
-                if (col < i) {
-                    sum -= factors->l_values[j] * y_rhs[col];
-                }
-            }
-            
-            /* L[i][i] = 1（对于LU分解）或需要除以L[i][i] */
-            /* 这里假设L的对角元素为1 */
-            y_rhs[i] = sum;
-        }
-    }
-    
-    return PARD_SUCCESS;
+    return pard_supernodal_substitute(factors, nrhs, b, y, 0);
 }
 
 /**
  * 前向替换（LDL^T分解）：求解 L*y = b
+ * L为单位下三角，2x2主元块内的L(i+1,i)为0（块间耦合由D的非对角元表示），
+ * D留给pard_backward_substitution_ldlt求解
  */
 int pard_forward_substitution_ldlt(const pard_factors_t *factors,
                                     const double *b, double *y, int nrhs) {
@@ -54,50 +32,5 @@ int pard_forward_substitution_ldlt(const pard_factors_t *factors,
         return PARD_ERROR_INVALID_INPUT;
     }
     
-    int n = factors->n;
-    
-    memcpy(y, b, n * nrhs * sizeof(double));
-    
-    for (int rhs = 0; rhs < nrhs; rhs++) {
-        double *y_rhs = y + rhs * n;
-        
-        int i = 0;
-        while (i < n) {
-            if (factors->pivot_type[i] == 2 && i < n - 1) {
-                /* 2x2主元块 */
-                double sum1 = y_rhs[i];
-                double sum2 = y_rhs[i + 1];
-                
-                for (int j = factors->row_ptr[i]; j < factors->row_ptr[i + 1]; j++) {
-                    int col = factors->col_idx[j];
-                    if (col < i) {
-                        double l_val = factors->l_values[j];
-                        sum1 -= l_val * y_rhs[col];
-                        if (j < factors->row_ptr[i + 1] - 1) {
-                            sum2 -= factors->l_values[j + 1] * y_rhs[col];
-                        }
-                    }
-                }
-                
-                y_rhs[i] = sum1;
-                y_rhs[i + 1] = sum2;
-                i += 2;
-            } else {
-                /* 1x1主元 */
-                double sum = y_rhs[i];
-                
-                for (int j = factors->row_ptr[i]; j < factors->row_ptr[i + 1]; j++) {
-                    int col = factors->col_idx[j];
-                    if (col < i) {
-                        sum -= factors->l_values[j] * y_rhs[col];
-                    }
-                }
-                
-                y_rhs[i] = sum;
-                i++;
-            }
-        }
-    }
-    
-    return PARD_SUCCESS;
+    return pard_supernodal_substitute(factors, nrhs, b, y, 0);
 }
@@ -3,129 +3,133 @@
 #include <string.h>
 
 /* 前向声明 */
-extern int pard_forward_substitution_ldlt(const pard_factors_t *factors,
-                                            const double *b, double *y, int nrhs);
-extern int pard_backward_substitution_ldlt(const pard_factors_t *factors,
-                                            const double *y, double *x, int nrhs);
+extern int pard_supernodal_solve(const pard_factors_t *factors, int nrhs,
+                                 const double *rhs, double *sol, int transpose, double *work);
+extern size_t pard_supernodal_solve_work_size(const pard_factors_t *factors, int nrhs);
+extern int pard_supernodal_solve_sparse(const pard_factors_t *factors,
+                                        int rhs_nnz, const int *rhs_idx, const double *rhs_val,
+                                        int nout, const int *out_idx, double *out_val,
+                                        double *work, int *iwork);
+extern size_t pard_supernodal_sparse_work_size(const pard_factors_t *factors);
+extern size_t pard_supernodal_sparse_iwork_size(const pard_factors_t *factors);
+extern int pard_solve_schedule(pard_factors_t *factors, int nthreads);
+extern int pard_get_num_threads(const pard_solver_t *solver);
 
 /**
- * 求解线性系统：A*x = b
- * 根据矩阵类型选择LU或LDL^T分解
+ * 从工作区work（work_size个double）中取len个double；工作区为空或不够大时临时分配。
+ * 用完后以pard_workspace_release归还
  */
-int pard_solve_system(pard_solver_t *solver, int nrhs, const double *rhs, double *sol) {
-    if (solver == NULL || solver->factors == NULL || rhs == NULL || sol == NULL || nrhs <= 0) {
-        return PARD_ERROR_INVALID_INPUT;
-    }
-    
-    pard_factors_t *factors = solver->factors;
-    int n = factors->n;
-    
-    /* 应用行置换到右端项 */
-    /* 注意：对于LU分解，factors->perm存在；对于LDLT分解，置换已在分解时处理 */
-    double *perm_rhs = (double *)malloc(n * nrhs * sizeof(double));
-    if (perm_rhs == NULL) {
-        return PARD_ERROR_MEMORY;
+double *pard_workspace_acquire(double *work, size_t work_size, size_t len) {
+    if (work != NULL && len <= work_size) {
+        return work;
     }
-    
-    if (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF) {
-        /* LDLT分解：需要应用factors中的置换（来自数值分解阶段的pivoting） */
-        if (factors->perm == NULL) {
-            memcpy(perm_rhs, rhs, n * nrhs * sizeof(double));
-        } else {
-            for (int rhs_idx = 0; rhs_idx < nrhs; rhs_idx++) {
-                for (int i = 0; i < n; i++) {
-                    perm_rhs[rhs_idx * n + i] = rhs[rhs_idx * n + factors->perm[i]];
-                }
-            }
-        }
-    } else {
-        /* LU分解：需要应用factors中的置换 */
-        if (factors->perm == NULL) {
-            /* 如果没有置换，直接复制 */
-            memcpy(perm_rhs, rhs, n * nrhs * sizeof(double));
-        } else {
-            for (int rhs_idx = 0; rhs_idx < nrhs; rhs_idx++) {
-                for (int i = 0; i < n; i++) {
-                    perm_rhs[rhs_idx * n + i] = rhs[rhs_idx * n + factors->perm[i]];
-                }
-            }
-        }
+    return (double *)malloc((len > 0 ? len : 1) * sizeof(double));
+}
+
+void pard_workspace_release(const double *work, double *buf) {
+    if (buf != work) {
+        free(buf);
     }
-    
-    double *y = (double *)malloc(n * nrhs * sizeof(double));
-    if (y == NULL) {
-        free(perm_rhs);
-        return PARD_ERROR_MEMORY;
+}
+
+/**
+ * pard_solve_system / pard_solve_transpose_system对nrhs个右端项所需的工作区大小（double个数）
+ */
+size_t pard_solve_work_size(const pard_factors_t *factors, int nrhs) {
+    if (factors == NULL || nrhs <= 0) {
+        return 0;
     }
-    
-    int err;
-    
-    if (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF) {
-        /* LDL^T分解 */
-        err = pard_forward_substitution_ldlt(factors, perm_rhs, y, nrhs);
-        if (err != PARD_SUCCESS) {
-            free(perm_rhs);
-            free(y);
-            return err;
-        }
-        
-        err = pard_backward_substitution_ldlt(factors, y, sol, nrhs);
-    } else {
-        /* LU分解 */
-        err = pard_forward_substitution(factors, perm_rhs, y, nrhs);
-        if (err != PARD_SUCCESS) {
-            free(perm_rhs);
-            free(y);
-            return err;
-        }
-        
-        err = pard_backward_substitution(factors, y, sol, nrhs);
+    return pard_supernodal_solve_work_size(factors, nrhs);
+}
+
+/**
+ * 稀疏右端项求解所需的int工作区大小（面板标记与栈），double部分由pard_solve_work_size覆盖
+ */
+size_t pard_solve_sparse_iwork_size(const pard_factors_t *factors) {
+    return pard_supernodal_sparse_iwork_size(factors);
+}
+
+/**
+ * 分解后线程数改变时重建面板求解的并行调度
+ */
+static int solve_update_schedule(pard_solver_t *solver) {
+    int nthreads = pard_get_num_threads(solver);
+    if (nthreads != solver->factors->sched_nthreads) {
+        return pard_solve_schedule(solver->factors, nthreads);
     }
-    
+    return PARD_SUCCESS;
+}
+
+/**
+ * 面板求解：求解器的工作区够用时直接使用，否则由pard_supernodal_solve临时分配
+ */
+static int solve_panels(pard_solver_t *solver, int nrhs, const double *rhs, double *sol,
+                        int transpose) {
+    int err = solve_update_schedule(solver);
     if (err != PARD_SUCCESS) {
-        free(perm_rhs);
-        free(y);
         return err;
     }
+    size_t need = pard_supernodal_solve_work_size(solver->factors, nrhs);
+    double *work = (need <= solver->solve_work_size) ? solver->solve_work : NULL;
+    return pard_supernodal_solve(solver->factors, nrhs, rhs, sol, transpose, work);
+}
+
+/**
+ * 求解线性系统：A*x = b
+ * 在数值分解保存的超节点面板上分块求解（所有右端项一起处理，按子树多线程）。
+ * 临时向量取自求解器的工作区（pardiso_factor后按pardiso_set_max_nrhs分配），
+ * nrhs超过工作区容量时临时分配
+ */
+int pard_solve_system(pard_solver_t *solver, int nrhs, const double *rhs, double *sol) {
+    if (solver == NULL || solver->factors == NULL || solver->factors->panels == NULL ||
+        rhs == NULL || sol == NULL || nrhs <= 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
     
-    /* 应用列置换的逆（如果需要） */
-    if (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF) {
-        /* 对于LDLT分解，需要应用逆置换到解 */
-        /* 如果perm[i] = j，意味着原始位置i被映射到位置j */
-        /* 逆置换：如果perm[i] = j，那么inv_perm[j] = i */
-        if (factors->perm != NULL) {
-            double *tmp_sol = (double *)malloc(n * nrhs * sizeof(double));
-            if (tmp_sol == NULL) {
-                free(perm_rhs);
-                free(y);
-                return PARD_ERROR_MEMORY;
-            }
-            memcpy(tmp_sol, sol, n * nrhs * sizeof(double));
-            /* 计算逆置换 */
-            int *inv_perm = (int *)malloc(n * sizeof(int));
-            if (inv_perm == NULL) {
-                free(tmp_sol);
-                free(perm_rhs);
-                free(y);
-                return PARD_ERROR_MEMORY;
-            }
-            for (int i = 0; i < n; i++) {
-                inv_perm[factors->perm[i]] = i;
-            }
-            for (int rhs_idx = 0; rhs_idx < nrhs; rhs_idx++) {
-                for (int i = 0; i < n; i++) {
-                    sol[rhs_idx * n + i] = tmp_sol[rhs_idx * n + inv_perm[i]];
-                }
-            }
-            free(inv_perm);
-            free(tmp_sol);
-        }
-    } else {
-        /* 对于非对称矩阵，可能需要额外的列置换 */
+    return solve_panels(solver, nrhs, rhs, sol, 0);
+}
+
+/**
+ * 稀疏右端项求解：b以(rhs_idx, rhs_val)给出，只返回x的out_idx各分量（out_idx为NULL时返回完整解）
+ * 只处理消元树上可达的超节点面板。临时向量与标记取自求解器的工作区，只复位可达面板涉及的元素，
+ * 每次求解不再分配、清零长度为n的数组；工作区不够大时临时分配
+ */
+int pard_solve_sparse_system(pard_solver_t *solver, int rhs_nnz, const int *rhs_idx,
+                             const double *rhs_val, int nout, const int *out_idx,
+                             double *out_val) {
+    if (solver == NULL || solver->factors == NULL || solver->factors->panels == NULL ||
+        out_val == NULL || rhs_nnz < 0 ||
+        (rhs_nnz > 0 && (rhs_idx == NULL || rhs_val == NULL)) ||
+        (out_idx != NULL && nout < 0)) {
+        return PARD_ERROR_INVALID_INPUT;
     }
     
-    free(perm_rhs);
-    free(y);
+    const pard_factors_t *f = solver->factors;
+    double *work = (pard_supernodal_sparse_work_size(f) <= solver->solve_work_size)
+                       ? solver->solve_work : NULL;
+    int *iwork = (pard_supernodal_sparse_iwork_size(f) <= solver->solve_iwork_size)
+                     ? solver->solve_iwork : NULL;
+    return pard_supernodal_solve_sparse(f, rhs_nnz, rhs_idx, rhs_val, nout, out_idx, out_val,
+                                        work, iwork);
+}
+
+/**
+ * 转置求解：A^T*x = b，复用A的LU因子，不需要对A^T重新分解
+ * 对称矩阵A^T = A，直接求解。LU分解 P*A*Q = L*U 时 A^T = Q*U^T*L^T*P，
+ * 在同一组面板上先按列号前代U^T、再按行号回代L^T，不需要转置存储
+ */
+int pard_solve_transpose_system(pard_solver_t *solver, int nrhs, const double *rhs,
+                                double *sol) {
+    if (solver == NULL || solver->factors == NULL || solver->factors->panels == NULL ||
+        rhs == NULL || sol == NULL || nrhs <= 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
     
-    return PARD_SUCCESS;
+    pard_factors_t *factors = solver->factors;
+    if (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF ||
+        factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF) {
+        return pard_solve_system(solver, nrhs, rhs, sol);
+    }
+    
+    return solve_panels(solver, nrhs, rhs, sol, 1);
 }
@@ -0,0 +1,956 @@
+#include "pard.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/* 前向声明 */
+extern void pard_dense_gemm_nn(int m, int n, int k,
+                               const double *A, int lda,
+                               const double *B, int ldb,
+                               double *C, int ldc);
+extern void pard_dense_gemm_tn(int m, int n, int k,
+                               const double *A, int lda,
+                               const double *B, int ldb,
+                               double *C, int ldc);
+extern void pard_dense_trsm_lower(int k, int nrhs, const double *L, int ldl,
+                                  double *B, int ldb, int unit);
+extern void pard_dense_trsm_lower_trans(int k, int nrhs, const double *L, int ldl,
+                                        double *B, int ldb, int unit);
+extern void pard_dense_trsm_upper(int k, int nrhs, const double *U, int ldu,
+                                  double *B, int ldb);
+extern void pard_dense_trsm_upper_trans(int k, int nrhs, const double *U, int ldu,
+                                        double *B, int ldb);
+extern void pard_dense_gemm_nn_float(int m, int n, int k,
+                                     const float *A, int lda,
+                                     const double *B, int ldb,
+                                     double *C, int ldc);
+extern void pard_dense_gemm_tn_float(int m, int n, int k,
+                                     const float *A, int lda,
+                                     const double *B, int ldb,
+                                     double *C, int ldc);
+extern void pard_dense_trsm_lower_float(int k, int nrhs, const float *L, int ldl,
+                                        double *B, int ldb, int unit);
+extern void pard_dense_trsm_lower_trans_float(int k, int nrhs, const float *L, int ldl,
+                                              double *B, int ldb, int unit);
+extern void pard_dense_trsm_upper_float(int k, int nrhs, const float *U, int ldu,
+                                        double *B, int ldb);
+extern void pard_dense_trsm_upper_trans_float(int k, int nrhs, const float *U, int ldu,
+                                              double *B, int ldb);
+extern int pard_ooc_stream_begin(pard_ooc_t *ooc, const int *order, int count);
+extern int pard_ooc_stream_next(pard_ooc_t *ooc, double **L, double **U);
+extern void pard_ooc_stream_release(pard_ooc_t *ooc);
+extern void pard_ooc_stream_end(pard_ooc_t *ooc);
+
+/* 并行求解的最大线程数 */
+#define PARD_SOLVE_MAX_THREADS 64
+/* 多线程求解的最小运算量（面板元素数 × 右端项数） */
+#define PARD_SOLVE_MT_MIN_WORK 2.0e5
+
+/**
+ * 面板的D块求解：W = D^-1 * W（W为k×nrhs），1x1与2x2主元
+ */
+static int supernodal_solve_d(const pard_panel_t *P, int nrhs, double *W) {
+    int k = P->k;
+    for (int t = 0; t < k; ) {
+        if (P->piv[t] == 2 && t + 1 < k) {
+            double a = P->d[t], b = P->d[k + t], c = P->d[t + 1];
+            double det = a * c - b * b;
+            if (det == 0.0) {
+                return PARD_ERROR_NUMERICAL;
+            }
+            for (int r = 0; r < nrhs; r++) {
+                double *w = W + (size_t)r * k;
+                double x0 = w[t], x1 = w[t + 1];
+                w[t] = (c * x0 - b * x1) / det;
+                w[t + 1] = (a * x1 - b * x0) / det;
+            }
+            t += 2;
+        } else {
+            if (P->d[t] == 0.0) {
+                return PARD_ERROR_NUMERICAL;
+            }
+            double inv = 1.0 / P->d[t];
+            for (int r = 0; r < nrhs; r++) {
+                W[t + (size_t)r * k] *= inv;
+            }
+            t++;
+        }
+    }
+    return PARD_SUCCESS;
+}
+
+/**
+ * 从按行存放的Y中取出idx[0..cnt)各行，组成cnt×nrhs列主序块W
+ */
+static void supernodal_gather(const double *Y, int nrhs, const int *idx, int cnt, double *W) {
+    for (int t = 0; t < cnt; t++) {
+        const double *y = Y + (size_t)idx[t] * nrhs;
+        for (int r = 0; r < nrhs; r++) {
+            W[t + (size_t)r * cnt] = y[r];
+        }
+    }
+}
+
+/**
+ * 把cnt×nrhs列主序块W写回按行存放的Y的idx[0..cnt)各行
+ */
+static void supernodal_scatter(const double *W, int cnt, int nrhs, const int *idx, double *Y) {
+    for (int t = 0; t < cnt; t++) {
+        double *y = Y + (size_t)idx[t] * nrhs;
+        for (int r = 0; r < nrhs; r++) {
+            y[r] = W[t + (size_t)r * cnt];
+        }
+    }
+}
+
+/**
+ * 求解过程的共享数据
+ */
+typedef struct {
+    const pard_factors_t *factors;
+    int nrhs;
+    int is_chol;
+    int is_ldlt;
+    int is_lu;
+    int transpose;      /* LU的转置求解 A^T*X = B：前代U^T（按列编号），回代L^T（按行编号） */
+    double *Y;          /* 前代结果，按行存放 */
+    double *X;          /* 回代结果，按行存放（对称情形与Y相同） */
+} supernodal_ctx_t;
+
+/**
+ * 每个线程的工作区
+ * topbuf累加本线程子树对顶层行的前代更新（按top_row_index编号，按行存放），
+ * 各线程结束后再归约到Y，避免不同子树同时更新同一顶层行
+ */
+typedef struct {
+    const supernodal_ctx_t *ctx;
+    int tid;
+    double *W;
+    double *T;
+    double *topbuf;
+    int err;
+} supernodal_worker_t;
+
+/**
+ * 一个面板的前代：解主元块、更新面板下方行，LDL^T另解D
+ * 转置求解时以U^T代替L，行号换成列号。
+ * top_index非NULL时，属于顶层面板的行更新写入topbuf
+ */
+static int supernodal_forward_panel(const supernodal_ctx_t *ctx, const pard_panel_t *P,
+                                    double *W, double *T,
+                                    const int *top_index, double *topbuf) {
+    int nrhs = ctx->nrhs;
+    int k = P->k;
+    int mo = P->m - k;
+    const int *idx = ctx->transpose ? P->cols : P->rows;
+    if (k == 0) {
+        return PARD_SUCCESS;
+    }
+    supernodal_gather(ctx->Y, nrhs, idx, k, W);
+
+    if (ctx->transpose) {
+        if (P->Uf != NULL) {
+            pard_dense_trsm_upper_trans_float(k, nrhs, P->Uf, k, W, k);
+        } else {
+            pard_dense_trsm_upper_trans(k, nrhs, P->U, k, W, k);
+        }
+    } else {
+        if (P->Lf != NULL) {
+            pard_dense_trsm_lower_float(k, nrhs, P->Lf, P->m, W, k, !ctx->is_chol);
+        } else {
+            pard_dense_trsm_lower(k, nrhs, P->L, P->m, W, k, !ctx->is_chol);
+        }
+    }
+
+    if (mo > 0) {
+        memset(T, 0, (size_t)mo * nrhs * sizeof(double));
+        if (ctx->transpose) {
+            if (P->Uf != NULL) {
+                pard_dense_gemm_tn_float(mo, nrhs, k, P->Uf + (size_t)k * k, k, W, k, T, mo);
+            } else {
+                pard_dense_gemm_tn(mo, nrhs, k, P->U + (size_t)k * k, k, W, k, T, mo);
+            }
+        } else {
+            if (P->Lf != NULL) {
+                pard_dense_gemm_nn_float(mo, nrhs, k, P->Lf + k, P->m, W, k, T, mo);
+            } else {
+                pard_dense_gemm_nn(mo, nrhs, k, P->L + k, P->m, W, k, T, mo);
+            }
+        }
+        for (int i = 0; i < mo; i++) {
+            int row = idx[k + i];
+            double *y = (top_index != NULL && top_index[row] >= 0) ?
+                        topbuf + (size_t)top_index[row] * nrhs :
+                        ctx->Y + (size_t)row * nrhs;
+            for (int r = 0; r < nrhs; r++) {
+                y[r] += T[i + (size_t)r * mo];
+            }
+        }
+    }
+
+    int err = PARD_SUCCESS;
+    if (ctx->is_ldlt) {
+        err = supernodal_solve_d(P, nrhs, W);
+    }
+
+    supernodal_scatter(W, k, nrhs, idx, ctx->Y);
+    return err;
+}
+
+/**
+ * 一个面板的回代：先减去已求出的非主元列的贡献，再解主元块
+ * 转置求解时以L^T代替U，前代结果按列号读取，解按行号写入
+ */
+static void supernodal_backward_panel(const supernodal_ctx_t *ctx, const pard_panel_t *P,
+                                      double *W, double *T) {
+    int nrhs = ctx->nrhs;
+    int k = P->k;
+    int mo = P->m - k;
+    int use_u = ctx->is_lu && !ctx->transpose;
+    const int *yidx = ctx->transpose ? P->cols : P->rows;
+    const int *xidx = use_u ? P->cols : P->rows;
+    if (k == 0) {
+        return;
+    }
+    supernodal_gather(ctx->Y, nrhs, yidx, k, W);
+
+    if (mo > 0) {
+        supernodal_gather(ctx->X, nrhs, xidx + k, mo, T);
+        if (use_u) {
+            if (P->Uf != NULL) {
+                pard_dense_gemm_nn_float(k, nrhs, mo, P->Uf + (size_t)k * k, k, T, mo, W, k);
+            } else {
+                pard_dense_gemm_nn(k, nrhs, mo, P->U + (size_t)k * k, k, T, mo, W, k);
+            }
+        } else {
+            if (P->Lf != NULL) {
+                pard_dense_gemm_tn_float(k, nrhs, mo, P->Lf + k, P->m, T, mo, W, k);
+            } else {
+                pard_dense_gemm_tn(k, nrhs, mo, P->L + k, P->m, T, mo, W, k);
+            }
+        }
+    }
+
+    if (use_u) {
+        if (P->Uf != NULL) {
+            pard_dense_trsm_upper_float(k, nrhs, P->Uf, k, W, k);
+        } else {
+            pard_dense_trsm_upper(k, nrhs, P->U, k, W, k);
+        }
+    } else {
+        if (P->Lf != NULL) {
+            pard_dense_trsm_lower_trans_float(k, nrhs, P->Lf, P->m, W, k, !ctx->is_chol);
+        } else {
+            pard_dense_trsm_lower_trans(k, nrhs, P->L, P->m, W, k, !ctx->is_chol);
+        }
+    }
+
+    supernodal_scatter(W, k, nrhs, xidx, ctx->X);
+}
+
+/**
+ * 取第s个面板。外存因子的数值从预取序列中依次取出，
+ * 调用顺序必须与pard_ooc_stream_begin给出的序列一致，用完以supernodal_panel_put归还
+ */
+static int supernodal_panel_get(const pard_factors_t *factors, int s, pard_panel_t *P) {
+    *P = factors->panels[s];
+    if (factors->ooc == NULL) {
+        return PARD_SUCCESS;
+    }
+    return pard_ooc_stream_next(factors->ooc, &P->L, &P->U);
+}
+
+static void supernodal_panel_put(const pard_factors_t *factors) {
+    if (factors->ooc != NULL) {
+        pard_ooc_stream_release(factors->ooc);
+    }
+}
+
+/* 子树并行阶段：各线程按编号顺序前代自己的面板 */
+static void *supernodal_forward_worker(void *arg) {
+    supernodal_worker_t *w = (supernodal_worker_t *)arg;
+    const pard_factors_t *factors = w->ctx->factors;
+    for (int s = 0; s < factors->npanels && w->err == PARD_SUCCESS; s++) {
+        if (factors->panel_owner[s] == w->tid) {
+            w->err = supernodal_forward_panel(w->ctx, &factors->panels[s], w->W, w->T,
+                                              w->ctx->transpose ? factors->top_col_index :
+                                              factors->top_row_index, w->topbuf);
+        }
+    }
+    return NULL;
+}
+
+/* 子树并行阶段：各线程按编号逆序回代自己的面板（顶层面板已完成） */
+static void *supernodal_backward_worker(void *arg) {
+    supernodal_worker_t *w = (supernodal_worker_t *)arg;
+    const pard_factors_t *factors = w->ctx->factors;
+    for (int s = factors->npanels - 1; s >= 0; s--) {
+        if (factors->panel_owner[s] == w->tid) {
+            supernodal_backward_panel(w->ctx, &factors->panels[s], w->W, w->T);
+        }
+    }
+    return NULL;
+}
+
+/* 启动nthreads个线程（线程0为调用线程）执行fn，线程创建失败时由调用线程补做 */
+static void supernodal_run(supernodal_worker_t *workers, int nthreads, void *(*fn)(void *)) {
+    pthread_t tids[PARD_SOLVE_MAX_THREADS];
+    int started[PARD_SOLVE_MAX_THREADS];
+    for (int t = 1; t < nthreads; t++) {
+        started[t] = (pthread_create(&tids[t], NULL, fn, &workers[t]) == 0);
+    }
+    fn(&workers[0]);
+    for (int t = 1; t < nthreads; t++) {
+        if (started[t]) {
+            pthread_join(tids[t], NULL);
+        } else {
+            fn(&workers[t]);
+        }
+    }
+}
+
+/**
+ * 建立并行求解的调度（数值分解后调用一次，线程数改变时重建）
+ * 面板树即超节点消元树。以m*k估计面板的求解代价，从根开始反复拆开代价最大的子树，
+ * 直到最大子树不超过总量的1/(2*nthreads)；被拆开的面板为顶层面板，
+ * 剩余子树按代价从大到小分给当前负载最小的线程。
+ * 不同子树的面板只更新各自子树内或顶层面板的行，因此子树之间无需同步
+ */
+int pard_solve_schedule(pard_factors_t *factors, int nthreads) {
+    if (factors == NULL || factors->panels == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    if (nthreads > PARD_SOLVE_MAX_THREADS) {
+        nthreads = PARD_SOLVE_MAX_THREADS;
+    }
+
+    free(factors->panel_owner);
+    free(factors->top_row_index);
+    free(factors->top_col_index);
+    factors->panel_owner = NULL;
+    factors->top_row_index = NULL;
+    factors->top_col_index = NULL;
+    factors->ntop_rows = 0;
+    factors->sched_nthreads = nthreads;
+    if (nthreads <= 1) {
+        return PARD_SUCCESS;
+    }
+
+    int n = factors->n;
+    int np = factors->npanels;
+    const pard_panel_t *panels = factors->panels;
+    int *owner = (int *)malloc((np > 0 ? np : 1) * sizeof(int));
+    int *top_index = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int is_lu = (factors->col_panel != NULL);
+    int *top_col = is_lu ? (int *)malloc((n > 0 ? n : 1) * sizeof(int)) : NULL;
+    int *cand = (int *)malloc((np > 0 ? np : 1) * sizeof(int));
+    double *work = (double *)malloc((np > 0 ? np : 1) * sizeof(double));
+    double *load = (double *)calloc(nthreads, sizeof(double));
+    if (owner == NULL || top_index == NULL || cand == NULL || work == NULL || load == NULL ||
+        (is_lu && top_col == NULL)) {
+        free(owner);
+        free(top_index);
+        free(top_col);
+        free(cand);
+        free(work);
+        free(load);
+        factors->sched_nthreads = 0;
+        return PARD_ERROR_MEMORY;
+    }
+
+    /* 子树代价；面板编号即后序，子节点编号小于父节点 */
+    double total = 0.0;
+    int ncand = 0;
+    for (int s = 0; s < np; s++) {
+        work[s] = (double)panels[s].m * panels[s].k + 1.0;
+        owner[s] = -2;
+    }
+    for (int s = 0; s < np; s++) {
+        if (panels[s].parent != -1) {
+            work[panels[s].parent] += work[s];
+        } else {
+            total += work[s];
+            cand[ncand++] = s;
+        }
+    }
+
+    /* owner[s] = -1 标记顶层面板 */
+    double limit = total / (2.0 * nthreads);
+    while (ncand > 0) {
+        int best = 0;
+        for (int a = 1; a < ncand; a++) {
+            if (work[cand[a]] > work[cand[best]]) {
+                best = a;
+            }
+        }
+        int x = cand[best];
+        if (work[x] <= limit) {
+            break;
+        }
+        owner[x] = -1;
+        cand[best] = cand[--ncand];
+        for (int c = 0; c < x; c++) {
+            if (panels[c].parent == x) {
+                cand[ncand++] = c;
+            }
+        }
+    }
+
+    /* 子树按代价从大到小分配给负载最小的线程 */
+    for (int a = 1; a < ncand; a++) {
+        int v = cand[a];
+        int b = a - 1;
+        while (b >= 0 && work[cand[b]] < work[v]) {
+            cand[b + 1] = cand[b];
+            b--;
+        }
+        cand[b + 1] = v;
+    }
+    for (int a = 0; a < ncand; a++) {
+        int t = 0;
+        for (int u = 1; u < nthreads; u++) {
+            if (load[u] < load[t]) {
+                t = u;
+            }
+        }
+        owner[cand[a]] = t;
+        load[t] += work[cand[a]];
+    }
+    for (int s = np - 1; s >= 0; s--) {
+        if (owner[s] == -2) {
+            owner[s] = owner[panels[s].parent];
+        }
+    }
+
+    /* 顶层面板的主元按行号、列号（LU转置求解）两种方式编号，同一主元编号相同 */
+    int ntop = 0;
+    for (int i = 0; i < n; i++) {
+        top_index[i] = -1;
+        if (top_col != NULL) {
+            top_col[i] = -1;
+        }
+    }
+    for (int s = 0; s < np; s++) {
+        if (owner[s] == -1) {
+            for (int t = 0; t < panels[s].k; t++) {
+                if (top_col != NULL) {
+                    top_col[panels[s].cols[t]] = ntop;
+                }
+                top_index[panels[s].rows[t]] = ntop++;
+            }
+        }
+    }
+
+    free(cand);
+    free(work);
+    free(load);
+    factors->panel_owner = owner;
+    factors->top_row_index = top_index;
+    factors->top_col_index = top_col;
+    factors->ntop_rows = ntop;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 超节点分块求解：A*X = B（transpose非零且为LU分解时求解A^T*X = B），
+ * X、B为n×nrhs列主序，行列号为重排后矩阵的编号
+ * 直接在数值分解保存的面板上工作，所有右端项一起处理：
+ * 前代按超节点顺序，主元块做三角求解（TRSM），面板下方行做矩阵乘更新（GEMM）；
+ * 回代按逆序，先用已求出的非主元列做矩阵乘，再解主元块。
+ * 面板中的主元行/列已包含数值主元交换，因此不需要额外的置换。
+ * 有并行调度时，前代先由各线程并行处理各自的子树，归约对顶层行的更新后再顺序处理顶层面板；
+ * 回代先顺序处理顶层面板，再并行处理各子树。
+ * 转置求解复用同一组面板：A^T = U^T*L^T，前代U^T按列号进行，回代L^T按行号进行。
+ * 外存因子顺序求解，面板数值由预取线程按前代、回代的遍历顺序提前读回，用完即释放。
+ * work为调用者提供的工作区（至少pard_supernodal_solve_work_size个double），为NULL时临时分配
+ */
+int pard_supernodal_solve(const pard_factors_t *factors, int nrhs,
+                          const double *rhs, double *sol, int transpose, double *work) {
+    if (factors == NULL || factors->panels == NULL || rhs == NULL || sol == NULL ||
+        nrhs <= 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    int n = factors->n;
+    int np = factors->npanels;
+    supernodal_ctx_t ctx;
+    ctx.factors = factors;
+    ctx.nrhs = nrhs;
+    ctx.is_chol = (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF);
+    ctx.is_ldlt = (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF);
+    ctx.is_lu = !ctx.is_chol && !ctx.is_ldlt;
+    ctx.transpose = ctx.is_lu && transpose;
+    const int *top_index = ctx.transpose ? factors->top_col_index : factors->top_row_index;
+
+    int max_m = 0;
+    double nnz = 0.0;
+    for (int s = 0; s < np; s++) {
+        if (factors->panels[s].m > max_m) {
+            max_m = factors->panels[s].m;
+        }
+        nnz += (double)factors->panels[s].m * factors->panels[s].k;
+    }
+
+    /* 运算量太小时线程开销得不偿失；外存因子按单一序列读回，顺序求解 */
+    int nthreads = 1;
+    if (factors->panel_owner != NULL && factors->ooc == NULL &&
+        nnz * nrhs >= PARD_SOLVE_MT_MIN_WORK) {
+        nthreads = factors->sched_nthreads;
+    }
+
+    /* 内部按行存放右端项（第i行的nrhs个值连续），面板按行号收集/分发时访存连续。
+     * 对称情形前代、回代都在Y上原地进行；LU的前代结果按行编号，回代结果按列编号，另用X存放 */
+    supernodal_worker_t workers[PARD_SOLVE_MAX_THREADS];
+    size_t vsize = (size_t)n * nrhs + 1;
+    size_t wsize = (size_t)max_m * nrhs + 1;
+    size_t tsize = (nthreads > 1) ? (size_t)factors->ntop_rows * nrhs + 1 : 1;
+    double *buf = work;
+    if (buf == NULL) {
+        buf = (double *)malloc(((ctx.is_lu ? 2 : 1) * vsize +
+                                (size_t)nthreads * (2 * wsize + tsize)) * sizeof(double));
+        if (buf == NULL) {
+            return PARD_ERROR_MEMORY;
+        }
+    }
+    ctx.Y = buf;
+    ctx.X = ctx.is_lu ? buf + vsize : ctx.Y;
+    double *wbuf = buf + (ctx.is_lu ? 2 : 1) * vsize;
+    for (int t = 0; t < nthreads; t++) {
+        double *base = wbuf + (size_t)t * (2 * wsize + tsize);
+        workers[t].ctx = &ctx;
+        workers[t].tid = t;
+        workers[t].W = base;
+        workers[t].T = base + wsize;
+        workers[t].topbuf = base + 2 * wsize;
+        workers[t].err = PARD_SUCCESS;
+        memset(workers[t].topbuf, 0, tsize * sizeof(double));
+    }
+    for (int r = 0; r < nrhs; r++) {
+        const double *b = rhs + (size_t)r * n;
+        for (int i = 0; i < n; i++) {
+            ctx.Y[(size_t)i * nrhs + r] = b[i];
+        }
+    }
+
+    /* 外存因子：前代按面板编号、回代按逆序，整个遍历序列交给预取线程提前读入 */
+    int err = PARD_SUCCESS;
+    if (factors->ooc != NULL) {
+        int *order = (int *)malloc((2 * (size_t)np + 1) * sizeof(int));
+        if (order == NULL) {
+            err = PARD_ERROR_MEMORY;
+        } else {
+            for (int s = 0; s < np; s++) {
+                order[s] = s;
+                order[2 * np - 1 - s] = s;
+            }
+            err = pard_ooc_stream_begin(factors->ooc, order, 2 * np);
+            free(order);
+        }
+    }
+
+    /* 前代：L*Y = B（LDL^T另解D；转置求解为U^T*Y = B） */
+    if (nthreads > 1) {
+        supernodal_run(workers, nthreads, supernodal_forward_worker);
+        for (int t = 0; t < nthreads; t++) {
+            if (workers[t].err != PARD_SUCCESS) {
+                err = workers[t].err;
+            }
+        }
+        /* 归约各线程对顶层行的更新 */
+        for (int i = 0; i < n && err == PARD_SUCCESS; i++) {
+            int ti = top_index[i];
+            if (ti < 0) {
+                continue;
+            }
+            double *y = ctx.Y + (size_t)i * nrhs;
+            for (int t = 0; t < nthreads; t++) {
+                const double *u = workers[t].topbuf + (size_t)ti * nrhs;
+                for (int r = 0; r < nrhs; r++) {
+                    y[r] += u[r];
+                }
+            }
+        }
+    }
+    for (int s = 0; s < np && err == PARD_SUCCESS; s++) {
+        if (nthreads == 1 || factors->panel_owner[s] == -1) {
+            pard_panel_t P;
+            err = supernodal_panel_get(factors, s, &P);
+            if (err == PARD_SUCCESS) {
+                err = supernodal_forward_panel(&ctx, &P, workers[0].W, workers[0].T, NULL, NULL);
+            }
+            supernodal_panel_put(factors);
+        }
+    }
+
+    /* 回代：U*X = Y（对称情形与转置求解为L^T） */
+    for (int s = np - 1; s >= 0 && err == PARD_SUCCESS; s--) {
+        if (nthreads == 1 || factors->panel_owner[s] == -1) {
+            pard_panel_t P;
+            err = supernodal_panel_get(factors, s, &P);
+            if (err == PARD_SUCCESS) {
+                supernodal_backward_panel(&ctx, &P, workers[0].W, workers[0].T);
+            }
+            supernodal_panel_put(factors);
+        }
+    }
+    if (factors->ooc != NULL) {
+        pard_ooc_stream_end(factors->ooc);
+    }
+    if (nthreads > 1 && err == PARD_SUCCESS) {
+        supernodal_run(workers, nthreads, supernodal_backward_worker);
+    }
+
+    if (err == PARD_SUCCESS) {
+        for (int r = 0; r < nrhs; r++) {
+            double *x = sol + (size_t)r * n;
+            for (int i = 0; i < n; i++) {
+                x[i] = ctx.X[(size_t)i * nrhs + r];
+            }
+        }
+    }
+
+    if (work == NULL) {
+        free(buf);
+    }
+    return err;
+}
+
+/**
+ * 按主元顺序的单独前代或回代（pard_forward_substitution等的实现），逐个面板顺序处理：
+ * in、out为n×nrhs列主序，第t行对应第t个主元，即重排后矩阵的第factors->perm[t]行
+ * （LU回代的解对应第factors->col_perm[t]列）。
+ * backward为0时求解L*y = b：LU与LDL^T的L为单位下三角（LDL^T不含D），Cholesky为面板中的因子L；
+ * 非0时求解U*x = y：LU为面板中的U，LDL^T为D*L^T，Cholesky为L^T。
+ * 外存因子的面板按处理顺序读回
+ */
+int pard_supernodal_substitute(const pard_factors_t *factors, int nrhs,
+                               const double *in, double *out, int backward) {
+    if (factors == NULL || factors->panels == NULL || factors->perm == NULL ||
+        in == NULL || out == NULL || nrhs <= 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    int n = factors->n;
+    int np = factors->npanels;
+    supernodal_ctx_t ctx;
+    ctx.factors = factors;
+    ctx.nrhs = nrhs;
+    ctx.is_chol = (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF);
+    ctx.is_lu = (factors->col_perm != NULL);
+    ctx.is_ldlt = 0;    /* D只在回代中单独求解 */
+    ctx.transpose = 0;
+    int is_ldlt = !ctx.is_chol && !ctx.is_lu;
+    const int *xperm = (backward && ctx.is_lu) ? factors->col_perm : factors->perm;
+
+    int max_m = 0;
+    for (int s = 0; s < np; s++) {
+        if (factors->panels[s].m > max_m) {
+            max_m = factors->panels[s].m;
+        }
+    }
+    size_t vsize = (size_t)n * nrhs + 1;
+    size_t wsize = (size_t)max_m * nrhs + 1;
+    double *buf = (double *)malloc((2 * vsize + 2 * wsize) * sizeof(double));
+    int *order = (int *)malloc((np > 0 ? np : 1) * sizeof(int));
+    if (buf == NULL || order == NULL) {
+        free(buf);
+        free(order);
+        return PARD_ERROR_MEMORY;
+    }
+    ctx.Y = buf;
+    ctx.X = ctx.is_lu ? buf + vsize : ctx.Y;
+    double *W = buf + 2 * vsize;
+    double *T = W + wsize;
+
+    for (int r = 0; r < nrhs; r++) {
+        for (int t = 0; t < n; t++) {
+            ctx.Y[(size_t)factors->perm[t] * nrhs + r] = in[t + (size_t)r * n];
+        }
+    }
+
+    int err = PARD_SUCCESS;
+    for (int a = 0; a < np; a++) {
+        order[a] = backward ? np - 1 - a : a;
+    }
+    if (factors->ooc != NULL) {
+        err = pard_ooc_stream_begin(factors->ooc, order, np);
+    }
+
+    /* LDL^T回代先解D（块对角，D保存在内存中的面板上） */
+    for (int s = 0; backward && is_ldlt && s < np && err == PARD_SUCCESS; s++) {
+        const pard_panel_t *P = &factors->panels[s];
+        supernodal_gather(ctx.Y, nrhs, P->rows, P->k, W);
+        err = supernodal_solve_d(P, nrhs, W);
+        supernodal_scatter(W, P->k, nrhs, P->rows, ctx.Y);
+    }
+    for (int a = 0; a < np && err == PARD_SUCCESS; a++) {
+        pard_panel_t P;
+        err = supernodal_panel_get(factors, order[a], &P);
+        if (err == PARD_SUCCESS) {
+            if (backward) {
+                supernodal_backward_panel(&ctx, &P, W, T);
+            } else {
+                err = supernodal_forward_panel(&ctx, &P, W, T, NULL, NULL);
+            }
+        }
+        supernodal_panel_put(factors);
+    }
+    if (factors->ooc != NULL) {
+        pard_ooc_stream_end(factors->ooc);
+    }
+
+    if (err == PARD_SUCCESS) {
+        const double *V = backward ? ctx.X : ctx.Y;
+        for (int r = 0; r < nrhs; r++) {
+            for (int t = 0; t < n; t++) {
+                out[t + (size_t)r * n] = V[(size_t)xperm[t] * nrhs + r];
+            }
+        }
+    }
+
+    free(buf);
+    free(order);
+    return err;
+}
+
+/**
+ * pard_supernodal_solve对nrhs个右端项所需的工作区大小（double个数），
+ * 按分解时的并行调度线程数计算，对实际使用的线程数是上界
+ */
+size_t pard_supernodal_solve_work_size(const pard_factors_t *factors, int nrhs) {
+    if (factors == NULL || factors->panels == NULL || nrhs <= 0) {
+        return 0;
+    }
+    int max_m = 0;
+    for (int s = 0; s < factors->npanels; s++) {
+        if (factors->panels[s].m > max_m) {
+            max_m = factors->panels[s].m;
+        }
+    }
+    int is_lu = (factors->matrix_type != PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF &&
+                 factors->matrix_type != PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF);
+    int nthreads = (factors->panel_owner != NULL) ? factors->sched_nthreads : 1;
+    size_t vsize = (size_t)factors->n * nrhs + 1;
+    size_t wsize = (size_t)max_m * nrhs + 1;
+    size_t tsize = (nthreads > 1) ? (size_t)factors->ntop_rows * nrhs + 1 : 1;
+    return (is_lu ? 2 : 1) * vsize + (size_t)nthreads * (2 * wsize + tsize);
+}
+
+/**
+ * 面板消元树上的可达集（Gilbert-Peierls）：从start[0..nstart)所在的面板沿父链上行，
+ * 遇到已标记的面板即停止。结果写入stack[top..np)，按拓扑序排列（子面板在祖先之前），返回top。
+ * mark为长度np的标记数组，调用后被标记的面板mark为1
+ */
+static int supernodal_reach(const pard_factors_t *factors, const int *panel_of,
+                            int nstart, const int *start, int *mark, int *stack) {
+    int np = factors->npanels;
+    int top = np;
+    for (int a = 0; a < nstart; a++) {
+        int len = 0;
+        for (int s = panel_of[start[a]]; s != -1 && !mark[s]; s = factors->panels[s].parent) {
+            stack[len++] = s;
+            mark[s] = 1;
+        }
+        /* 路径已在stack[0..len)，倒着移到栈顶 */
+        while (len > 0) {
+            stack[--top] = stack[--len];
+        }
+    }
+    return top;
+}
+
+/**
+ * pard_supernodal_solve_sparse的double工作区大小：前代结果Y（LU另有回代结果X）与面板块，
+ * 不超过单个右端项的pard_supernodal_solve_work_size
+ */
+size_t pard_supernodal_sparse_work_size(const pard_factors_t *factors) {
+    if (factors == NULL || factors->panels == NULL) {
+        return 0;
+    }
+    int max_m = 0;
+    for (int s = 0; s < factors->npanels; s++) {
+        if (factors->panels[s].m > max_m) {
+            max_m = factors->panels[s].m;
+        }
+    }
+    int is_lu = (factors->matrix_type != PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF &&
+                 factors->matrix_type != PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF);
+    return (is_lu ? 2 : 1) * ((size_t)factors->n + 1) + 2 * (size_t)max_m + 2;
+}
+
+/**
+ * pard_supernodal_solve_sparse的int工作区大小：前代、回代的面板标记与可达集栈，外存模式的读回顺序
+ */
+size_t pard_supernodal_sparse_iwork_size(const pard_factors_t *factors) {
+    if (factors == NULL || factors->panels == NULL) {
+        return 0;
+    }
+    return 6 * (size_t)factors->npanels + 1;
+}
+
+/**
+ * 稀疏右端项、部分解的超节点求解：A*x = b，b只有rhs_nnz个非零元，只需要x的out_idx各分量
+ * 前代只处理从b的非零行在面板消元树上可达的面板（其余面板的前代结果恒为零），
+ * 回代只处理out_idx所在面板及其祖先（这些面板的主元列覆盖回代所需的全部非主元列）。
+ * out_idx为NULL时回代全部面板，out_val为长度n的完整解。行列号为重排后矩阵的编号。
+ * work（pard_supernodal_sparse_work_size个double）与iwork（pard_supernodal_sparse_iwork_size个int）
+ * 为NULL时临时分配；iwork的前2*npanels个元素为面板标记，调用前后都为0。
+ * 只清零、复位可达面板涉及的元素，代价与可达面板的大小成正比，而不是O(n)
+ */
+int pard_supernodal_solve_sparse(const pard_factors_t *factors,
+                                 int rhs_nnz, const int *rhs_idx, const double *rhs_val,
+                                 int nout, const int *out_idx, double *out_val,
+                                 double *work, int *iwork) {
+    if (factors == NULL || factors->panels == NULL || factors->row_panel == NULL ||
+        rhs_nnz < 0 || (rhs_nnz > 0 && (rhs_idx == NULL || rhs_val == NULL)) ||
+        out_val == NULL || (out_idx != NULL && nout < 0)) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    int n = factors->n;
+    int np = factors->npanels;
+    for (int a = 0; a < rhs_nnz; a++) {
+        if (rhs_idx[a] < 0 || rhs_idx[a] >= n) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+    for (int a = 0; out_idx != NULL && a < nout; a++) {
+        if (out_idx[a] < 0 || out_idx[a] >= n) {
+            return PARD_ERROR_INVALID_INPUT;
+        }
+    }
+
+    supernodal_ctx_t ctx;
+    ctx.factors = factors;
+    ctx.nrhs = 1;
+    ctx.is_chol = (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF);
+    ctx.is_ldlt = (factors->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF);
+    ctx.is_lu = !ctx.is_chol && !ctx.is_ldlt;
+    ctx.transpose = 0;
+    const int *col_panel = ctx.is_lu ? factors->col_panel : factors->row_panel;
+    if (col_panel == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    double *buf = work;
+    int *ibuf = iwork;
+    if (buf == NULL) {
+        buf = (double *)malloc(pard_supernodal_sparse_work_size(factors) * sizeof(double));
+    }
+    if (ibuf == NULL) {
+        ibuf = (int *)calloc(pard_supernodal_sparse_iwork_size(factors), sizeof(int));
+    }
+    if (buf == NULL || ibuf == NULL) {
+        if (buf != work) {
+            free(buf);
+        }
+        if (ibuf != iwork) {
+            free(ibuf);
+        }
+        return PARD_ERROR_MEMORY;
+    }
+    int *mark = ibuf;
+    int *fstack = ibuf + 2 * (size_t)np;
+    int *bstack = fstack + np;
+    int *order = bstack + np;
+
+    int ftop = supernodal_reach(factors, factors->row_panel, rhs_nnz, rhs_idx, mark, fstack);
+    int btop = 0;
+    if (out_idx != NULL) {
+        btop = supernodal_reach(factors, col_panel, nout, out_idx, mark + np, bstack);
+    } else {
+        for (int s = 0; s < np; s++) {
+            bstack[s] = s;
+        }
+    }
+
+    /* Y只在可达面板的行上读写：前代面板的全部行（其余行属于同在可达集中的祖先）与回代面板的主元行，
+     * 先清零这些行，其余行的前代结果按定义为零、不会被读到。X只在回代面板的列上读写，
+     * 回代面板的非主元列是先处理的祖先的主元列，读之前已写入，不需要清零 */
+    int max_m = 0;
+    ctx.Y = buf;
+    ctx.X = ctx.is_lu ? buf + n + 1 : ctx.Y;
+    for (int a = ftop; a < np; a++) {
+        const pard_panel_t *P = &factors->panels[fstack[a]];
+        for (int t = 0; t < P->m; t++) {
+            ctx.Y[P->rows[t]] = 0.0;
+        }
+        if (P->m > max_m) {
+            max_m = P->m;
+        }
+    }
+    for (int a = btop; a < np; a++) {
+        const pard_panel_t *P = &factors->panels[bstack[a]];
+        for (int t = 0; t < P->k; t++) {
+            ctx.Y[P->rows[t]] = 0.0;
+        }
+        if (P->m > max_m) {
+            max_m = P->m;
+        }
+    }
+    double *W = buf + (ctx.is_lu ? 2 : 1) * ((size_t)n + 1);
+    int err = PARD_SUCCESS;
+
+    for (int a = 0; a < rhs_nnz; a++) {
+        ctx.Y[rhs_idx[a]] += rhs_val[a];
+    }
+
+    /* 外存因子只读回可达的面板：前代序列之后接回代序列的逆序 */
+    if (factors->ooc != NULL) {
+        int nf = np - ftop;
+        int nb = np - btop;
+        memcpy(order, fstack + ftop, nf * sizeof(int));
+        for (int a = 0; a < nb; a++) {
+            order[nf + a] = bstack[np - 1 - a];
+        }
+        err = pard_ooc_stream_begin(factors->ooc, order, nf + nb);
+    }
+
+    /* 前代按拓扑序（子面板先于祖先） */
+    for (int a = ftop; a < np && err == PARD_SUCCESS; a++) {
+        pard_panel_t P;
+        err = supernodal_panel_get(factors, fstack[a], &P);
+        if (err == PARD_SUCCESS) {
+            err = supernodal_forward_panel(&ctx, &P, W, W + max_m + 1, NULL, NULL);
+        }
+        supernodal_panel_put(factors);
+    }
+
+    /* 回代按逆拓扑序 */
+    for (int a = np - 1; a >= btop && err == PARD_SUCCESS; a--) {
+        pard_panel_t P;
+        err = supernodal_panel_get(factors, bstack[a], &P);
+        if (err == PARD_SUCCESS) {
+            supernodal_backward_panel(&ctx, &P, W, W + max_m + 1);
+        }
+        supernodal_panel_put(factors);
+    }
+    if (factors->ooc != NULL) {
+        pard_ooc_stream_end(factors->ooc);
+    }
+
+    if (err == PARD_SUCCESS) {
+        if (out_idx != NULL) {
+            for (int a = 0; a < nout; a++) {
+                out_val[a] = ctx.X[out_idx[a]];
+            }
+        } else {
+            memcpy(out_val, ctx.X, (size_t)n * sizeof(double));
+        }
+    }
+
+    /* 复位本次标记过的面板，工作区留给下一次求解 */
+    for (int a = ftop; a < np; a++) {
+        mark[fstack[a]] = 0;
+    }
+    for (int a = btop; out_idx != NULL && a < np; a++) {
+        mark[np + bstack[a]] = 0;
+    }
+    if (buf != work) {
+        free(buf);
+    }
+    if (ibuf != iwork) {
+        free(ibuf);
+    }
+    return err;
+}
@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* 前向声明 */
+extern int pard_build_symmetric_graph(const pard_csr_matrix_t *matrix, int **xadj, int **adj);
+
 /**
  * 消元树节点结构
  */
@@ -14,103 +17,284 @@ typedef struct et_node {
     int num_descendants;
 } elimination_tree_node_t;
 
+/**
+ * 构建矩阵的列压缩（CSC）模式：第j列的行号存放在idx[ptr[j]..ptr[j+1])
+ */
+static int etree_column_pattern(const pard_csr_matrix_t *matrix, int **ptr_out, int **idx_out) {
+    int n = matrix->n;
+    int nnz = matrix->row_ptr[n];
+    int *ptr = (int *)calloc(n + 1, sizeof(int));
+    int *idx = (int *)malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+    int *pos = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (ptr == NULL || idx == NULL || pos == NULL) {
+        free(ptr);
+        free(idx);
+        free(pos);
+        return PARD_ERROR_MEMORY;
+    }
+
+    for (int p = 0; p < nnz; p++) {
+        ptr[matrix->col_idx[p] + 1]++;
+    }
+    for (int j = 0; j < n; j++) {
+        ptr[j + 1] += ptr[j];
+    }
+    memcpy(pos, ptr, n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        for (int p = matrix->row_ptr[i]; p < matrix->row_ptr[i + 1]; p++) {
+            idx[pos[matrix->col_idx[p]]++] = i;
+        }
+    }
+
+    free(pos);
+    *ptr_out = ptr;
+    *idx_out = idx;
+    return PARD_SUCCESS;
+}
+
+/**
+ * 计算消元树（Liu算法，祖先数组路径压缩，近似O(nnz)）
+ * PARD_ETREE_SYMMETRIC：A+A^T 的消元树，即Cholesky因子L的列结构树；
+ *   对称矩阵只存一半三角或完整存储均可
+ * PARD_ETREE_ATA：A^T*A 的消元树（A的列消元树），不显式形成A^T*A，
+ *   用于带部分主元的LU：任意行置换下U和L的结构都被其Cholesky因子包含
+ * parent[j]为j的父节点，根为-1，且总有parent[j] > j
+ */
+int pard_elimination_tree(const pard_csr_matrix_t *matrix, pard_etree_mode_t mode,
+                          int **parent) {
+    if (matrix == NULL || parent == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    int n = matrix->n;
+    int *ptr = NULL, *idx = NULL;
+    int err;
+    if (mode == PARD_ETREE_SYMMETRIC) {
+        err = pard_build_symmetric_graph(matrix, &ptr, &idx);
+    } else if (mode == PARD_ETREE_ATA) {
+        err = etree_column_pattern(matrix, &ptr, &idx);
+    } else {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+
+    *parent = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *ancestor = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    /* A^T*A情形：prev[i]为第i行中最近处理过的列 */
+    int *prev = (mode == PARD_ETREE_ATA) ?
+                (int *)malloc((n > 0 ? n : 1) * sizeof(int)) : NULL;
+    if (*parent == NULL || ancestor == NULL || (mode == PARD_ETREE_ATA && prev == NULL)) {
+        free(*parent);
+        *parent = NULL;
+        free(ancestor);
+        free(prev);
+        free(ptr);
+        free(idx);
+        return PARD_ERROR_MEMORY;
+    }
+
+    if (prev != NULL) {
+        for (int i = 0; i < n; i++) {
+            prev[i] = -1;
+        }
+    }
+
+    for (int k = 0; k < n; k++) {
+        (*parent)[k] = -1;
+        ancestor[k] = -1;
+        for (int p = ptr[k]; p < ptr[k + 1]; p++) {
+            int i = (prev != NULL) ? prev[idx[p]] : idx[p];
+            /* 从i沿祖先链上行到当前根，沿途把祖先压缩到k */
+            while (i != -1 && i < k) {
+                int next = ancestor[i];
+                ancestor[i] = k;
+                if (next == -1) {
+                    (*parent)[i] = k;
+                }
+                i = next;
+            }
+            if (prev != NULL) {
+                prev[idx[p]] = k;
+            }
+        }
+    }
+
+    free(ancestor);
+    free(prev);
+    free(ptr);
+    free(idx);
+    return PARD_SUCCESS;
+}
+
+/**
+ * 消元树（森林）的后序遍历：post[k]为第k个访问的节点
+ * 子节点按编号递增访问，非递归实现，O(n)
+ */
+int pard_etree_postorder(int n, const int *parent, int **post) {
+    if (parent == NULL || post == NULL || n < 0) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    *post = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *work = (int *)malloc((3 * (size_t)n + 1) * sizeof(int));
+    if (*post == NULL || work == NULL) {
+        free(*post);
+        *post = NULL;
+        free(work);
+        return PARD_ERROR_MEMORY;
+    }
+    int *head = work;
+    int *next = work + n;
+    int *stack = work + 2 * (size_t)n;
+
+    for (int j = 0; j < n; j++) {
+        head[j] = -1;
+    }
+    /* 逆序插入，使每个子节点链表按编号递增 */
+    for (int j = n - 1; j >= 0; j--) {
+        if (parent[j] != -1) {
+            next[j] = head[parent[j]];
+            head[parent[j]] = j;
+        }
+    }
+
+    int k = 0;
+    for (int j = 0; j < n; j++) {
+        if (parent[j] != -1) {
+            continue;
+        }
+        int top = 0;
+        stack[0] = j;
+        while (top >= 0) {
+            int p = stack[top];
+            int c = head[p];
+            if (c == -1) {
+                top--;
+                (*post)[k++] = p;
+            } else {
+                head[p] = next[c];
+                stack[++top] = c;
+            }
+        }
+    }
+
+    free(work);
+    return PARD_SUCCESS;
+}
+
 /**
  * 构建消元树
- * 消元树描述了LU分解过程中变量的消除顺序和依赖关系
+ * 消元树描述了分解过程中变量的消除顺序和依赖关系：parent[j]是L第j列中对角元以下
+ * 第一个非零元的行号。这里计算 A+A^T 的消元树（对称模式），
+ * 并以first_child/next_sibling链表给出子节点，兄弟按编号递增排列
  */
-int pard_build_elimination_tree(const pard_csr_matrix_t *matrix, 
+int pard_build_elimination_tree(const pard_csr_matrix_t *matrix,
                                 int **parent, int **first_child, int **next_sibling) {
     if (matrix == NULL || parent == NULL || first_child == NULL || next_sibling == NULL) {
         return PARD_ERROR_INVALID_INPUT;
     }
-    
+
     int n = matrix->n;
-    
-    *parent = (int *)malloc(n * sizeof(int));
-    *first_child = (int *)malloc(n * sizeof(int));
-    *next_sibling = (int *)malloc(n * sizeof(int));
-    
-    if (*parent == NULL || *first_child == NULL || *next_sibling == NULL) {
-        if (*parent != NULL) free(*parent);
-        if (*first_child != NULL) free(*first_child);
-        if (*next_sibling != NULL) free(*next_sibling);
+
+    int err = pard_elimination_tree(matrix, PARD_ETREE_SYMMETRIC, parent);
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+
+    *first_child = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    *next_sibling = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+
+    if (*first_child == NULL || *next_sibling == NULL) {
+        free(*parent);
+        free(*first_child);
+        free(*next_sibling);
+        *parent = NULL;
+        *first_child = NULL;
+        *next_sibling = NULL;
         return PARD_ERROR_MEMORY;
     }
-    
-    /* 初始化 */
+
     for (int i = 0; i < n; i++) {
-        (*parent)[i] = -1;
         (*first_child)[i] = -1;
         (*next_sibling)[i] = -1;
     }
-    
-    /* 对于每个节点i，找到其第一个非零列j（j > i） */
-    /* 在消元树中，j是i的父节点 */
-    for (int i = 0; i < n; i++) {
-        int first_nz_col = n;  /* 初始化为最大值 */
-        
-        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-            int col = matrix->col_idx[j];
-            if (col > i && col < first_nz_col) {
-                first_nz_col = col;
-            }
-        }
-        
-        if (first_nz_col < n) {
-            (*parent)[i] = first_nz_col;
-            
-            /* 将i添加到first_nz_col的子节点列表 */
-            if ((*first_child)[first_nz_col] == -1) {
-                (*first_child)[first_nz_col] = i;
-            } else {
-                /* 找到最后一个兄弟节点 */
-                int sibling = (*first_child)[first_nz_col];
-                while ((*next_sibling)[sibling] != -1) {
-                    sibling = (*next_sibling)[sibling];
-                }
-                (*next_sibling)[sibling] = i;
-            }
+
+    /* 逆序头插：每个节点O(1)，子节点链表按编号递增 */
+    for (int i = n - 1; i >= 0; i--) {
+        int p = (*parent)[i];
+        if (p != -1) {
+            (*next_sibling)[i] = (*first_child)[p];
+            (*first_child)[p] = i;
         }
     }
-    
+
     return PARD_SUCCESS;
 }
 
 /**
- * 计算消元树的深度
+ * 计算消元树的深度（根的深度为0，返回最大深度）
+ * 对任意森林有效：每个节点的深度只计算一次，沿父链上行到已知深度的节点后回填，O(n)
  */
 int elimination_tree_depth(int n, const int *parent) {
+    if (n <= 0 || parent == NULL) {
+        return 0;
+    }
+
+    int *depth = (int *)malloc(n * sizeof(int));
+    int *path = (int *)malloc(n * sizeof(int));
+    if (depth == NULL || path == NULL) {
+        free(depth);
+        free(path);
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        depth[i] = -1;
+    }
+
     int max_depth = 0;
-    
     for (int i = 0; i < n; i++) {
-        int depth = 0;
+        /* 上行收集深度未知的节点 */
+        int len = 0;
         int node = i;
-        while (node != -1 && parent[node] != -1) {
-            depth++;
+        while (node != -1 && depth[node] < 0) {
+            path[len++] = node;
             node = parent[node];
         }
-        if (depth > max_depth) {
-            max_depth = depth;
+        int d = (node == -1) ? -1 : depth[node];
+        while (len > 0) {
+            depth[path[--len]] = ++d;
+        }
+        if (depth[i] > max_depth) {
+            max_depth = depth[i];
         }
     }
-    
+
+    free(depth);
+    free(path);
     return max_depth;
 }
 
 /**
- * 获取节点的所有后代
+ * 获取节点的所有后代（按层次顺序），descendants用作队列，非递归
  */
 int get_descendants(int node, int n, const int *first_child, const int *next_sibling,
                     int *descendants, int *num_desc) {
-    *num_desc = 0;
-    
-    int child = first_child[node];
-    while (child != -1) {
-        descendants[(*num_desc)++] = child;
-        get_descendants(child, n, first_child, next_sibling, 
-                       descendants + *num_desc, num_desc);
-        child = next_sibling[child];
-    }
-    
+    (void)n;
+    int count = 0;
+
+    for (int child = first_child[node]; child != -1; child = next_sibling[child]) {
+        descendants[count++] = child;
+    }
+    for (int head = 0; head < count; head++) {
+        for (int child = first_child[descendants[head]]; child != -1;
+             child = next_sibling[child]) {
+            descendants[count++] = child;
+        }
+    }
+
+    *num_desc = count;
     return PARD_SUCCESS;
 }
@@ -0,0 +1,187 @@
+#include "pard.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* 合并后列数不超过该值时总是合并（显式零元的代价可以忽略） */
+#define PARD_SUPERNODE_ALWAYS_MERGE 4
+
+/**
+ * 沿合并链找到代表超节点（合并总是指向编号更大的超节点）
+ */
+static int supernode_find(int *rep, int s) {
+    int r = s;
+    while (rep[r] != r) {
+        r = rep[r];
+    }
+    while (rep[s] != r) {
+        int next = rep[s];
+        rep[s] = r;
+        s = next;
+    }
+    return r;
+}
+
+/**
+ * 超节点划分：基本超节点 + 松弛合并
+ * 输入为符号分解得到的因子结构（factors->u_row_ptr/u_col_idx的第j行即L的第j列）和消元树，
+ * 矩阵应已按消元树后序排列，使每个超节点的最后一个子节点与之列号相邻。
+ * 基本超节点：j与j-1合并当且仅当j是j-1的父节点、j只有一个子节点且两列结构相同。
+ * 松弛合并：自上而下检查每个超节点能否并入紧邻其后的父超节点，合并后列数不超过relax_max_cols，
+ * 且列数不超过PARD_SUPERNODE_ALWAYS_MERGE或显式零元占存储比例不超过relax_max_zeros。
+ * relax_max_cols <= 1 时只生成基本超节点。
+ * 超节点内各列的父节点都在超节点内部（最后一列除外），因此合并后的行结构就是最后一列的结构。
+ * 结果写入factors->nsuper/super_ptr/super_parent/super_row_ptr/super_row_idx
+ */
+int pard_supernode_partition(pard_factors_t *factors, const int *parent,
+                             int relax_max_cols, double relax_max_zeros) {
+    if (factors == NULL || parent == NULL || factors->u_row_ptr == NULL ||
+        factors->u_col_idx == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    int n = factors->n;
+    const int *cptr = factors->u_row_ptr;
+    const int *cidx = factors->u_col_idx;
+
+    int *nchild = (int *)calloc(n + 1, sizeof(int));
+    int *fptr = (int *)malloc((n + 1) * sizeof(int));
+    int *rep = (int *)malloc((n + 1) * sizeof(int));
+    int *ncols = (int *)malloc((n + 1) * sizeof(int));
+    double *nz = (double *)malloc((n + 1) * sizeof(double));
+    if (nchild == NULL || fptr == NULL || rep == NULL || ncols == NULL || nz == NULL) {
+        free(nchild);
+        free(fptr);
+        free(rep);
+        free(ncols);
+        free(nz);
+        return PARD_ERROR_MEMORY;
+    }
+
+    for (int j = 0; j < n; j++) {
+        if (parent[j] != -1) {
+            nchild[parent[j]]++;
+        }
+    }
+
+    /* 基本超节点 */
+    int nf = 0;
+    for (int j = 0; j < n; j++) {
+        if (j == 0 || parent[j - 1] != j || nchild[j] != 1 ||
+            cptr[j] - cptr[j - 1] != cptr[j + 1] - cptr[j] + 1) {
+            fptr[nf++] = j;
+        }
+    }
+    fptr[nf] = n;
+
+    for (int s = 0; s < nf; s++) {
+        rep[s] = s;
+        ncols[s] = fptr[s + 1] - fptr[s];
+        nz[s] = (double)(cptr[fptr[s + 1]] - cptr[fptr[s]]);
+    }
+
+    /* 松弛合并：s并入s+1所在的合并组，组的行结构为组内最后一列的结构 */
+    if (relax_max_cols > 1) {
+        for (int s = nf - 2; s >= 0; s--) {
+            int last = fptr[s + 1] - 1;
+            if (parent[last] == -1 || parent[last] != fptr[s + 1]) {
+                continue;
+            }
+            int r = supernode_find(rep, s + 1);
+            int c = ncols[s] + ncols[r];
+            if (c > relax_max_cols) {
+                continue;
+            }
+            int rlast = fptr[r + 1] - 1;
+            double below = (double)(cptr[rlast + 1] - cptr[rlast] - 1);
+            double stored = 0.5 * c * (c + 1.0) + c * below;
+            double total = nz[s] + nz[r];
+            if (c <= PARD_SUPERNODE_ALWAYS_MERGE || stored - total <= relax_max_zeros * stored) {
+                rep[s] = r;
+                ncols[r] = c;
+                nz[r] = total;
+            }
+        }
+    }
+
+    /* 合并组是连续的基本超节点区间[.., r]，组的结尾是代表超节点 */
+    int ns = 0;
+    for (int s = 0; s < nf; s++) {
+        if (rep[s] == s) {
+            ns++;
+        }
+    }
+
+    int *super_ptr = (int *)malloc((ns + 1) * sizeof(int));
+    int *super_parent = (int *)malloc((ns > 0 ? ns : 1) * sizeof(int));
+    int *super_row_ptr = (int *)malloc((ns + 1) * sizeof(int));
+    int *col_to_super = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (super_ptr == NULL || super_parent == NULL || super_row_ptr == NULL ||
+        col_to_super == NULL) {
+        free(nchild);
+        free(fptr);
+        free(rep);
+        free(ncols);
+        free(nz);
+        free(super_ptr);
+        free(super_parent);
+        free(super_row_ptr);
+        free(col_to_super);
+        return PARD_ERROR_MEMORY;
+    }
+
+    int k = 0;
+    super_ptr[0] = 0;
+    for (int s = 0; s < nf; s++) {
+        if (rep[s] == s) {
+            super_ptr[++k] = fptr[s + 1];
+        }
+    }
+
+    super_row_ptr[0] = 0;
+    for (int t = 0; t < ns; t++) {
+        int last = super_ptr[t + 1] - 1;
+        for (int j = super_ptr[t]; j <= last; j++) {
+            col_to_super[j] = t;
+        }
+        super_row_ptr[t + 1] = super_row_ptr[t] + (cptr[last + 1] - cptr[last] - 1);
+    }
+
+    int *super_row_idx = (int *)malloc((super_row_ptr[ns] > 0 ? super_row_ptr[ns] : 1) * sizeof(int));
+    if (super_row_idx == NULL) {
+        free(nchild);
+        free(fptr);
+        free(rep);
+        free(ncols);
+        free(nz);
+        free(super_ptr);
+        free(super_parent);
+        free(super_row_ptr);
+        free(col_to_super);
+        return PARD_ERROR_MEMORY;
+    }
+    for (int t = 0; t < ns; t++) {
+        int last = super_ptr[t + 1] - 1;
+        super_parent[t] = (parent[last] == -1) ? -1 : col_to_super[parent[last]];
+        /* 结构的第一个元素是对角元 */
+        memcpy(super_row_idx + super_row_ptr[t], cidx + cptr[last] + 1,
+               (super_row_ptr[t + 1] - super_row_ptr[t]) * sizeof(int));
+    }
+
+    free(factors->super_ptr);
+    free(factors->super_parent);
+    free(factors->super_row_ptr);
+    free(factors->super_row_idx);
+    factors->nsuper = ns;
+    factors->super_ptr = super_ptr;
+    factors->super_parent = super_parent;
+    factors->super_row_ptr = super_row_ptr;
+    factors->super_row_idx = super_row_idx;
+
+    free(nchild);
+    free(fptr);
+    free(rep);
+    free(ncols);
+    free(nz);
+    free(col_to_super);
+    return PARD_SUCCESS;
+}
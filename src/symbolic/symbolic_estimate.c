@@ -0,0 +1,138 @@
+#include "pard.h"
+#include <stdlib.h>
+#include <limits.h>
+
+/* 前向声明 */
+extern int pard_get_num_threads(const pard_solver_t *solver);
+
+/**
+ * 已完成面板中驻留内存的数值字节数：外存模式下等待写出的面板不超过内存上限（单个面板更大时为该面板）
+ */
+static double estimate_resident(const pard_solver_t *solver, double values, double largest) {
+    if (solver->ooc_dir == NULL) {
+        return values;
+    }
+    double bound = ((double)solver->ooc_memory_limit > largest) ?
+                   (double)solver->ooc_memory_limit : largest;
+    return (values < bound) ? values : bound;
+}
+
+/**
+ * 符号分析后的内存与运算量预测（不考虑数值主元推迟，推迟会使波前变大）
+ * 需要符号分解的因子结构（factors->u_row_ptr）与超节点划分，在数值分解之前调用。
+ * 写入solver的统计字段：
+ *   factor_nnz / fill_in_nnz：L（含对角）的精确非零元数，LU另加U（单位对角不重复计）；
+ *   factor_flops：多波前分解在各波前上的浮点运算数（松弛合并引入的显式零元也参与运算）；
+ *   solve_flops：每个右端项前代加回代的浮点运算数；
+ *   peak_memory：数值分解的峰值工作内存（字节），不含矩阵本身。
+ * 峰值按单线程的处理顺序（超节点编号即后序）模拟：已完成的面板、等待父节点的贡献块栈、
+ * 当前波前及其新生成的面板与贡献块。混合精度模式下面板在波前完成时即舍入为单精度，按单精度计入；
+ * 外存模式下面板数值只按内存上限计入。设置了CSR因子导出时，分解结束后全部面板与导出的CSR因子同时存在。
+ * 多线程的树并行阶段可能同时有多个波前，实际峰值会相应增加
+ */
+int pard_symbolic_estimate(pard_solver_t *solver) {
+    if (solver == NULL || solver->factors == NULL || solver->matrix == NULL ||
+        solver->factors->u_row_ptr == NULL || solver->factors->super_ptr == NULL) {
+        return PARD_ERROR_INVALID_INPUT;
+    }
+
+    const pard_factors_t *f = solver->factors;
+    int n = f->n;
+    int ns = f->nsuper;
+    int is_chol = (solver->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF);
+    int is_ldlt = (solver->matrix_type == PARD_MATRIX_TYPE_REAL_SYMMETRIC_INDEF);
+    int is_lu = !is_chol && !is_ldlt;
+    int ooc = (solver->ooc_dir != NULL);
+    int mixed = solver->mixed_precision && !ooc;
+    double di = (double)sizeof(int);
+    double dd = (double)sizeof(double);
+    double dp = mixed ? (double)sizeof(float) : dd;   /* 面板数值的元素字节数 */
+
+    double *pending = (double *)calloc(ns > 0 ? ns : 1, sizeof(double));
+    if (pending == NULL) {
+        return PARD_ERROR_MEMORY;
+    }
+
+    /* 精确非零元：U的第j行即L的第j列 */
+    long long nnz_l = f->u_row_ptr[n];
+    long long factor_nnz = is_lu ? 2 * nnz_l - n : nnz_l;
+
+    /* 分解期间一直存在的数组：符号分解的CSR结构（不含数值）、
+     * 多波前的超节点结构（行结构与按超节点归类的原矩阵元素）、各线程的行/列映射 */
+    double sum_rows = (double)f->super_row_ptr[ns];
+    double base = (2.0 * (n + 1) + 2.0 * nnz_l + n) * di;
+    base += (3.0 * n + 5.0 * (ns + 1) + sum_rows + 2.0 * solver->matrix->row_ptr[n]) * di;
+    base += (double)pard_get_num_threads(solver) * n * (is_lu ? 2 : 1) * di;
+
+    double flops = 0.0, solve = 0.0;
+    double values = 0.0;      /* 已完成面板的L、U数值 */
+    double meta = 0.0;        /* 已完成面板的索引、主元类型与D */
+    double largest = 0.0;     /* 最大的单个面板数值 */
+    double stack = 0.0;       /* 等待父节点组装的贡献块 */
+    double peak = 0.0;
+    double export_nnz = 0.0;  /* 导出的CSR因子L（及U）的元素数 */
+
+    for (int s = 0; s < ns; s++) {
+        int ncol = f->super_ptr[s + 1] - f->super_ptr[s];
+        double k = (double)ncol;
+        double r = (double)(f->super_row_ptr[s + 1] - f->super_row_ptr[s]);
+        double m = k + r;
+        int is_root = (f->super_parent[s] == -1);
+
+        /* 第t个主元消去时波前剩余c = m-t-1行：主元1次、列缩放c次，
+         * Schur补更新对称情形c(c+1)/2个元素、LU为c*c个元素，每个一次乘加 */
+        for (int t = 0; t < ncol; t++) {
+            double c = m - t - 1;
+            flops += 1.0 + c + (is_lu ? 2.0 * c * c : c * (c + 1.0));
+        }
+        /* 前代与回代各做一次主元块三角求解与下方行的矩阵乘，LDL^T另解D */
+        solve += 2.0 * (k * k + 2.0 * k * r) + (is_ldlt ? k : 0.0);
+        export_nnz += k * (k + 1.0) / 2.0 + k * r;
+
+        double front = m * m * dd;
+        double panel = m * k * dp * (is_lu ? 2 : 1);
+        double panel_meta = m * di * (is_lu ? 2 : 1) +
+                            (is_ldlt ? k * di + (2.0 * k + 1.0) * dd : 0.0);
+        double contrib = (r > 0 && !is_root) ? r * r * dd + r * di * (is_lu ? 2 : 1) : 0.0;
+        if (panel > largest) {
+            largest = panel;
+        }
+
+        /* 组装时：子节点的贡献块仍在栈中 */
+        double p = base + meta + estimate_resident(solver, values, largest) + stack + front;
+        if (p > peak) {
+            peak = p;
+        }
+
+        /* 组装后子节点的贡献块释放，波前仍在时复制出面板与新的贡献块 */
+        stack -= pending[s];
+        values += panel;
+        meta += panel_meta;
+        p = base + meta + estimate_resident(solver, values, largest) + stack + front + contrib;
+        if (p > peak) {
+            peak = p;
+        }
+        stack += contrib;
+        if (!is_root) {
+            pending[f->super_parent[s]] += contrib;
+        }
+    }
+    free(pending);
+
+    /* CSR因子导出：面板全部完成后新建L、U（LDL^T为L与D）的结构与数值，另有按主元位置的映射 */
+    if (solver->csr_factors) {
+        double csr = is_ldlt ? export_nnz * (di + dd) + 2.0 * n * (dd + 3.0 * di)
+                             : 2.0 * export_nnz * (di + dd) + 5.0 * (n + 1) * di;
+        double p = base + meta + estimate_resident(solver, values, largest) + csr;
+        if (p > peak) {
+            peak = p;
+        }
+    }
+
+    solver->factor_nnz = factor_nnz;
+    solver->fill_in_nnz = (factor_nnz > INT_MAX) ? INT_MAX : (int)factor_nnz;
+    solver->factor_flops = flops;
+    solver->solve_flops = solve;
+    solver->peak_memory = (size_t)peak;
+    return PARD_SUCCESS;
+}
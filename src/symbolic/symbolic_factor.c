@@ -2,189 +2,244 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* 前向声明 */
+extern int pard_build_symmetric_graph(const pard_csr_matrix_t *matrix, int **xadj, int **adj);
+extern int pard_etree_postorder(int n, const int *parent, int **post);
+
+/**
+ * 判断i是否为第j列行子树的叶子（Gilbert-Ng-Peyton）
+ * 返回值：*jleaf = 0 不是叶子；1 是第一个叶子；2 是后续叶子，此时返回上一叶子与j的最近公共祖先
+ * ancestor用于不相交集合的路径压缩，maxfirst/prevleaf记录第i行子树的访问状态
+ */
+static int symbolic_leaf(int i, int j, const int *first, int *maxfirst, int *prevleaf,
+                         int *ancestor, int *jleaf) {
+    *jleaf = 0;
+    if (i <= j || first[j] <= maxfirst[i]) {
+        return -1;
+    }
+    maxfirst[i] = first[j];
+    int jprev = prevleaf[i];
+    prevleaf[i] = j;
+    *jleaf = (jprev == -1) ? 1 : 2;
+    if (*jleaf == 1) {
+        return i;
+    }
+    int q;
+    for (q = jprev; q != ancestor[q]; q = ancestor[q]) {
+    }
+    for (int s = jprev; s != q; ) {
+        int sparent = ancestor[s];
+        ancestor[s] = q;
+        s = sparent;
+    }
+    return q;
+}
+
+/**
+ * L的列计数（含对角元），Gilbert-Ng-Peyton算法
+ * 基于骨架矩阵：只有行子树的叶子贡献+1，相邻叶子的最近公共祖先处-1，
+ * 再沿消元树自底向上累加差分。总代价O(nnz(A) * alpha(n))，与nnz(L)无关
+ * xadj/adj为 A+A^T 的邻接图，post为消元树后序
+ */
+static int symbolic_column_counts(int n, const int *xadj, const int *adj,
+                                  const int *parent, const int *post, int *colcount) {
+    int *work = (int *)malloc((4 * (size_t)n + 1) * sizeof(int));
+    if (work == NULL) {
+        return PARD_ERROR_MEMORY;
+    }
+    int *ancestor = work;
+    int *maxfirst = work + n;
+    int *prevleaf = work + 2 * (size_t)n;
+    int *first = work + 3 * (size_t)n;
+    int *delta = colcount;
+
+    for (int k = 0; k < n; k++) {
+        first[k] = -1;
+    }
+    /* first[j]：j的子树中后序最小的节点的后序号；叶子的delta初始为1 */
+    for (int k = 0; k < n; k++) {
+        int j = post[k];
+        delta[j] = (first[j] == -1) ? 1 : 0;
+        for (; j != -1 && first[j] == -1; j = parent[j]) {
+            first[j] = k;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        ancestor[i] = i;
+        maxfirst[i] = -1;
+        prevleaf[i] = -1;
+    }
+
+    for (int k = 0; k < n; k++) {
+        int j = post[k];
+        if (parent[j] != -1) {
+            delta[parent[j]]--;
+        }
+        /* 第j列下三角（i > j）的非零元，即A+A^T中j的编号更大的邻居 */
+        for (int p = xadj[j]; p < xadj[j + 1]; p++) {
+            int jleaf;
+            int q = symbolic_leaf(adj[p], j, first, maxfirst, prevleaf, ancestor, &jleaf);
+            if (jleaf >= 1) {
+                delta[j]++;
+            }
+            if (jleaf == 2) {
+                delta[q]--;
+            }
+        }
+        if (parent[j] != -1) {
+            ancestor[j] = parent[j];
+        }
+    }
+
+    /* 子节点的差分累加到父节点；parent[j] > j，按编号顺序即为自底向上 */
+    for (int j = 0; j < n; j++) {
+        if (parent[j] != -1) {
+            colcount[parent[j]] += colcount[j];
+        }
+    }
+
+    free(work);
+    return PARD_SUCCESS;
+}
+
 /**
  * 符号分解：确定L和U的非零结构
- * 返回L和U的CSR结构
+ * 基于 A+A^T 的消元树：先用Gilbert-Ng-Peyton算法求出L的精确列计数，
+ * 再按行子树生成完整的填充结构。L以CSR存储（每行含单位对角元，列号递增），
+ * U为L^T的结构（每行以对角元开头，列号递增）。只生成结构，因子数值由数值分解保存在超节点面板中。
+ * 非对称矩阵在不做主元交换时的L、U结构即为 A+A^T 的Cholesky结构；
+ * 数值分解中的主元推迟可能使实际因子超出该结构，面板按实际波前分配
  */
 int pard_symbolic_factorization(const pard_csr_matrix_t *matrix,
-                                 const int *parent, const int *first_child, 
+                                 const int *parent, const int *first_child,
                                  const int *next_sibling,
                                  pard_factors_t **factors) {
-    if (matrix == NULL || parent == NULL || first_child == NULL || 
+    if (matrix == NULL || parent == NULL || first_child == NULL ||
         next_sibling == NULL || factors == NULL) {
         return PARD_ERROR_INVALID_INPUT;
     }
-    
+
     int n = matrix->n;
-    
-    *factors = (pard_factors_t *)calloc(1, sizeof(pard_factors_t));
-    if (*factors == NULL) {
-        return PARD_ERROR_MEMORY;
+
+    int *xadj = NULL, *adj = NULL;
+    int err = pard_build_symmetric_graph(matrix, &xadj, &adj);
+    if (err != PARD_SUCCESS) {
+        return err;
     }
-    
-    (*factors)->n = n;
-    (*factors)->matrix_type = PARD_MATRIX_TYPE_REAL_NONSYMMETRIC;
-    
-    /* 使用符号Cholesky分解的思想来确定非零结构 */
-    /* 对于非对称矩阵，需要分别计算L和U的结构 */
-    
-    /* 计算L的结构（下三角） */
+
+    int *post = NULL;
+    err = pard_etree_postorder(n, parent, &post);
+    if (err != PARD_SUCCESS) {
+        free(xadj);
+        free(adj);
+        return err;
+    }
+
+    int *colcount = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *mark = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *u_row_ptr = (int *)malloc((n + 1) * sizeof(int));
     int *l_row_ptr = (int *)calloc(n + 1, sizeof(int));
-    int *l_nnz_per_row = (int *)calloc(n, sizeof(int));
-    
-    if (l_row_ptr == NULL || l_nnz_per_row == NULL) {
+    int *pos = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (colcount == NULL || mark == NULL || u_row_ptr == NULL ||
+        l_row_ptr == NULL || pos == NULL) {
+        free(xadj);
+        free(adj);
+        free(post);
+        free(colcount);
+        free(mark);
+        free(u_row_ptr);
         free(l_row_ptr);
-        free(l_nnz_per_row);
-        free(*factors);
+        free(pos);
         return PARD_ERROR_MEMORY;
     }
-    
-    /* 初始化：L包含原始矩阵的下三角部分 */
-    for (int i = 0; i < n; i++) {
-        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-            int col = matrix->col_idx[j];
-            if (col <= i) {
-                l_nnz_per_row[i]++;
-            }
-        }
+
+    err = symbolic_column_counts(n, xadj, adj, parent, post, colcount);
+    free(post);
+    if (err != PARD_SUCCESS) {
+        free(xadj);
+        free(adj);
+        free(colcount);
+        free(mark);
+        free(u_row_ptr);
+        free(l_row_ptr);
+        free(pos);
+        return err;
     }
-    
-    /* 考虑fill-in：如果A[i][k]和A[k][j]都存在，则L[i][j]可能存在 */
-    /* 使用消元树来确定fill-in */
-    for (int k = 0; k < n; k++) {
-        /* 找到所有与k相关的行 */
-        for (int i = k + 1; i < n; i++) {
-            /* 检查A[i][k]是否存在 */
-            int has_aik = 0;
-            for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-                if (matrix->col_idx[j] == k) {
-                    has_aik = 1;
-                    break;
-                }
-            }
-            
-            if (has_aik) {
-                /* 对于所有j，如果A[k][j]存在且j < i，则L[i][j]可能存在 */
-                for (int j_idx = matrix->row_ptr[k]; j_idx < matrix->row_ptr[k + 1]; j_idx++) {
-                    int j = matrix->col_idx[j_idx];
-                    if (j < i) {
-                        /* 检查L[i][j]是否已经计算 */
-                        int already_counted = 0;
-                        for (int l = matrix->row_ptr[i]; l < matrix->row_ptr[i + 1]; l++) {
-                            if (matrix->col_idx[l] == j) {
-                                already_counted = 1;
-                                break;
-                            }
-                        }
-                        if (!already_counted) {
-                            l_nnz_per_row[i]++;
-                        }
-                    }
-                }
-            }
-        }
+
+    /* U的第j行即L的第j列 */
+    u_row_ptr[0] = 0;
+    for (int j = 0; j < n; j++) {
+        u_row_ptr[j + 1] = u_row_ptr[j] + colcount[j];
     }
-    
-    /* 构建L的行指针 */
-    l_row_ptr[0] = 0;
-    for (int i = 0; i < n; i++) {
-        l_row_ptr[i + 1] = l_row_ptr[i] + l_nnz_per_row[i];
-    }
-    
-    int l_nnz = l_row_ptr[n];
-    
-    /* 分配L的列索引和数值 */
-    int *l_col_idx = (int *)malloc(l_nnz * sizeof(int));
-    double *l_values = (double *)calloc(l_nnz, sizeof(double));
-    
-    if (l_col_idx == NULL || l_values == NULL) {
+    int nnz_l = u_row_ptr[n];
+
+    int *u_col_idx = (int *)malloc((nnz_l > 0 ? nnz_l : 1) * sizeof(int));
+    int *l_col_idx = (int *)malloc((nnz_l > 0 ? nnz_l : 1) * sizeof(int));
+    int *perm = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    *factors = (pard_factors_t *)calloc(1, sizeof(pard_factors_t));
+    if (u_col_idx == NULL || l_col_idx == NULL || perm == NULL || *factors == NULL) {
+        free(xadj);
+        free(adj);
+        free(colcount);
+        free(mark);
+        free(u_row_ptr);
         free(l_row_ptr);
-        free(l_nnz_per_row);
+        free(pos);
+        free(u_col_idx);
         free(l_col_idx);
-        free(l_values);
+        free(perm);
         free(*factors);
+        *factors = NULL;
         return PARD_ERROR_MEMORY;
     }
-    
-    /* 填充L的结构（简化版本，实际应该更仔细地计算fill-in） */
-    int *l_pos = (int *)calloc(n, sizeof(int));
-    for (int i = 0; i < n; i++) {
-        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-            int col = matrix->col_idx[j];
-            if (col <= i) {
-                int pos = l_row_ptr[i] + l_pos[i];
-                l_col_idx[pos] = col;
-                l_pos[i]++;
-            }
-        }
+
+    /* 行子树：L第k行的非零列是A第k行各非零元沿消元树到k的路径之并。
+     * 按k递增把k追加到路径上各列，U每行自然有序 */
+    for (int j = 0; j < n; j++) {
+        pos[j] = u_row_ptr[j];
+        u_col_idx[pos[j]++] = j;
+        mark[j] = -1;
     }
-    
-    /* 类似地计算U的结构（上三角） */
-    int *u_row_ptr = (int *)calloc(n + 1, sizeof(int));
-    int *u_nnz_per_row = (int *)calloc(n, sizeof(int));
-    
-    for (int i = 0; i < n; i++) {
-        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-            int col = matrix->col_idx[j];
-            if (col >= i) {
-                u_nnz_per_row[i]++;
+    for (int k = 0; k < n; k++) {
+        mark[k] = k;
+        for (int p = xadj[k]; p < xadj[k + 1]; p++) {
+            for (int j = adj[p]; j < k && mark[j] != k; j = parent[j]) {
+                mark[j] = k;
+                u_col_idx[pos[j]++] = k;
+                l_row_ptr[k + 1]++;
             }
         }
     }
-    
-    u_row_ptr[0] = 0;
-    for (int i = 0; i < n; i++) {
-        u_row_ptr[i + 1] = u_row_ptr[i] + u_nnz_per_row[i];
-    }
-    
-    int u_nnz = u_row_ptr[n];
-    int *u_col_idx = (int *)malloc(u_nnz * sizeof(int));
-    double *u_values = (double *)calloc(u_nnz, sizeof(double));
-    int *u_pos = (int *)calloc(n, sizeof(int));
-    
-    if (u_col_idx == NULL || u_values == NULL || u_pos == NULL) {
-        free(l_row_ptr);
-        free(l_nnz_per_row);
-        free(l_col_idx);
-        free(l_values);
-        free(l_pos);
-        free(u_row_ptr);
-        free(u_nnz_per_row);
-        free(u_col_idx);
-        free(u_values);
-        free(u_pos);
-        free(*factors);
-        return PARD_ERROR_MEMORY;
+
+    /* L = U^T：按列号递增分发，L每行先放对角元之前的列，最后是对角元 */
+    for (int k = 0; k < n; k++) {
+        l_row_ptr[k + 1] += l_row_ptr[k] + 1;
     }
-    
-    for (int i = 0; i < n; i++) {
-        for (int j = matrix->row_ptr[i]; j < matrix->row_ptr[i + 1]; j++) {
-            int col = matrix->col_idx[j];
-            if (col >= i) {
-                int pos = u_row_ptr[i] + u_pos[i];
-                u_col_idx[pos] = col;
-                u_pos[i]++;
-            }
+    memcpy(pos, l_row_ptr, n * sizeof(int));
+    for (int j = 0; j < n; j++) {
+        for (int p = u_row_ptr[j] + 1; p < u_row_ptr[j + 1]; p++) {
+            l_col_idx[pos[u_col_idx[p]]++] = j;
         }
+        l_col_idx[pos[j]++] = j;
     }
-    
-    /* 设置factors */
+    for (int i = 0; i < n; i++) {
+        perm[i] = i;  /* 初始无置换 */
+    }
+
+    (*factors)->n = n;
+    (*factors)->matrix_type = PARD_MATRIX_TYPE_REAL_NONSYMMETRIC;
     (*factors)->row_ptr = l_row_ptr;
     (*factors)->col_idx = l_col_idx;
-    (*factors)->l_values = l_values;
     (*factors)->u_row_ptr = u_row_ptr;
     (*factors)->u_col_idx = u_col_idx;
-    (*factors)->u_values = u_values;
-    (*factors)->nnz = l_nnz + u_nnz;
-    (*factors)->perm = (int *)malloc(n * sizeof(int));
-    for (int i = 0; i < n; i++) {
-        (*factors)->perm[i] = i;  /* 初始无置换 */
-    }
-    
-    free(l_nnz_per_row);
-    free(u_nnz_per_row);
-    free(l_pos);
-    free(u_pos);
-    
+    (*factors)->perm = perm;
+    (*factors)->nnz = 2 * nnz_l;
+
+    free(xadj);
+    free(adj);
+    free(colcount);
+    free(mark);
+    free(pos);
+
     return PARD_SUCCESS;
 }
@@ -1,45 +1,102 @@
+#include "pard.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
 
-/* 生成稀疏矩阵（Matrix Market格式） */
-void generate_sparse_matrix(int n, double sparsity, const char *filename) {
-    FILE *fp = fopen(filename, "w");
-    if (!fp) {
-        fprintf(stderr, "Error opening file: %s\n", filename);
-        return;
+/**
+ * 把坐标三元组按行（行内按列递增）转换成CSR：先按列、再按行做两遍稳定的计数排序
+ */
+static int coo_to_csr(int n, long nnz, const int *rows, const int *cols, const double *vals,
+                      pard_csr_matrix_t **matrix) {
+    int err = pard_csr_create(matrix, n, (int)nnz);
+    if (err != PARD_SUCCESS) {
+        return err;
+    }
+    int *cptr = (int *)calloc(n + 1, sizeof(int));
+    int *order = (int *)malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+    if (cptr == NULL || order == NULL) {
+        free(cptr);
+        free(order);
+        pard_csr_free(matrix);
+        return PARD_ERROR_MEMORY;
     }
     
+    for (long k = 0; k < nnz; k++) {
+        cptr[cols[k] + 1]++;
+    }
+    for (int j = 0; j < n; j++) {
+        cptr[j + 1] += cptr[j];
+    }
+    for (long k = 0; k < nnz; k++) {
+        order[cptr[cols[k]]++] = (int)k;
+    }
+    
+    int *row_ptr = (*matrix)->row_ptr;
+    for (long k = 0; k < nnz; k++) {
+        row_ptr[rows[k] + 1]++;
+    }
+    for (int i = 0; i < n; i++) {
+        row_ptr[i + 1] += row_ptr[i];
+    }
+    memcpy(cptr, row_ptr, n * sizeof(int));
+    for (long t = 0; t < nnz; t++) {
+        int k = order[t];
+        int p = cptr[rows[k]]++;
+        (*matrix)->col_idx[p] = cols[k];
+        (*matrix)->values[p] = vals[k];
+    }
+    
+    free(cptr);
+    free(order);
+    return PARD_SUCCESS;
+}
+
+/* 生成稀疏矩阵（binary为0时写Matrix Market格式，否则写二进制CSR格式） */
+void generate_sparse_matrix(int n, double sparsity, const char *filename, int binary) {
     /* 计算目标非零元素数 */
     long target_nnz = (long)(n * n * sparsity);
     if (target_nnz < n * 3) {
         target_nnz = n * 3;  // 至少三对角
     }
     
-    /* 写入Matrix Market头部 */
-    fprintf(fp, "%%MatrixMarket matrix coordinate real general\n");
-    fprintf(fp, "%d %d %ld\n", n, n, target_nnz);
+    int *used = (int *)calloc(n * n, sizeof(int));
+    int *rows = (int *)malloc(target_nnz * sizeof(int));
+    int *cols = (int *)malloc(target_nnz * sizeof(int));
+    double *vals = (double *)malloc(target_nnz * sizeof(double));
+    if (used == NULL || rows == NULL || cols == NULL || vals == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        free(used);
+        free(rows);
+        free(cols);
+        free(vals);
+        return;
+    }
     
     srand(42);  // 固定种子以便可重复
     
-    int *used = (int *)calloc(n * n, sizeof(int));
     long nnz = 0;
     
     /* 1. 对角线元素（确保非奇异） */
     for (int i = 0; i < n; i++) {
-        fprintf(fp, "%d %d %.6e\n", i + 1, i + 1, (double)(n + 1));
+        rows[nnz] = i;
+        cols[nnz] = i;
+        vals[nnz] = (double)(n + 1);
         used[i * n + i] = 1;
         nnz++;
     }
     
     /* 2. 上下对角线 */
     for (int i = 0; i < n - 1; i++) {
-        fprintf(fp, "%d %d %.6e\n", i + 1, i + 2, -1.0);
+        rows[nnz] = i;
+        cols[nnz] = i + 1;
+        vals[nnz] = -1.0;
         used[i * n + (i + 1)] = 1;
         nnz++;
         
-        fprintf(fp, "%d %d %.6e\n", i + 2, i + 1, -0.5);
+        rows[nnz] = i + 1;
+        cols[nnz] = i;
+        vals[nnz] = -0.5;
         used[(i + 1) * n + i] = 1;
         nnz++;
     }
@@ -51,8 +108,9 @@ void generate_sparse_matrix(int n, double sparsity, const char *filename) {
         int idx = i * n + j;
         
         if (!used[idx]) {
-            double val = (rand() % 2000 - 1000) / 1000.0;
-            fprintf(fp, "%d %d %.6e\n", i + 1, j + 1, val);
+            rows[nnz] = i;
+            cols[nnz] = j;
+            vals[nnz] = (rand() % 2000 - 1000) / 1000.0;
             used[idx] = 1;
             nnz++;
         }
@@ -62,31 +120,73 @@ void generate_sparse_matrix(int n, double sparsity, const char *filename) {
             break;
         }
     }
-    
     free(used);
-    fclose(fp);
     
+    int ok = 1;
+    if (binary) {
+        pard_csr_matrix_t *matrix = NULL;
+        ok = (coo_to_csr(n, nnz, rows, cols, vals, &matrix) == PARD_SUCCESS &&
+              pard_matrix_write_bin(matrix, filename, 1) == PARD_SUCCESS);
+        if (matrix != NULL) {
+            pard_csr_free(&matrix);
+        }
+    } else {
+        FILE *fp = fopen(filename, "w");
+        if (fp != NULL) {
+            /* 写入Matrix Market头部 */
+            fprintf(fp, "%%MatrixMarket matrix coordinate real general\n");
+            fprintf(fp, "%d %d %ld\n", n, n, target_nnz);
+            for (long k = 0; k < nnz; k++) {
+                fprintf(fp, "%d %d %.6e\n", rows[k] + 1, cols[k] + 1, vals[k]);
+            }
+            fclose(fp);
+        } else {
+            ok = 0;
+        }
+    }
+    free(rows);
+    free(cols);
+    free(vals);
+    
+    if (!ok) {
+        fprintf(stderr, "Error writing file: %s\n", filename);
+        return;
+    }
     printf("Generated matrix: %s (%dx%d, %ld non-zeros, sparsity: %.4f%%)\n",
            filename, n, n, nnz, (double)nnz / (n * n) * 100);
 }
 
 int main(int argc, char **argv) {
     if (argc < 4) {
-        printf("Usage: %s <n> <sparsity> <output_file>\n", argv[0]);
+        printf("Usage: %s <n> <sparsity> <output_file> [mtx|bin]\n", argv[0]);
         printf("  n: matrix dimension\n");
         printf("  sparsity: sparsity ratio (e.g., 0.01 for 1%%)\n");
+        printf("  format: mtx (Matrix Market, default) or bin (binary CSR with checksum);\n");
+        printf("          output files ending in .pcsr default to bin\n");
         return 1;
     }
     
     int n = atoi(argv[1]);
     double sparsity = atof(argv[2]);
     const char *filename = argv[3];
+    size_t len = strlen(filename);
+    int binary = (len > 5 && strcmp(filename + len - 5, ".pcsr") == 0);
+    if (argc > 4) {
+        if (strcmp(argv[4], "bin") == 0) {
+            binary = 1;
+        } else if (strcmp(argv[4], "mtx") == 0) {
+            binary = 0;
+        } else {
+            fprintf(stderr, "Unknown format: %s\n", argv[4]);
+            return 1;
+        }
+    }
     
     if (n <= 0 || sparsity <= 0 || sparsity > 1) {
         fprintf(stderr, "Invalid parameters\n");
         return 1;
     }
     
-    generate_sparse_matrix(n, sparsity, filename);
+    generate_sparse_matrix(n, sparsity, filename, binary);
     return 0;
 }
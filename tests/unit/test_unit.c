@@ -1,24 +1,58 @@
+#define _XOPEN_SOURCE 700
 #include "pard.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <assert.h>
+#include <math.h>
+#include <unistd.h>
 #include <mpi.h>
 
+/* 内部函数 */
+extern int elimination_tree_depth(int n, const int *parent);
+
+/* 失败的检查数。检查不用assert：默认的Release构建定义NDEBUG，assert会被编译掉 */
+static int test_failures = 0;
+
+/* 检查失败时打印位置并计数，测试继续 */
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("  CHECK FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+/* 后续步骤依赖的条件：失败时计数并结束当前测试 */
+#define REQUIRE(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("  REQUIRE FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+            return; \
+        } \
+    } while (0)
+
+/* 运行一个测试，按其间新增的失败数报告结果 */
+static void run_test(void (*test)(void), const char *name) {
+    int before = test_failures;
+    test();
+    printf("%s: %s\n", name, (test_failures == before) ? "PASSED" : "FAILED");
+}
+
+#define RUN_TEST(test) run_test(test, #test)
+
 /* 测试CSR矩阵创建和释放 */
 void test_csr_create_free() {
     pard_csr_matrix_t *matrix = NULL;
     int err = pard_csr_create(&matrix, 10, 20);
-    assert(err == PARD_SUCCESS);
-    assert(matrix != NULL);
-    assert(matrix->n == 10);
-    assert(matrix->nnz == 20);
+    REQUIRE(err == PARD_SUCCESS);
+    CHECK(matrix != NULL);
+    CHECK(matrix->n == 10);
+    CHECK(matrix->nnz == 20);
     
     err = pard_csr_free(&matrix);
-    assert(err == PARD_SUCCESS);
-    assert(matrix == NULL);
-    
-    printf("test_csr_create_free: PASSED\n");
+    REQUIRE(err == PARD_SUCCESS);
+    CHECK(matrix == NULL);
 }
 
 /* 测试矩阵读取（需要测试矩阵文件） */
@@ -55,6 +89,7 @@ void test_matrix_read() {
                 strcpy(abs_path, abs_alt);
                 printf("  Found file at: %s\n", abs_path);
             } else {
+                test_failures++;
                 printf("test_matrix_read: FAILED (cannot find test matrix file, tried: %s, %s, %s)\n", 
                        alt_path, test_matrix, abs_alt);
                 return;
@@ -67,6 +102,7 @@ void test_matrix_read() {
     int err = pard_matrix_read_mtx(&matrix, abs_path);
     
     if (err != PARD_SUCCESS) {
+        test_failures++;
         printf("test_matrix_read: FAILED (error code: %d, file: %s)\n", err, abs_path);
         /* 验证文件是否真的存在且可读 */
         FILE *test = fopen(abs_path, "r");
@@ -84,18 +120,21 @@ void test_matrix_read() {
     }
     
     if (matrix == NULL) {
+        test_failures++;
         printf("test_matrix_read: FAILED (matrix is NULL)\n");
         return;
     }
     
     /* 验证矩阵基本信息 */
     if (matrix->n != 10) {
+        test_failures++;
         printf("test_matrix_read: FAILED (wrong dimension: %d, expected 10)\n", matrix->n);
         pard_csr_free(&matrix);
         return;
     }
     
     if (matrix->nnz < 20 || matrix->nnz > 30) {
+        test_failures++;
         printf("test_matrix_read: FAILED (wrong nnz: %d, expected ~28)\n", matrix->nnz);
         pard_csr_free(&matrix);
         return;
@@ -103,6 +142,7 @@ void test_matrix_read() {
     
     /* 验证矩阵数据完整性 */
     if (matrix->row_ptr == NULL || matrix->col_idx == NULL || matrix->values == NULL) {
+        test_failures++;
         printf("test_matrix_read: FAILED (null pointers)\n");
         pard_csr_free(&matrix);
         return;
@@ -110,19 +150,20 @@ void test_matrix_read() {
     
     /* 验证行指针的有效性 */
     if (matrix->row_ptr[0] != 0) {
+        test_failures++;
         printf("test_matrix_read: FAILED (row_ptr[0] should be 0)\n");
         pard_csr_free(&matrix);
         return;
     }
     
     if (matrix->row_ptr[matrix->n] != matrix->nnz) {
+        test_failures++;
         printf("test_matrix_read: FAILED (row_ptr[n] should equal nnz)\n");
         pard_csr_free(&matrix);
         return;
     }
     
     pard_csr_free(&matrix);
-    printf("test_matrix_read: PASSED\n");
 }
 
 /* 测试重排序 */
@@ -132,7 +173,7 @@ void test_ordering() {
     int n = 5;
     int nnz = 10;
     int err = pard_csr_create(&matrix, n, nnz);
-    assert(err == PARD_SUCCESS);
+    REQUIRE(err == PARD_SUCCESS);
     
     /* 填充一个简单的矩阵 */
     matrix->row_ptr[0] = 0;
@@ -153,15 +194,761 @@ void test_ordering() {
     
     int *perm = NULL, *inv_perm = NULL;
     err = pard_minimum_degree(matrix, &perm, &inv_perm);
-    assert(err == PARD_SUCCESS);
-    assert(perm != NULL);
-    assert(inv_perm != NULL);
+    REQUIRE(err == PARD_SUCCESS);
+    CHECK(perm != NULL);
+    CHECK(inv_perm != NULL);
+    
+    free(perm);
+    free(inv_perm);
+    pard_csr_free(&matrix);
+}
+
+/* 测试AMD：星形图的中心节点必须最后消去，结果必须是合法置换 */
+void test_amd_ordering() {
+    int n = 12;
+    pard_csr_matrix_t *matrix = NULL;
+    int err = pard_csr_create(&matrix, n, 3 * n);
+    REQUIRE(err == PARD_SUCCESS);
+    
+    /* 中心节点5与所有节点相连 */
+    int pos = 0;
+    for (int i = 0; i < n; i++) {
+        matrix->row_ptr[i] = pos;
+        if (i == 5) {
+            for (int j = 0; j < n; j++) {
+                matrix->col_idx[pos] = j;
+                matrix->values[pos++] = (j == i) ? 4.0 : 1.0;
+            }
+        } else {
+            matrix->col_idx[pos] = i;
+            matrix->values[pos++] = 4.0;
+            matrix->col_idx[pos] = 5;
+            matrix->values[pos++] = 1.0;
+        }
+    }
+    matrix->row_ptr[n] = pos;
+    matrix->nnz = pos;
+    
+    int *perm = NULL, *inv_perm = NULL;
+    err = pard_minimum_degree(matrix, &perm, &inv_perm);
+    REQUIRE(err == PARD_SUCCESS);
+    
+    int *seen = (int *)calloc(n, sizeof(int));
+    for (int k = 0; k < n; k++) {
+        CHECK(perm[k] >= 0 && perm[k] < n);
+        CHECK(!seen[perm[k]]);
+        seen[perm[k]] = 1;
+        CHECK(inv_perm[perm[k]] == k);
+    }
+    CHECK(perm[n - 1] == 5);
     
+    free(seen);
     free(perm);
     free(inv_perm);
     pard_csr_free(&matrix);
+}
+
+/* 二维5点Laplace网格矩阵 */
+static pard_csr_matrix_t *create_grid_2d(int nx) {
+    int n = nx * nx;
+    pard_csr_matrix_t *matrix = NULL;
+    int err = pard_csr_create(&matrix, n, 5 * n);
+    CHECK(err == PARD_SUCCESS);
+    
+    int pos = 0;
+    for (int i = 0; i < n; i++) {
+        int x = i % nx, y = i / nx;
+        matrix->row_ptr[i] = pos;
+        if (y > 0) {
+            matrix->col_idx[pos] = i - nx;
+            matrix->values[pos++] = -1.0;
+        }
+        if (x > 0) {
+            matrix->col_idx[pos] = i - 1;
+            matrix->values[pos++] = -1.0;
+        }
+        matrix->col_idx[pos] = i;
+        matrix->values[pos++] = 4.0;
+        if (x < nx - 1) {
+            matrix->col_idx[pos] = i + 1;
+            matrix->values[pos++] = -1.0;
+        }
+        if (y < nx - 1) {
+            matrix->col_idx[pos] = i + nx;
+            matrix->values[pos++] = -1.0;
+        }
+    }
+    matrix->row_ptr[n] = pos;
+    matrix->nnz = pos;
+    matrix->is_symmetric = 1;
+    return matrix;
+}
+
+/* nx×nx×nx三维7点网格 */
+static pard_csr_matrix_t *create_grid_3d(int nx) {
+    int n = nx * nx * nx;
+    pard_csr_matrix_t *matrix = NULL;
+    int err = pard_csr_create(&matrix, n, 7 * n);
+    CHECK(err == PARD_SUCCESS);
+    
+    int pos = 0;
+    for (int i = 0; i < n; i++) {
+        int x = i % nx, y = (i / nx) % nx, z = i / (nx * nx);
+        int nb[7] = {
+            z > 0 ? i - nx * nx : -1, y > 0 ? i - nx : -1, x > 0 ? i - 1 : -1, i,
+            x < nx - 1 ? i + 1 : -1, y < nx - 1 ? i + nx : -1, z < nx - 1 ? i + nx * nx : -1
+        };
+        matrix->row_ptr[i] = pos;
+        for (int t = 0; t < 7; t++) {
+            if (nb[t] >= 0) {
+                matrix->col_idx[pos] = nb[t];
+                matrix->values[pos++] = (nb[t] == i) ? 6.0 : -1.0;
+            }
+        }
+    }
+    matrix->row_ptr[n] = pos;
+    matrix->nnz = pos;
+    matrix->is_symmetric = 1;
+    return matrix;
+}
+
+/* 测试多层嵌套剖分：30×30网格（超过叶子规模，会真正剖分），结果必须是合法置换 */
+void test_nested_dissection() {
+    int nx = 30;
+    int n = nx * nx;
+    pard_csr_matrix_t *matrix = create_grid_2d(nx);
+    
+    int *perm = NULL, *inv_perm = NULL;
+    int err = pard_nested_dissection(matrix, &perm, &inv_perm);
+    REQUIRE(err == PARD_SUCCESS);
+    
+    int *seen = (int *)calloc(n, sizeof(int));
+    for (int k = 0; k < n; k++) {
+        CHECK(perm[k] >= 0 && perm[k] < n);
+        CHECK(!seen[perm[k]]);
+        seen[perm[k]] = 1;
+        CHECK(inv_perm[perm[k]] == k);
+    }
+    
+    free(seen);
+    free(perm);
+    free(inv_perm);
+    pard_csr_free(&matrix);
+}
+
+/* 测试排序选项：打乱编号的三对角矩阵经RCM恢复带宽1，非法用户置换被拒绝，AUTO返回合法置换，
+ * 三维网格上AUTO按运算量选中ND */
+void test_ordering_options() {
+    int n = 60;
+    int *label = (int *)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        label[i] = (i * 37) % n;  /* 37与60互素，构成置换 */
+    }
+    
+    pard_csr_matrix_t *matrix = NULL;
+    int err = pard_csr_create(&matrix, n, 3 * n);
+    REQUIRE(err == PARD_SUCCESS);
+    
+    /* 链 0-1-2-...-(n-1) 按label重新编号 */
+    int *chain_of = (int *)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        chain_of[label[i]] = i;
+    }
+    int pos = 0;
+    for (int v = 0; v < n; v++) {
+        int c = chain_of[v];
+        matrix->row_ptr[v] = pos;
+        if (c > 0) {
+            matrix->col_idx[pos] = label[c - 1];
+            matrix->values[pos++] = -1.0;
+        }
+        matrix->col_idx[pos] = v;
+        matrix->values[pos++] = 4.0;
+        if (c < n - 1) {
+            matrix->col_idx[pos] = label[c + 1];
+            matrix->values[pos++] = -1.0;
+        }
+    }
+    matrix->row_ptr[n] = pos;
+    matrix->nnz = pos;
+    
+    int *perm = NULL, *inv_perm = NULL;
+    pard_ordering_t used;
+    err = pard_compute_ordering(matrix, PARD_ORDERING_RCM, NULL, &perm, &inv_perm, &used);
+    CHECK(err == PARD_SUCCESS && used == PARD_ORDERING_RCM);
+    for (int v = 0; v < n; v++) {
+        for (int j = matrix->row_ptr[v]; j < matrix->row_ptr[v + 1]; j++) {
+            int d = inv_perm[v] - inv_perm[matrix->col_idx[j]];
+            CHECK(d >= -1 && d <= 1);
+        }
+    }
+    free(perm);
+    free(inv_perm);
+    
+    /* 重复元素的用户置换 */
+    label[1] = label[0];
+    err = pard_compute_ordering(matrix, PARD_ORDERING_USER, label, &perm, &inv_perm, NULL);
+    CHECK(err == PARD_ERROR_INVALID_INPUT && perm == NULL);
+    
+    err = pard_compute_ordering(matrix, PARD_ORDERING_AUTO, NULL, &perm, &inv_perm, &used);
+    CHECK(err == PARD_SUCCESS && used != PARD_ORDERING_AUTO);
+    for (int k = 0; k < n; k++) {
+        CHECK(inv_perm[perm[k]] == k);
+    }
+    
+    free(perm);
+    free(inv_perm);
+    free(label);
+    free(chain_of);
+    pard_csr_free(&matrix);
+    
+    /* 28^3网格：ND的nnz(L)比AMD多，但分解运算量少约20%，AUTO应选ND */
+    matrix = create_grid_3d(28);
+    err = pard_compute_ordering(matrix, PARD_ORDERING_AUTO, NULL, &perm, &inv_perm, &used);
+    CHECK(err == PARD_SUCCESS && used == PARD_ORDERING_ND);
+    free(perm);
+    free(inv_perm);
+    pard_csr_free(&matrix);
+}
+
+/* 非对称随机模式：对角 + 每行至多两个伪随机非对角元 */
+static pard_csr_matrix_t *create_random_pattern(int n, unsigned int seed) {
+    pard_csr_matrix_t *matrix = NULL;
+    int err = pard_csr_create(&matrix, n, 3 * n);
+    CHECK(err == PARD_SUCCESS);
+    
+    int pos = 0;
+    for (int i = 0; i < n; i++) {
+        matrix->row_ptr[i] = pos;
+        matrix->col_idx[pos] = i;
+        matrix->values[pos++] = 1.0;
+        for (int t = 0; t < 2; t++) {
+            seed = seed * 1103515245u + 12345u;
+            int j = (int)((seed >> 16) % n);
+            if (j != i && matrix->col_idx[pos - 1] != j) {
+                matrix->col_idx[pos] = j;
+                matrix->values[pos++] = 1.0;
+            }
+        }
+    }
+    matrix->row_ptr[n] = pos;
+    matrix->nnz = pos;
+    return matrix;
+}
+
+/* 稠密符号消元得到的消元树：parent[j]为L第j列对角以下第一个非零行 */
+static void dense_etree(int n, char *pattern, int *parent) {
+    for (int k = 0; k < n; k++) {
+        parent[k] = -1;
+        for (int i = k + 1; i < n; i++) {
+            if (pattern[i * n + k]) {
+                if (parent[k] == -1) {
+                    parent[k] = i;
+                }
+                for (int j = k + 1; j <= i; j++) {
+                    if (pattern[j * n + k]) {
+                        pattern[i * n + j] = 1;
+                        pattern[j * n + i] = 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* 测试消元树：对称与A^T*A模式和稠密符号消元比较，后序合法，深度O(n)计算 */
+void test_elimination_tree() {
+    int n = 40;
+    pard_csr_matrix_t *matrix = create_random_pattern(n, 12345u);
+    int err;
+    
+    char *pattern = (char *)calloc(n * n, 1);
+    int *expected = (int *)malloc(n * sizeof(int));
+    int *parent = NULL;
+    
+    /* A+A^T */
+    for (int i = 0; i < n; i++) {
+        for (int p = matrix->row_ptr[i]; p < matrix->row_ptr[i + 1]; p++) {
+            pattern[i * n + matrix->col_idx[p]] = 1;
+            pattern[matrix->col_idx[p] * n + i] = 1;
+        }
+    }
+    dense_etree(n, pattern, expected);
+    err = pard_elimination_tree(matrix, PARD_ETREE_SYMMETRIC, &parent);
+    REQUIRE(err == PARD_SUCCESS);
+    for (int j = 0; j < n; j++) {
+        CHECK(parent[j] == expected[j]);
+    }
+    free(parent);
+    
+    /* A^T*A */
+    memset(pattern, 0, n * n);
+    for (int r = 0; r < n; r++) {
+        for (int p = matrix->row_ptr[r]; p < matrix->row_ptr[r + 1]; p++) {
+            for (int q = matrix->row_ptr[r]; q < matrix->row_ptr[r + 1]; q++) {
+                pattern[matrix->col_idx[p] * n + matrix->col_idx[q]] = 1;
+            }
+        }
+    }
+    dense_etree(n, pattern, expected);
+    err = pard_elimination_tree(matrix, PARD_ETREE_ATA, &parent);
+    REQUIRE(err == PARD_SUCCESS);
+    for (int j = 0; j < n; j++) {
+        CHECK(parent[j] == expected[j]);
+    }
+    
+    /* 后序：每个节点都出现一次，且排在父节点之前 */
+    int *post = NULL;
+    err = pard_etree_postorder(n, parent, &post);
+    REQUIRE(err == PARD_SUCCESS);
+    int *where = (int *)malloc(n * sizeof(int));
+    for (int j = 0; j < n; j++) {
+        where[j] = -1;
+    }
+    for (int k = 0; k < n; k++) {
+        CHECK(where[post[k]] == -1);
+        where[post[k]] = k;
+    }
+    for (int j = 0; j < n; j++) {
+        if (parent[j] != -1) {
+            CHECK(where[j] < where[parent[j]]);
+        }
+    }
+    
+    /* 长链：深度为n-1 */
+    for (int j = 0; j < n; j++) {
+        expected[j] = (j + 1 < n) ? j + 1 : -1;
+    }
+    CHECK(elimination_tree_depth(n, expected) == n - 1);
+    
+    free(post);
+    free(where);
+    free(parent);
+    free(expected);
+    free(pattern);
+    pard_csr_free(&matrix);
+}
+
+/* 测试符号分解：L的结构与稠密符号消元得到的填充结构完全一致，U为L^T的结构 */
+void test_symbolic_factorization() {
+    int n = 60;
+    pard_csr_matrix_t *matrix = create_random_pattern(n, 777u);
+    
+    char *pattern = (char *)calloc(n * n, 1);
+    int *expected = (int *)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        for (int p = matrix->row_ptr[i]; p < matrix->row_ptr[i + 1]; p++) {
+            pattern[i * n + matrix->col_idx[p]] = 1;
+            pattern[matrix->col_idx[p] * n + i] = 1;
+        }
+    }
+    dense_etree(n, pattern, expected);
     
-    printf("test_ordering: PASSED\n");
+    int *parent = NULL, *first_child = NULL, *next_sibling = NULL;
+    int err = pard_build_elimination_tree(matrix, &parent, &first_child, &next_sibling);
+    REQUIRE(err == PARD_SUCCESS);
+    pard_factors_t *factors = NULL;
+    err = pard_symbolic_factorization(matrix, parent, first_child, next_sibling, &factors);
+    REQUIRE(err == PARD_SUCCESS);
+    
+    int nnz_l = 0;
+    for (int i = 0; i < n; i++) {
+        int p = factors->row_ptr[i];
+        for (int j = 0; j <= i; j++) {
+            if (pattern[i * n + j] || i == j) {
+                CHECK(p < factors->row_ptr[i + 1] && factors->col_idx[p] == j);
+                p++;
+                nnz_l++;
+            }
+        }
+        CHECK(p == factors->row_ptr[i + 1]);
+        
+        p = factors->u_row_ptr[i];
+        for (int j = i; j < n; j++) {
+            if (pattern[j * n + i] || i == j) {
+                CHECK(p < factors->u_row_ptr[i + 1] && factors->u_col_idx[p] == j);
+                p++;
+            }
+        }
+        CHECK(p == factors->u_row_ptr[i + 1]);
+    }
+    CHECK(factors->nnz == 2 * nnz_l);
+    
+    free(factors->row_ptr);
+    free(factors->col_idx);
+    free(factors->l_values);
+    free(factors->u_row_ptr);
+    free(factors->u_col_idx);
+    free(factors->u_values);
+    free(factors->perm);
+    free(factors);
+    free(parent);
+    free(first_child);
+    free(next_sibling);
+    free(expected);
+    free(pattern);
+    pard_csr_free(&matrix);
+}
+
+/* 测试超节点划分：基本超节点内各列结构相同，松弛合并减少超节点数，行结构为最后一列的结构 */
+void test_supernodes() {
+    int nsuper_fundamental = 0;
+    for (int relax = 0; relax < 2; relax++) {
+        pard_csr_matrix_t *matrix = create_grid_2d(20);
+        int n = matrix->n;
+        pard_solver_t *solver = NULL;
+        int err = pardiso_init(&solver, PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF, MPI_COMM_NULL);
+        REQUIRE(err == PARD_SUCCESS);
+        err = pardiso_set_supernode_relaxation(solver, relax ? 32 : 1, 0.1);
+        REQUIRE(err == PARD_SUCCESS);
+        err = pardiso_symbolic(solver, matrix);
+        REQUIRE(err == PARD_SUCCESS);
+        
+        const pard_factors_t *f = solver->factors;
+        int ns = f->nsuper;
+        CHECK(ns > 0 && f->super_ptr[0] == 0 && f->super_ptr[ns] == n);
+        for (int s = 0; s < ns; s++) {
+            int last = f->super_ptr[s + 1] - 1;
+            CHECK(f->super_ptr[s] <= last);
+            CHECK(f->super_parent[s] == -1 || f->super_parent[s] > s);
+            /* 行结构 = L最后一列对角以下的结构（U的第last行） */
+            int len = f->super_row_ptr[s + 1] - f->super_row_ptr[s];
+            CHECK(len == f->u_row_ptr[last + 1] - f->u_row_ptr[last] - 1);
+            for (int t = 0; t < len; t++) {
+                CHECK(f->super_row_idx[f->super_row_ptr[s] + t] ==
+                       f->u_col_idx[f->u_row_ptr[last] + 1 + t]);
+            }
+            if (len > 0) {
+                int p = f->super_row_idx[f->super_row_ptr[s]];
+                CHECK(p > last);
+                CHECK(f->super_parent[s] != -1 &&
+                       f->super_ptr[f->super_parent[s]] <= p &&
+                       p < f->super_ptr[f->super_parent[s] + 1]);
+            }
+            if (!relax) {
+                for (int j = f->super_ptr[s]; j < last; j++) {
+                    CHECK(f->u_row_ptr[j + 1] - f->u_row_ptr[j] ==
+                           f->u_row_ptr[j + 2] - f->u_row_ptr[j + 1] + 1);
+                }
+            }
+        }
+        if (!relax) {
+            nsuper_fundamental = ns;
+        } else {
+            CHECK(ns < nsuper_fundamental);
+        }
+        
+        err = pardiso_factor(solver);
+        REQUIRE(err == PARD_SUCCESS);
+        
+        pardiso_cleanup(&solver);
+        pard_csr_free(&matrix);
+    }
+}
+
+/* 测试多右端项SpMM：与逐列SpMV一致（含不足一个列块的剩余列、多线程按行划分、beta为0不读Y） */
+void test_csr_spmm() {
+    int n = 20000;
+    int nrhs = 11;
+    pard_csr_matrix_t *matrix = create_random_pattern(n, 4242u);
+    for (int p = 0; p < matrix->nnz; p++) {
+        matrix->values[p] = 1.0 + (p % 13) * 0.25;
+    }
+    
+    double *X = (double *)malloc((size_t)n * nrhs * sizeof(double));
+    double *Y = (double *)malloc((size_t)n * nrhs * sizeof(double));
+    double *expected = (double *)malloc((size_t)n * nrhs * sizeof(double));
+    for (int i = 0; i < n * nrhs; i++) {
+        X[i] = (double)((i * 7) % 17) - 8.0;
+        Y[i] = 0.5 * (i % 5);
+    }
+    for (int c = 0; c < nrhs; c++) {
+        for (int i = 0; i < n; i++) {
+            double sum = 0.0;
+            for (int p = matrix->row_ptr[i]; p < matrix->row_ptr[i + 1]; p++) {
+                sum += matrix->values[p] * X[(size_t)c * n + matrix->col_idx[p]];
+            }
+            expected[(size_t)c * n + i] = 2.0 * Y[(size_t)c * n + i] - sum;
+        }
+    }
+    
+    for (int threads = 1; threads <= 3; threads += 2) {
+        double *Yt = (double *)malloc((size_t)n * nrhs * sizeof(double));
+        memcpy(Yt, Y, (size_t)n * nrhs * sizeof(double));
+        int err = pard_csr_spmm(matrix, nrhs, -1.0, X, 2.0, Yt, NULL, threads);
+        REQUIRE(err == PARD_SUCCESS);
+        for (int i = 0; i < n * nrhs; i++) {
+            CHECK(fabs(Yt[i] - expected[i]) <= 1e-12 * (1.0 + fabs(expected[i])));
+        }
+        free(Yt);
+    }
+    
+    /* 单个向量，beta为0：Y的原值（NaN）不参与 */
+    for (int i = 0; i < n; i++) {
+        Y[i] = NAN;
+    }
+    int err = pard_csr_spmm(matrix, 1, 1.0, X, 0.0, Y, NULL, 2);
+    REQUIRE(err == PARD_SUCCESS);
+    for (int i = 0; i < n; i++) {
+        double sum = 0.0;
+        for (int p = matrix->row_ptr[i]; p < matrix->row_ptr[i + 1]; p++) {
+            sum += matrix->values[p] * X[matrix->col_idx[p]];
+        }
+        CHECK(fabs(Y[i] - sum) <= 1e-12 * (1.0 + fabs(sum)));
+    }
+    
+    free(X);
+    free(Y);
+    free(expected);
+    pard_csr_free(&matrix);
+}
+
+/* 把文本写入临时文件并读取为CSR */
+static pard_csr_matrix_t *read_mtx_text(const char *text) {
+    char path[] = "/tmp/pard_mtx_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *fp = (fd >= 0) ? fdopen(fd, "w") : NULL;
+    CHECK(fp != NULL);
+    if (fp == NULL) {
+        return NULL;
+    }
+    fputs(text, fp);
+    fclose(fp);
+    pard_csr_matrix_t *matrix = NULL;
+    int err = pard_matrix_read_mtx(&matrix, path);
+    remove(path);
+    return (err == PARD_SUCCESS) ? matrix : NULL;
+}
+
+/* A(i,j)，不存在时返回0 */
+static double csr_entry(const pard_csr_matrix_t *matrix, int i, int j) {
+    for (int p = matrix->row_ptr[i]; p < matrix->row_ptr[i + 1]; p++) {
+        if (matrix->col_idx[p] == j) {
+            return matrix->values[p];
+        }
+    }
+    return 0.0;
+}
+
+/* 测试Matrix Market的各种头部与数值写法，以及多线程解析大文件 */
+void test_matrix_read_formats() {
+    /* pattern symmetric：补全上三角，数值为1 */
+    pard_csr_matrix_t *m = read_mtx_text(
+        "%%MatrixMarket matrix coordinate pattern symmetric\n"
+        "3 3 4\n1 1\n2 1\n3 2\n3 3\n");
+    REQUIRE(m != NULL && m->n == 3 && m->nnz == 6 && m->is_symmetric);
+    CHECK(csr_entry(m, 0, 1) == 1.0 && csr_entry(m, 1, 0) == 1.0 && csr_entry(m, 1, 2) == 1.0);
+    CHECK(csr_entry(m, 1, 1) == 0.0);
+    pard_csr_free(&m);
+    
+    /* integer skew-symmetric：另一半取相反数，列号在行内递增 */
+    m = read_mtx_text(
+        "%%MatrixMarket matrix coordinate integer skew-symmetric\n"
+        "% comment\n\n3 3 2\n3 1 -7\n2 1 5\n");
+    REQUIRE(m != NULL && m->nnz == 4 && !m->is_symmetric);
+    CHECK(csr_entry(m, 1, 0) == 5.0 && csr_entry(m, 0, 1) == -5.0);
+    CHECK(csr_entry(m, 2, 0) == -7.0 && csr_entry(m, 0, 2) == 7.0);
+    CHECK(m->col_idx[0] == 1 && m->col_idx[1] == 2);
+    pard_csr_free(&m);
+    
+    /* real general：乱序、CRLF换行、Fortran指数、超长尾数 */
+    m = read_mtx_text(
+        "%%MatrixMarket matrix coordinate real general\r\n"
+        "2 2 4\r\n2 2 1.5e2\r\n1 2 -2.25D-1\r\n2 1 0.12345678901234567890\r\n1 1 -.5\r\n");
+    REQUIRE(m != NULL && m->nnz == 4);
+    CHECK(csr_entry(m, 1, 1) == 150.0 && csr_entry(m, 0, 1) == -0.225 && csr_entry(m, 0, 0) == -0.5);
+    CHECK(csr_entry(m, 1, 0) == strtod("0.12345678901234567890", NULL));
+    pard_csr_free(&m);
+    
+    /* 复数与array格式不支持 */
+    CHECK(read_mtx_text("%%MatrixMarket matrix coordinate complex general\n1 1 1\n1 1 1 0\n") == NULL);
+    CHECK(read_mtx_text("%%MatrixMarket matrix array real general\n1 1\n1\n") == NULL);
+    
+    /* 写出再读回（约4MB，多线程解析）：结构与数值逐位相同 */
+    int n = 20000;
+    pard_csr_matrix_t *a = create_random_pattern(n, 99u);
+    for (int p = 0; p < a->nnz; p++) {
+        a->values[p] = sin(0.37 * p) * pow(10.0, (p % 9) - 4);
+    }
+    char path[] = "/tmp/pard_mtx_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+    int err = pard_matrix_write_mtx(a, path);
+    REQUIRE(err == PARD_SUCCESS);
+    setenv("PARD_NUM_THREADS", "4", 1);
+    err = pard_matrix_read_mtx(&m, path);
+    unsetenv("PARD_NUM_THREADS");
+    remove(path);
+    REQUIRE(err == PARD_SUCCESS && m->n == n && m->nnz == a->nnz);
+    for (int i = 0; i < n; i++) {
+        CHECK(m->row_ptr[i + 1] - m->row_ptr[i] == a->row_ptr[i + 1] - a->row_ptr[i]);
+        for (int p = a->row_ptr[i]; p < a->row_ptr[i + 1]; p++) {
+            CHECK(csr_entry(m, i, a->col_idx[p]) == a->values[p]);
+        }
+        for (int p = m->row_ptr[i] + 1; p < m->row_ptr[i + 1]; p++) {
+            CHECK(m->col_idx[p - 1] < m->col_idx[p]);
+        }
+    }
+    pard_csr_free(&a);
+    pard_csr_free(&m);
+}
+
+void test_matrix_binary() {
+    int n = 5000;
+    pard_csr_matrix_t *a = create_random_pattern(n, 7u);
+    for (int p = 0; p < a->nnz; p++) {
+        a->values[p] = cos(0.11 * p);
+    }
+    a->is_symmetric = 1;
+    a->is_upper = 1;
+    char path[] = "/tmp/pard_bin_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+    int err = pard_matrix_write_bin(a, path, 1);
+    REQUIRE(err == PARD_SUCCESS);
+    
+    /* 复制读入与映射读入：结构、数值、对称标志逐位相同；映射的数组按64字节对齐 */
+    pard_csr_matrix_t *c = NULL, *m = NULL;
+    err = pard_matrix_read_bin(&c, path, PARD_BIN_COPY | PARD_BIN_VERIFY);
+    REQUIRE(err == PARD_SUCCESS);
+    err = pard_matrix_read_bin(&m, path, PARD_BIN_MMAP | PARD_BIN_VERIFY);
+    REQUIRE(err == PARD_SUCCESS);
+    CHECK(c->mapping == NULL && m->mapping != NULL);
+    CHECK(((size_t)m->row_ptr % 64) == 0 && ((size_t)m->col_idx % 64) == 0 &&
+           ((size_t)m->values % 64) == 0);
+    pard_csr_matrix_t *both[2] = {c, m};
+    for (int k = 0; k < 2; k++) {
+        pard_csr_matrix_t *b = both[k];
+        CHECK(b->n == n && b->nnz == a->nnz && b->is_symmetric == 1 && b->is_upper == 1);
+        CHECK(memcmp(b->row_ptr, a->row_ptr, (n + 1) * sizeof(int)) == 0);
+        CHECK(memcmp(b->col_idx, a->col_idx, a->nnz * sizeof(int)) == 0);
+        CHECK(memcmp(b->values, a->values, a->nnz * sizeof(double)) == 0);
+    }
+    
+    /* 映射矩阵可以原地置换（私有映射写时复制，旧数组随映射一起释放），文件不变 */
+    int *perm = (int *)malloc(n * sizeof(int));
+    int *inv = (int *)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        perm[i] = n - 1 - i;
+        inv[n - 1 - i] = i;
+    }
+    m->values[0] = -1.0;
+    err = apply_permutation(m, perm, inv);
+    CHECK(err == PARD_SUCCESS && m->mapping == NULL && m->nnz == a->nnz);
+    pard_csr_free(&m);
+    err = pard_matrix_read_bin(&m, path, PARD_BIN_MMAP | PARD_BIN_VERIFY);
+    CHECK(err == PARD_SUCCESS && m->values[0] == a->values[0]);
+    pard_csr_free(&m);
+    free(perm);
+    free(inv);
+    
+    /* 数据区损坏：校验时报错，不校验时照常读入；截断的文件总是报错 */
+    FILE *fp = fopen(path, "r+b");
+    REQUIRE(fp != NULL);
+    fseek(fp, -3, SEEK_END);
+    fputc(0x5a, fp);
+    fclose(fp);
+    err = pard_matrix_read_bin(&m, path, PARD_BIN_MMAP | PARD_BIN_VERIFY);
+    CHECK(err == PARD_ERROR_INVALID_INPUT);
+    err = pard_matrix_read_bin(&m, path, PARD_BIN_COPY | PARD_BIN_VERIFY);
+    CHECK(err == PARD_ERROR_INVALID_INPUT);
+    err = pard_matrix_read_bin(&m, path, PARD_BIN_MMAP);
+    REQUIRE(err == PARD_SUCCESS);
+    pard_csr_free(&m);
+    err = truncate(path, 1000);
+    CHECK(err == 0);
+    err = pard_matrix_read_bin(&m, path, PARD_BIN_COPY);
+    CHECK(err == PARD_ERROR_INVALID_INPUT);
+    
+    /* 结构不合法（列索引越界、row_ptr不单调）的文件即使不校验也报错 */
+    for (int k = 0; k < 2; k++) {
+        int *slot = (k == 0) ? &a->col_idx[a->nnz / 2] : &a->row_ptr[n / 2];
+        int saved = *slot;
+        *slot = (k == 0) ? n : a->nnz;
+        err = pard_matrix_write_bin(a, path, 0);
+        REQUIRE(err == PARD_SUCCESS);
+        *slot = saved;
+        err = pard_matrix_read_bin(&m, path, PARD_BIN_MMAP);
+        CHECK(err == PARD_ERROR_INVALID_INPUT && m == NULL);
+        err = pard_matrix_read_bin(&m, path, PARD_BIN_COPY);
+        CHECK(err == PARD_ERROR_INVALID_INPUT && m == NULL);
+    }
+    remove(path);
+    
+    pard_csr_free(&a);
+    pard_csr_free(&c);
+}
+
+/* 测试符号分析后的预测：4×4稠密矩阵按公式核对；网格矩阵的非零元数与符号结构一致，
+ * 数值分解得到的面板不超过预测的峰值内存；外存模式预测的峰值更小 */
+void test_symbolic_estimate() {
+    pard_csr_matrix_t *dense = NULL;
+    int err = pard_csr_create(&dense, 4, 16);
+    REQUIRE(err == PARD_SUCCESS);
+    for (int i = 0; i < 4; i++) {
+        dense->row_ptr[i] = 4 * i;
+        for (int j = 0; j < 4; j++) {
+            dense->col_idx[4 * i + j] = j;
+            dense->values[4 * i + j] = (i == j) ? 4.0 : -1.0;
+        }
+    }
+    dense->row_ptr[4] = 16;
+    dense->is_symmetric = 1;
+    pard_solver_t *solver = NULL;
+    err = pardiso_init(&solver, PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF, MPI_COMM_NULL);
+    REQUIRE(err == PARD_SUCCESS);
+    err = pardiso_symbolic(solver, dense);
+    REQUIRE(err == PARD_SUCCESS);
+    /* 一个4列超节点：主元与列缩放 4+3+2+1，更新 12+6+2+0；求解 2*16 */
+    CHECK(solver->factor_nnz == 10 && solver->fill_in_nnz == 10);
+    CHECK(solver->factor_flops == 30.0 && solver->solve_flops == 32.0);
+    CHECK(solver->peak_memory >= 2 * 16 * sizeof(double));
+    pardiso_cleanup(&solver);
+    pard_csr_free(&dense);
+    
+    pard_matrix_type_t types[2] = {
+        PARD_MATRIX_TYPE_REAL_SYMMETRIC_POSDEF,
+        PARD_MATRIX_TYPE_REAL_NONSYMMETRIC
+    };
+    double flops[2];
+    for (int t = 0; t < 2; t++) {
+        int is_lu = (types[t] == PARD_MATRIX_TYPE_REAL_NONSYMMETRIC);
+        size_t peak[2];
+        for (int ooc = 0; ooc < 2; ooc++) {
+            pard_csr_matrix_t *matrix = create_grid_2d(30);
+            int n = matrix->n;
+            err = pardiso_init(&solver, types[t], MPI_COMM_NULL);
+            REQUIRE(err == PARD_SUCCESS);
+            if (ooc) {
+                err = pardiso_set_out_of_core(solver, "/tmp", 4096);
+                REQUIRE(err == PARD_SUCCESS);
+            }
+            err = pardiso_symbolic(solver, matrix);
+            REQUIRE(err == PARD_SUCCESS);
+            
+            long long nnz_l = solver->factors->u_row_ptr[n];
+            CHECK(solver->factor_nnz == (is_lu ? 2 * nnz_l - n : nnz_l));
+            CHECK(solver->factor_flops > 0.0 && solver->solve_flops > 0.0);
+            flops[t] = solver->factor_flops;
+            peak[ooc] = solver->peak_memory;
+            
+            err = pardiso_factor(solver);
+            REQUIRE(err == PARD_SUCCESS);
+            double panels = 0.0;
+            for (int s = 0; s < solver->factors->npanels; s++) {
+                const pard_panel_t *P = &solver->factors->panels[s];
+                panels += (double)P->m * P->k * sizeof(double) * (is_lu ? 2 : 1);
+            }
+            CHECK(ooc || panels <= (double)peak[ooc]);
+            
+            pardiso_cleanup(&solver);
+            pard_csr_free(&matrix);
+        }
+        CHECK(peak[1] < peak[0]);
+    }
+    CHECK(flops[1] > flops[0]);
 }
 
 int main(int argc, char **argv) {
@@ -173,13 +960,23 @@ int main(int argc, char **argv) {
     if (rank == 0) {
         printf("Running unit tests...\n\n");
         
-        test_csr_create_free();
-        test_matrix_read();
-        test_ordering();
+        RUN_TEST(test_csr_create_free);
+        RUN_TEST(test_matrix_read);
+        RUN_TEST(test_ordering);
+        RUN_TEST(test_amd_ordering);
+        RUN_TEST(test_nested_dissection);
+        RUN_TEST(test_ordering_options);
+        RUN_TEST(test_elimination_tree);
+        RUN_TEST(test_symbolic_factorization);
+        RUN_TEST(test_supernodes);
+        RUN_TEST(test_csr_spmm);
+        RUN_TEST(test_matrix_read_formats);
+        RUN_TEST(test_matrix_binary);
+        RUN_TEST(test_symbolic_estimate);
         
-        printf("\nAll unit tests completed.\n");
+        printf("\nAll unit tests completed, %d failed checks.\n", test_failures);
     }
     
     MPI_Finalize();
-    return 0;
+    return (test_failures == 0) ? 0 : 1;
 }